@@ -0,0 +1,66 @@
+set(IMAGE_TEST_DIR "${CMAKE_SOURCE_DIR}/tests" CACHE PATH "reference images and input recordings")
+set(IMAGE_TEST_FRAMES 120 CACHE STRING "frames run before the image comparison")
+option(IMAGE_TEST_SOFTWARE_GL "render the image tests and their references with llvmpipe" ON)
+
+# the references are only comparable when rendered by the same driver, mesa picks llvmpipe
+# with these variables and the other drivers ignore them
+if (IMAGE_TEST_SOFTWARE_GL)
+    set(IMAGE_TEST_ENVIRONMENT LIBGL_ALWAYS_SOFTWARE=1 GALLIUM_DRIVER=llvmpipe)
+else()
+    set(IMAGE_TEST_ENVIRONMENT)
+endif()
+
+# replay <directory>/input.rec headless with the extra arguments and compare the last frame
+# with <directory>/reference.png. update_references records the input and writes the
+# reference, the test is added when both files exist
+function(add_image_test_run target name directory)
+    set(args --headless --fixed-rate 60 --frames ${IMAGE_TEST_FRAMES} ${ARGN})
+    set(record "${directory}/input.rec")
+    set(reference "${directory}/reference.png")
+
+    add_custom_command(
+        TARGET update_references
+        POST_BUILD
+        COMMAND ${CMAKE_COMMAND} -E make_directory ${directory}
+        COMMAND ${CMAKE_COMMAND} -E env ${IMAGE_TEST_ENVIRONMENT}
+                $<TARGET_FILE:${target}> ${args}
+                --record ${record} --compare ${reference} --update-reference
+        WORKING_DIRECTORY $<TARGET_FILE_DIR:${target}>
+        COMMENT "update the reference image of ${name}"
+    )
+
+    if (EXISTS ${record} AND EXISTS ${reference})
+        add_test(
+            NAME ${name}
+            COMMAND $<TARGET_FILE:${target}> ${args} --replay ${record} --compare ${reference}
+            WORKING_DIRECTORY $<TARGET_FILE_DIR:${target}>
+        )
+        set_tests_properties(${name} PROPERTIES ENVIRONMENT "${IMAGE_TEST_ENVIRONMENT}")
+    endif()
+endfunction()
+
+# test the project with the files in tests/<target>. a project listing render modes in its
+# IMAGE_TEST_MODES target property gets a test per mode instead, run with --mode <mode>
+# against the files in tests/<target>/<mode>
+function(add_image_test target)
+    if (EMSCRIPTEN)
+        return()
+    endif()
+
+    if (NOT TARGET update_references)
+        add_custom_target(update_references)
+        set_target_properties(update_references PROPERTIES FOLDER "utility")
+    endif()
+    add_dependencies(update_references ${target})
+
+    get_target_property(modes ${target} IMAGE_TEST_MODES)
+    if (NOT modes)
+        add_image_test_run(${target} ${target}_image "${IMAGE_TEST_DIR}/${target}")
+        return()
+    endif()
+
+    foreach (mode ${modes})
+        add_image_test_run(
+            ${target} ${target}_${mode}_image "${IMAGE_TEST_DIR}/${target}/${mode}" --mode ${mode})
+    endforeach()
+endfunction()
\ No newline at end of file
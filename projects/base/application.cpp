@@ -1,12 +1,89 @@
+#include <algorithm>
+#include <filesystem>
+
+#include <stb_image.h>
+#include <stb_image_write.h>
+
 #include "application.h"
+#include "image_compare.h"
+#include "glsl_program.h"
+
+void parseCommonOptions(const CommandLine& commandLine, Options& options) {
+    options.traceFile = commandLine.getString("--trace", options.traceFile);
+    options.traceFrameCount = commandLine.getInt("--trace-frames", options.traceFrameCount);
+    options.traceSkipFrames = commandLine.getInt("--trace-skip", options.traceSkipFrames);
+    options.headless = options.headless || commandLine.hasFlag("--headless");
+    options.frameCount = commandLine.getInt("--frames", options.frameCount);
+    options.recordFile = commandLine.getString("--record", options.recordFile);
+    options.replayFile = commandLine.getString("--replay", options.replayFile);
+    options.benchmarkFile = commandLine.getString("--benchmark", options.benchmarkFile);
+    options.captureFile = commandLine.getString("--capture", options.captureFile);
+    options.compareFile = commandLine.getString("--compare", options.compareFile);
+    options.compareRmseThreshold =
+        commandLine.getFloat("--compare-rmse", options.compareRmseThreshold);
+    options.compareErrorThreshold =
+        commandLine.getFloat("--compare-error", options.compareErrorThreshold);
+    options.updateReference = options.updateReference || commandLine.hasFlag("--update-reference");
+    options.renderMode = commandLine.getString("--mode", options.renderMode);
+    // simulation steps and frames per second, 0 for the frame time and no cap
+    const int fixedRate = commandLine.getInt("--fixed-rate", 0);
+    if (fixedRate > 0) {
+        options.fixedTimestep = 1.0f / fixedRate;
+    }
+    options.maxFrameRate = commandLine.getInt("--max-fps", options.maxFrameRate);
+    options.pipelined = options.pipelined || commandLine.hasFlag("--pipelined");
+}
+
+std::string getDefaultShaderCacheDir() {
+    // the binaries are keyed by the driver and the sources, all the projects share one cache
+    std::error_code error;
+    const std::filesystem::path tempDir = std::filesystem::temp_directory_path(error);
+    if (error) {
+        return "";
+    }
+
+    return (tempDir / "cg_projects" / "shader_cache").string();
+}
 
 Application::Application(const Options& options)
     : _assetRootDir(options.assetRootDir), _windowTitle(options.windowTitle),
       _windowWidth(options.windowWidth), _windowHeight(options.windowHeight),
+      _headless(options.headless), _frameCount(options.frameCount), _recordFile(options.recordFile),
+      _benchmarkFile(options.benchmarkFile), _compareFile(options.compareFile),
+      _compareRmseThreshold(options.compareRmseThreshold),
+      _compareErrorThreshold(options.compareErrorThreshold),
+      _updateReference(options.updateReference), _pipelined(options.pipelined),
+      _fixedTimestep(options.fixedTimestep), _framePacer(options.maxFrameRate),
       _clearColor(options.backgroundColor) {
+    _traceRequest.filePath = options.traceFile.empty() ? "trace.json" : options.traceFile;
+    _traceRequest.frameCount = options.traceFrameCount;
+    _traceRequest.skipFrames = options.traceSkipFrames;
+    _tracePending = !options.traceFile.empty();
+
+    // the hidden window cannot be closed, the frame count is the only way out
+    if (_headless && _frameCount <= 0) {
+        throw std::runtime_error("headless run needs a frame count, pass --frames");
+    }
+
+    if (!_compareFile.empty() && _frameCount <= 0) {
+        throw std::runtime_error("image comparison needs a frame count");
+    }
+
+    if (!options.replayFile.empty()) {
+        _inputRecording.load(options.replayFile);
+        _replayingInput = true;
+    }
+
     // set error callback
     glfwSetErrorCallback(errorCallback);
 
+#ifdef GLFW_PLATFORM_NULL
+    // the hidden window of the headless mode needs no display server
+    if (_headless) {
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    }
+#endif
+
     // init glfw
     if (glfwInit() != GLFW_TRUE) {
         throw std::runtime_error("init glfw failure");
@@ -28,7 +105,21 @@ Application::Application(const Options& options)
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
-    _window = glfwCreateWindow(_windowWidth, _windowHeight, _windowTitle.c_str(), nullptr, nullptr);
+    if (_headless) {
+        // prefer the gpu through egl, osmesa falls back to llvmpipe on the machines without one
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        for (int api : {GLFW_EGL_CONTEXT_API, GLFW_OSMESA_CONTEXT_API}) {
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, api);
+            _window = glfwCreateWindow(
+                _windowWidth, _windowHeight, _windowTitle.c_str(), nullptr, nullptr);
+            if (_window != nullptr) {
+                break;
+            }
+        }
+    } else {
+        _window =
+            glfwCreateWindow(_windowWidth, _windowHeight, _windowTitle.c_str(), nullptr, nullptr);
+    }
 
     if (_window == nullptr) {
         glfwTerminate();
@@ -38,10 +129,13 @@ Application::Application(const Options& options)
     glfwMakeContextCurrent(_window);
     glfwSetWindowUserPointer(_window, this);
 
-    if (options.vSync) {
-        glfwSwapInterval(1);
-    } else {
-        glfwSwapInterval(0);
+    // nothing is presented in the headless mode
+    if (!_headless) {
+        if (options.vSync) {
+            glfwSwapInterval(1);
+        } else {
+            glfwSwapInterval(0);
+        }
     }
 
     // load OpenGL library functions
@@ -55,9 +149,15 @@ Application::Application(const Options& options)
     std::cout << "+ glsl:       " << glGetString(GL_SHADING_LANGUAGE_VERSION) << '\n';
     std::cout << std::endl;
 
+    GLSLProgram::setBinaryCacheDirectory(options.shaderCacheDir, glfwGetProcAddress);
+    GLSLProgram::initParallelCompile(glfwGetProcAddress);
+
     // framebuffer and viewport
     glfwGetFramebufferSize(_window, &_windowWidth, &_windowHeight);
-    glViewport(0, 0, _windowWidth, _windowHeight);
+    if (_headless) {
+        createOffscreenFramebuffer(options.msaa ? 4 : 0);
+    }
+    GLStateCache::viewport(0, 0, _windowWidth, _windowHeight);
 
     if (options.msaa) {
         glEnable(GL_MULTISAMPLE);
@@ -70,12 +170,28 @@ Application::Application(const Options& options)
     glfwSetCursorPosCallback(_window, cursorPosCallback);
     glfwSetScrollCallback(_window, scrollCallback);
 
+    if (!_benchmarkFile.empty()) {
+        _frameTimings = std::make_unique<FrameTimings>();
+    }
+
+    if (!options.captureFile.empty()) {
+        const CaptureFormat format =
+            std::filesystem::path(options.captureFile).extension() == ".y4m" ? CaptureFormat::Y4m
+                                                                             : CaptureFormat::Png;
+        _frameCapture = std::make_unique<FrameCapture>(options.captureFile, format);
+    }
+
     // record time
     _lastTimeStamp = std::chrono::high_resolution_clock::now();
 }
 
 Application::~Application() {
+    _jobSystem.reset();
+
     if (_window != nullptr) {
+        _frameCapture.reset();
+        _frameTimings.reset();
+        destroyOffscreenFramebuffer();
         glfwDestroyWindow(_window);
         _window = nullptr;
     }
@@ -84,13 +200,265 @@ Application::~Application() {
 }
 
 void Application::run() {
-    while (!glfwWindowShouldClose(_window)) {
+    if (_pipelined && !isPipelineSupported()) {
+        std::cerr << "warning: " << _windowTitle
+                  << " does not render from frame packets, --pipelined is ignored" << std::endl;
+        _pipelined = false;
+    }
+
+    if (_pipelined) {
+        runPipelined();
+        finishRun();
+        return;
+    }
+
+    _framePacer.start();
+    for (int frame = 0; !glfwWindowShouldClose(_window); ++frame) {
+        if (_frameCount > 0 && frame == _frameCount) {
+            break;
+        }
+
         updateTime();
+
+        // the replayed input replaces the one of the window in whole
+        if (_replayingInput) {
+            if (!_inputRecording.replay(_input, _deltaTime)) {
+                break;
+            }
+        } else if (!_recordFile.empty()) {
+            _inputRecording.record(_input, _deltaTime);
+        }
+
+        if (_frameTimings != nullptr) {
+            _frameTimings->beginFrame();
+        }
+
+        stepSimulation();
+
+        _inputFrameIndex = frame;
+        _renderFrameIndex = frame;
         handleInput();
-        renderFrame();
+        renderProfiledFrame();
+        finishFrame(frame, _windowWidth, _windowHeight);
 
-        glfwSwapBuffers(_window);
         glfwPollEvents();
+        _framePacer.wait();
+    }
+
+    finishRun();
+}
+
+int Application::getFramePacketIndex(bool render) const {
+    return (render ? _renderFrameIndex : _inputFrameIndex) % framePacketCount;
+}
+
+void Application::runPipelined() {
+    // the context moves to the render thread until the run is over
+    glfwMakeContextCurrent(nullptr);
+    _submittedWidth = _windowWidth;
+    _submittedHeight = _windowHeight;
+    _renderThread = std::thread(&Application::renderLoop, this);
+
+    _framePacer.start();
+    try {
+        for (int frame = 0; !glfwWindowShouldClose(_window); ++frame) {
+            if (_frameCount > 0 && frame == _frameCount) {
+                break;
+            }
+
+            updateTime();
+
+            if (_replayingInput) {
+                if (!_inputRecording.replay(_input, _deltaTime)) {
+                    break;
+                }
+            } else if (!_recordFile.empty()) {
+                _inputRecording.record(_input, _deltaTime);
+            }
+
+            // the packet of this frame was read by the frame before the previous one, which
+            // must be submitted before the packet is written again
+            {
+                std::unique_lock<std::mutex> lock(_pipelineMutex);
+                _pipelineCondition.wait(lock, [this, frame]() {
+                    return _renderedFrameCount >= frame - 1 || _renderThreadError != nullptr;
+                });
+
+                if (_renderThreadError != nullptr) {
+                    break;
+                }
+            }
+
+            stepSimulation();
+
+            _inputFrameIndex = frame;
+            handleInput();
+
+            {
+                std::lock_guard<std::mutex> lock(_pipelineMutex);
+                _submittedFrameCount = frame + 1;
+                _submittedWidth = _windowWidth;
+                _submittedHeight = _windowHeight;
+            }
+            _pipelineCondition.notify_all();
+
+            glfwPollEvents();
+            _framePacer.wait();
+        }
+    } catch (...) {
+        stopRenderThread();
+        throw;
+    }
+
+    stopRenderThread();
+
+    if (_renderThreadError != nullptr) {
+        std::rethrow_exception(_renderThreadError);
+    }
+}
+
+void Application::renderLoop() {
+    glfwMakeContextCurrent(_window);
+
+    // the gpu is kept at most one frame behind the render thread
+    GLsync frameFence = nullptr;
+    int viewportWidth = _windowWidth;
+    int viewportHeight = _windowHeight;
+
+    try {
+        beginRenderThread();
+
+        for (;;) {
+            int frame = 0, width = 0, height = 0;
+            {
+                std::unique_lock<std::mutex> lock(_pipelineMutex);
+                _pipelineCondition.wait(lock, [this]() {
+                    return _renderedFrameCount < _submittedFrameCount || _renderThreadStopped;
+                });
+
+                if (_renderedFrameCount == _submittedFrameCount) {
+                    break;
+                }
+
+                frame = _renderedFrameCount;
+                width = _submittedWidth;
+                height = _submittedHeight;
+            }
+
+            if (width != viewportWidth || height != viewportHeight) {
+                GLStateCache::viewport(0, 0, width, height);
+                viewportWidth = width;
+                viewportHeight = height;
+            }
+
+            if (_frameTimings != nullptr) {
+                _frameTimings->beginFrame();
+            }
+
+            _renderFrameIndex = frame;
+            renderProfiledFrame();
+            finishFrame(frame, width, height);
+
+            GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            waitFence(frameFence);
+            frameFence = fence;
+
+            {
+                std::lock_guard<std::mutex> lock(_pipelineMutex);
+                ++_renderedFrameCount;
+            }
+            _pipelineCondition.notify_all();
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(_pipelineMutex);
+        _renderThreadError = std::current_exception();
+    }
+
+    _pipelineCondition.notify_all();
+
+    if (frameFence != nullptr) {
+        glDeleteSync(frameFence);
+    }
+
+    glfwMakeContextCurrent(nullptr);
+}
+
+void Application::stopRenderThread() {
+    // the frames submitted so far are rendered before the thread returns
+    {
+        std::lock_guard<std::mutex> lock(_pipelineMutex);
+        _renderThreadStopped = true;
+    }
+    _pipelineCondition.notify_all();
+
+    if (_renderThread.joinable()) {
+        _renderThread.join();
+    }
+
+    glfwMakeContextCurrent(_window);
+}
+
+void Application::finishFrame(int frame, int width, int height) {
+    if (!_compareFile.empty() && frame == _frameCount - 1) {
+        compareWithReference(width, height);
+    }
+
+    if (_frameCapture != nullptr) {
+        const GLuint framebuffer = getDefaultFramebuffer();
+        _frameCapture->capture(
+            framebuffer, framebuffer == 0 ? GL_BACK : GL_COLOR_ATTACHMENT0, width, height);
+    }
+
+    if (_frameTimings != nullptr) {
+        _frameTimings->endFrame();
+    }
+
+    if (_headless) {
+        // wait for the gpu in place of the swap so that the frame times include it
+        glFinish();
+    } else {
+        glfwSwapBuffers(_window);
+    }
+}
+
+void Application::finishRun() {
+    if (_headless) {
+        printFrameStatistics();
+    }
+
+    if (_framePacer.getTargetFrameMs() > 0.0) {
+        const double workMs = _framePacer.getMeanWorkMs();
+        const double waitMs = _framePacer.getMeanWaitMs();
+        std::cout << "Frame pacing\n";
+        std::cout << "+ target ms:  " << _framePacer.getTargetFrameMs() << '\n';
+        std::cout << "+ work ms:    " << workMs << '\n';
+        std::cout << "+ wait ms:    " << waitMs << '\n';
+        std::cout << "+ waiting:    " << 100.0 * waitMs / std::max(workMs + waitMs, 1e-9) << "%\n";
+        std::cout << std::endl;
+    }
+
+    if (!_recordFile.empty()) {
+        _inputRecording.save(_recordFile);
+    }
+
+    if (_frameCapture != nullptr) {
+        _frameCapture->finish();
+        std::cout << "Capture\n";
+        std::cout << "+ captured:   " << _frameCapture->getCapturedFrameCount() << '\n';
+        std::cout << "+ dropped:    " << _frameCapture->getDroppedFrameCount() << '\n';
+        std::cout << std::endl;
+    }
+
+    if (_frameTimings != nullptr) {
+        _frameTimings->finish();
+        _frameTimings->printSummary();
+        _frameTimings->save(_benchmarkFile);
+    }
+
+    // e.g. a replay shorter than the frame count
+    if (!_compareFile.empty() && !_compared) {
+        throw std::runtime_error(
+            "image comparison skipped, the run ended before frame " + std::to_string(_frameCount));
     }
 }
 
@@ -98,21 +466,224 @@ std::string Application::getAssetFullPath(const std::string& resourceRelPath) co
     return _assetRootDir + resourceRelPath;
 }
 
+JobSystem& Application::getJobSystem() {
+    if (_jobSystem == nullptr) {
+        _jobSystem.reset(new JobSystem());
+    }
+
+    return *_jobSystem;
+}
+
 void Application::updateTime() {
     auto now = std::chrono::high_resolution_clock::now();
     _deltaTime = 0.001f * std::chrono::duration<float, std::milli>(now - _lastTimeStamp).count();
     _lastTimeStamp = now;
-    if (_deltaTime != 0.0f) {
-        _fpsIndicator.push(1.0f / _deltaTime);
+    _fpsIndicator.push(1000.0f * _deltaTime);
+}
+
+void Application::stepSimulation() {
+    if (_fixedTimestep <= 0.0f) {
+        updateSimulation(_deltaTime);
+        _interpolationAlpha = 1.0f;
+        return;
     }
+
+    // a long stall is dropped instead of being caught up in a burst of steps
+    constexpr int maxStepsPerFrame = 8;
+    _simulationAccumulator =
+        std::min(_simulationAccumulator + _deltaTime, double(maxStepsPerFrame) * _fixedTimestep);
+
+    while (_simulationAccumulator >= _fixedTimestep) {
+        updateSimulation(_fixedTimestep);
+        _simulationAccumulator -= _fixedTimestep;
+    }
+
+    _interpolationAlpha = static_cast<float>(_simulationAccumulator / _fixedTimestep);
 }
 
 void Application::showFpsInWindowTitle() {
     float fps = _fpsIndicator.getAverageFrameRate();
-    std::string detailTitle = _windowTitle + ": " + std::to_string(fps) + " fps";
+    float p99 = _fpsIndicator.getStatistics().p99Ms;
+    std::string detailTitle =
+        _windowTitle + ": " + std::to_string(fps) + " fps, p99 " + std::to_string(p99) + " ms";
     glfwSetWindowTitle(_window, detailTitle.c_str());
 }
 
+void Application::createOffscreenFramebuffer(int samples) {
+    glGenRenderbuffers(1, &_offscreenColorRbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, _offscreenColorRbo);
+    glRenderbufferStorageMultisample(
+        GL_RENDERBUFFER, samples, GL_RGBA8, _windowWidth, _windowHeight);
+
+    glGenRenderbuffers(1, &_offscreenDepthRbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, _offscreenDepthRbo);
+    glRenderbufferStorageMultisample(
+        GL_RENDERBUFFER, samples, GL_DEPTH24_STENCIL8, _windowWidth, _windowHeight);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &_offscreenFbo);
+    GLStateCache::bindFramebuffer(GL_FRAMEBUFFER, _offscreenFbo);
+    glFramebufferRenderbuffer(
+        GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _offscreenColorRbo);
+    glFramebufferRenderbuffer(
+        GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _offscreenDepthRbo);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        throw std::runtime_error("create offscreen framebuffer failure");
+    }
+
+    // the framebuffer stays bound, the passes rendering to the window rebind it on unbind
+    setDefaultFramebuffer(_offscreenFbo);
+}
+
+void Application::destroyOffscreenFramebuffer() {
+    setDefaultFramebuffer(0);
+
+    if (_offscreenFbo != 0) {
+        GLStateCache::deleteFramebuffers(1, &_offscreenFbo);
+        _offscreenFbo = 0;
+    }
+
+    if (_offscreenColorRbo != 0) {
+        glDeleteRenderbuffers(1, &_offscreenColorRbo);
+        _offscreenColorRbo = 0;
+    }
+
+    if (_offscreenDepthRbo != 0) {
+        glDeleteRenderbuffers(1, &_offscreenDepthRbo);
+        _offscreenDepthRbo = 0;
+    }
+}
+
+void Application::printFrameStatistics() const {
+    const FrameRateIndicator::Statistics stats = _fpsIndicator.getStatistics();
+    std::cout << "Frames (last " << _fpsIndicator.getSize() << ")\n";
+    std::cout << "+ avg fps:    " << _fpsIndicator.getAverageFrameRate() << '\n';
+    std::cout << "+ mean ms:    " << stats.meanMs << '\n';
+    std::cout << "+ p50 ms:     " << stats.p50Ms << '\n';
+    std::cout << "+ p95 ms:     " << stats.p95Ms << '\n';
+    std::cout << "+ p99 ms:     " << stats.p99Ms << '\n';
+    std::cout << "+ max ms:     " << stats.maxMs << '\n';
+    std::cout << std::endl;
+}
+
+void Application::compareWithReference(int width, int height) {
+    _compared = true;
+
+    const GLuint framebuffer = getDefaultFramebuffer();
+    const std::vector<uint8_t> rgba = readFramebufferPixels(
+        framebuffer, framebuffer == 0 ? GL_BACK : GL_COLOR_ATTACHMENT0, width, height);
+
+    // the images are stored from the top row
+    std::vector<uint8_t> actual(static_cast<size_t>(width) * height * 3);
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* src = rgba.data() + static_cast<size_t>(height - 1 - y) * width * 4;
+        uint8_t* dst = actual.data() + static_cast<size_t>(y) * width * 3;
+        for (int x = 0; x < width; ++x) {
+            dst[3 * x + 0] = src[4 * x + 0];
+            dst[3 * x + 1] = src[4 * x + 1];
+            dst[3 * x + 2] = src[4 * x + 2];
+        }
+    }
+
+    auto writePng = [width, height](
+                        const std::string& filePath, const std::vector<uint8_t>& image) {
+        if (!stbi_write_png(filePath.c_str(), width, height, 3, image.data(), width * 3)) {
+            throw std::runtime_error("write " + filePath + " failure");
+        }
+    };
+
+    if (_updateReference) {
+        writePng(_compareFile, actual);
+        std::cout << "write reference image " << _compareFile << '\n' << std::endl;
+        return;
+    }
+
+    // the reference is stored from the top row as well, whatever another load asked for
+    stbi_set_flip_vertically_on_load_thread(false);
+    int referenceWidth = 0, referenceHeight = 0, channels = 0;
+    stbi_uc* reference =
+        stbi_load(_compareFile.c_str(), &referenceWidth, &referenceHeight, &channels, 3);
+    if (reference == nullptr) {
+        throw std::runtime_error(
+            "load reference image " + _compareFile
+            + " failure, run with --update-reference to write it");
+    }
+
+    if (referenceWidth != width || referenceHeight != height) {
+        stbi_image_free(reference);
+        throw std::runtime_error(
+            "size of reference image " + _compareFile + " differs from the framebuffer");
+    }
+
+    const ImageDifference difference = compareImages(actual.data(), reference, width, height);
+    stbi_image_free(reference);
+
+    const bool passed = difference.rmse <= _compareRmseThreshold
+                        && difference.meanError <= _compareErrorThreshold;
+
+    std::cout << "Image comparison\n";
+    std::cout << "+ reference:  " << _compareFile << '\n';
+    std::cout << "+ rmse:       " << difference.rmse << '\n';
+    std::cout << "+ mean error: " << difference.meanError << '\n';
+    std::cout << "+ max error:  " << difference.maxError << '\n';
+    std::cout << "+ result:     " << (passed ? "passed" : "failed") << '\n';
+    std::cout << std::endl;
+
+    if (!passed) {
+        const std::string basePath =
+            std::filesystem::path(_compareFile).replace_extension().string();
+        writePng(basePath + "_actual.png", actual);
+        writePng(basePath + "_diff.png", renderErrorMap(difference));
+        throw std::runtime_error(
+            "image comparison failure, see " + basePath + "_actual.png and " + basePath
+            + "_diff.png");
+    }
+}
+
+bool Application::pollTraceRequest(TraceRequest& request) {
+    std::lock_guard<std::mutex> lock(_traceMutex);
+    if (!_tracePending) {
+        return false;
+    }
+
+    request = _traceRequest;
+    _tracePending = false;
+    // the frames are only skipped for the capture at startup
+    _traceRequest.skipFrames = 0;
+
+    return true;
+}
+
+void Application::renderProfiledFrame() {
+    Profiler* profiler = getProfiler();
+
+    TraceRequest request;
+    if (pollTraceRequest(request)) {
+        if (profiler != nullptr) {
+            profiler->startCapture(request.filePath, request.frameCount, request.skipFrames);
+        } else {
+            std::cerr << "warning: " << _windowTitle << " has no profiler, the trace "
+                      << request.filePath << " is not written" << std::endl;
+        }
+    }
+
+    if (profiler == nullptr) {
+        renderFrame();
+        return;
+    }
+
+    profiler->beginFrame();
+    renderFrame();
+
+    const GLStateCache::Counters glCalls = GLStateCache::getCounters();
+    profiler->setCounter("state calls issued", static_cast<double>(glCalls.issued));
+    profiler->setCounter("state calls skipped", static_cast<double>(glCalls.skipped));
+    GLStateCache::resetCounters();
+
+    profiler->endFrame();
+}
+
 void Application::errorCallback(int error, const char* description) {
     std::cerr << description << std::endl;
 }
@@ -122,7 +693,10 @@ void Application::framebufferResizeCallback(GLFWwindow* window, int width, int h
     app->_windowWidth = width;
     app->_windowHeight = height;
     app->_windowReized = true;
-    glViewport(0, 0, width, height);
+    // the main thread has no context in the pipelined mode, the render thread sets the viewport
+    if (!app->_pipelined) {
+        GLStateCache::viewport(0, 0, width, height);
+    }
 }
 
 void Application::cursorPosCallback(GLFWwindow* window, double xPos, double yPos) {
@@ -159,4 +733,10 @@ void Application::keyCallback(GLFWwindow* window, int key, int scancode, int act
         Application* app = reinterpret_cast<Application*>(glfwGetWindowUserPointer(window));
         app->_input.keyboard.keyStates[key] = action;
     }
+
+    if (key == GLFW_KEY_F12 && action == GLFW_PRESS) {
+        Application* app = reinterpret_cast<Application*>(glfwGetWindowUserPointer(window));
+        std::lock_guard<std::mutex> lock(app->_traceMutex);
+        app->_tracePending = true;
+    }
 }
\ No newline at end of file
@@ -1,17 +1,29 @@
 #pragma once
 
 #include <chrono>
+#include <condition_variable>
+#include <exception>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
+#include <thread>
 
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 
+#include "command_line.h"
+#include "frame_capture.h"
+#include "frame_pacer.h"
 #include "frame_rate_indicator.h"
+#include "frame_timings.h"
 #include "gl_utility.h"
 #include "input.h"
+#include "input_recording.h"
+#include "job_system.h"
+#include "profiler.h"
 
 struct Options {
     std::string assetRootDir;
@@ -23,6 +35,64 @@ struct Options {
     bool msaa;
     std::pair<int, int> glVersion;
     glm::vec4 backgroundColor;
+    // directory of the program binary cache, empty to compile all shaders at startup.
+    // see getDefaultShaderCacheDir
+    std::string shaderCacheDir;
+    // profiler trace of traceFrameCount frames after the first traceSkipFrames frames,
+    // empty to capture a trace only when F12 is pressed
+    std::string traceFile;
+    int traceFrameCount = 300;
+    int traceSkipFrames = 0;
+    // render into an offscreen framebuffer of the window size without showing the window,
+    // the context is created through egl or osmesa so that no display is needed.
+    // it needs a frame count, nothing else can end the run
+    bool headless = false;
+    // exit after frameCount frames, 0 to run until the window is closed
+    int frameCount = 0;
+    // save the input and delta time of every frame to recordFile, or drive the run by the
+    // ones of replayFile so that runs of different builds are comparable
+    std::string recordFile;
+    std::string replayFile;
+    // per frame cpu and gpu times with a summary, in json for a .json file and csv otherwise
+    std::string benchmarkFile;
+    // capture every frame as a y4m video for a .y4m file and as png files in the
+    // directory otherwise, the readback runs asynchronously
+    std::string captureFile;
+    // compare the last of frameCount frames with the reference png compareFile. the run fails
+    // when either error exceeds its threshold, when the reference is missing or when the run
+    // ends before the last frame. updateReference writes the reference instead
+    std::string compareFile;
+    float compareRmseThreshold = 0.02f;
+    float compareErrorThreshold = 0.05f;
+    bool updateReference = false;
+    // prepare the next frame in handleInput on the main thread while a render thread owning
+    // the context submits the current one in renderFrame. the application keeps the opengl
+    // calls out of handleInput and hands each frame over in a packet, see getFramePacketIndex
+    bool pipelined = false;
+    // advance the simulation in steps of fixedTimestep seconds, interpolating the rendered
+    // state between the last two steps. 0 to step once per frame by the frame time
+    float fixedTimestep = 0.0f;
+    // frames per second cap, 0 for none
+    int maxFrameRate = 0;
+    // initial render mode of the projects having several, so that a run such as an image
+    // test can pick one. empty for the default, the projects without modes ignore it
+    std::string renderMode;
+};
+
+// read the options shared by all the projects: --trace, --trace-frames, --trace-skip,
+// --headless, --frames, --record, --replay, --benchmark, --capture, --compare,
+// --compare-rmse, --compare-error, --update-reference, --fixed-rate, --max-fps, --pipelined
+// and --mode. call it after setting the project defaults, the flags not given keep them
+void parseCommonOptions(const CommandLine& commandLine, Options& options);
+
+// the program binary cache of the user, independent of the working directory. empty when
+// the system has no temporary directory
+std::string getDefaultShaderCacheDir();
+
+struct TraceRequest {
+    std::string filePath;
+    int frameCount = 0;
+    int skipFrames = 0;
 };
 
 class Application {
@@ -48,10 +118,61 @@ protected:
     int _windowHeight = 0;
     bool _windowReized = false;
 
+    /* offscreen framebuffer standing in for the window one in the headless mode */
+    bool _headless = false;
+    int _frameCount = 0;
+    GLuint _offscreenFbo = 0;
+    GLuint _offscreenColorRbo = 0;
+    GLuint _offscreenDepthRbo = 0;
+
+    /* input record and replay for the benchmark runs */
+    InputRecording _inputRecording;
+    std::string _recordFile;
+    bool _replayingInput = false;
+    std::string _benchmarkFile;
+    std::unique_ptr<FrameTimings> _frameTimings;
+
+    /* asynchronous capture of the rendered frames */
+    std::unique_ptr<FrameCapture> _frameCapture;
+
+    /* comparison of the last frame with a reference image */
+    std::string _compareFile;
+    float _compareRmseThreshold = 0.0f;
+    float _compareErrorThreshold = 0.0f;
+    bool _updateReference = false;
+    // set by the frame compared, which runs on the render thread in the pipelined mode
+    bool _compared = false;
+
+    /* pipelined mode, the render thread runs at most one frame behind the main thread */
+    bool _pipelined = false;
+    std::thread _renderThread;
+    std::mutex _pipelineMutex;
+    std::condition_variable _pipelineCondition;
+    int _submittedFrameCount = 0;
+    int _renderedFrameCount = 0;
+    bool _renderThreadStopped = false;
+    std::exception_ptr _renderThreadError;
+    // window size when the last frame was submitted, applied on the render thread
+    int _submittedWidth = 0;
+    int _submittedHeight = 0;
+
+    /* the frames handleInput and renderFrame are working on, the same one when not pipelined */
+    int _inputFrameIndex = 0;
+    int _renderFrameIndex = 0;
+
     /* timer for fps */
     std::chrono::time_point<std::chrono::high_resolution_clock> _lastTimeStamp;
     float _deltaTime = 0.0f;
-    FrameRateIndicator _fpsIndicator{64};
+    FrameRateIndicator _fpsIndicator{256};
+
+    /* fixed timestep simulation, the rendered state is blended from the previous step to
+       the current one by _interpolationAlpha in [0, 1] */
+    float _fixedTimestep = 0.0f;
+    double _simulationAccumulator = 0.0;
+    float _interpolationAlpha = 1.0f;
+
+    /* frame rate cap and the work and wait times of the frames */
+    FramePacer _framePacer;
 
     /* input handler */
     Input _input;
@@ -59,18 +180,84 @@ protected:
     /* clear color */
     glm::vec4 _clearColor = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
 
+    /* trace capture requested by the options or the F12 key, the key callback runs on the
+       main thread and the request is polled on the thread rendering */
+    std::mutex _traceMutex;
+    TraceRequest _traceRequest;
+    bool _tracePending = false;
+
+    /* created by getJobSystem */
+    std::unique_ptr<JobSystem> _jobSystem;
+
     std::string getAssetFullPath(const std::string& resourceRelPath) const;
 
+    /* thread pool shared by the asset loader and the jobs of the project, created by the first
+       call so that the projects not using it start no thread. it is drained and destroyed
+       with the application, the derived class must stop scheduling into it before */
+    JobSystem& getJobSystem();
+
     void updateTime();
 
+    void stepSimulation();
+
     /* derived class can override this function to handle input */
     virtual void handleInput() = 0;
 
     /* derived class can override this function to render a frame */
     virtual void renderFrame() = 0;
 
+    /* derived class can override this function to advance the simulation by dt seconds,
+       it runs on the main thread before handleInput */
+    virtual void updateSimulation(float /*dt*/) {}
+
+    /* derived class can override this function to take over the per thread state of the
+       render thread in the pipelined mode, it runs there before the first frame */
+    virtual void beginRenderThread() {}
+
+    /* derived class can override this function to return its profiler, the application
+       then runs each renderFrame in a profiler frame and starts the trace captures */
+    virtual Profiler* getProfiler() {
+        return nullptr;
+    }
+
+    /* derived class returns true when renderFrame only reads the frame packets, the
+       pipelined mode falls back to the serial loop otherwise */
+    virtual bool isPipelineSupported() const {
+        return false;
+    }
+
+    /* number of the frame packets and the packet of the frame of handleInput or renderFrame,
+       handleInput writes a packet which renderFrame reads while the next one is written */
+    static constexpr int framePacketCount = 2;
+
+    int getFramePacketIndex(bool render) const;
+
     void showFpsInWindowTitle();
 
+    void createOffscreenFramebuffer(int samples);
+
+    void destroyOffscreenFramebuffer();
+
+    void printFrameStatistics() const;
+
+    void compareWithReference(int width, int height);
+
+    void runPipelined();
+
+    void renderLoop();
+
+    void stopRenderThread();
+
+    /* everything after renderFrame up to the swap */
+    void finishFrame(int frame, int width, int height);
+
+    void finishRun();
+
+    bool pollTraceRequest(TraceRequest& request);
+
+    /* renderFrame in a frame of the profiler of the derived class, if any */
+    void renderProfiledFrame();
+
     static void errorCallback(int error, const char* description);
 
     static void framebufferResizeCallback(GLFWwindow* window, int width, int height);
@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "asset_loader.h"
+
+// at most this many parsed assets wait for their upload, workers block beyond it
+static constexpr size_t uploadQueueCapacity = 256;
+
+AssetLoader::AssetLoader(JobSystem& jobSystem)
+    : _jobSystem(jobSystem), _uploads(uploadQueueCapacity) {}
+
+AssetLoader::~AssetLoader() {
+    // the jobs not started yet skip the parsing, the running ones give up on the upload queue
+    _stopped.store(true);
+
+    std::vector<JobSystem::Handle> jobs;
+    {
+        std::lock_guard<std::mutex> lock(_jobMutex);
+        jobs.swap(_jobs);
+    }
+
+    for (const auto& job : jobs) {
+        _jobSystem.wait(job);
+    }
+
+    // the assets waiting for upload are dropped, their handles stay in the loading state
+    std::function<void()> upload;
+    while (_uploads.tryPop(upload)) {
+        upload = nullptr;
+    }
+
+    _stageUploads.clear();
+}
+
+void AssetLoader::processUploads(double budgetMs) {
+    const auto start = std::chrono::steady_clock::now();
+
+    // the started assets are finished first
+    std::function<void()> upload;
+    for (;;) {
+        if (!_stageUploads.empty()) {
+            upload = std::move(_stageUploads.front());
+            _stageUploads.pop_front();
+        } else if (!_uploads.tryPop(upload)) {
+            break;
+        }
+
+        upload();
+        upload = nullptr;
+
+        const std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+        if (elapsed.count() >= budgetMs) {
+            break;
+        }
+    }
+}
+
+size_t AssetLoader::getPendingCount() const {
+    return _pendingCount.load(std::memory_order_relaxed);
+}
+
+void AssetLoader::submit(std::function<void()> job) {
+    JobSystem::Handle handle = _jobSystem.schedule(
+        [this, job]() {
+            if (!_stopped.load()) {
+                job();
+            }
+        },
+        "asset parse");
+
+    std::lock_guard<std::mutex> lock(_jobMutex);
+    _jobs.erase(
+        std::remove_if(
+            _jobs.begin(), _jobs.end(), [](const JobSystem::Handle& h) { return h.finished(); }),
+        _jobs.end());
+    _jobs.push_back(std::move(handle));
+}
+
+void AssetLoader::enqueueUpload(std::function<void()> upload) {
+    // wait for the opengl thread to make room, give up when the loader is destroyed
+    while (!_uploads.tryPush(std::move(upload))) {
+        if (_stopped.load()) {
+            return;
+        }
+
+        std::this_thread::yield();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "job_system.h"
+#include "mpmc_queue.h"
+
+enum class AssetState : int {
+    Loading = 0,
+    Ready,
+    Failed
+};
+
+// shared reference to an asset which is loaded in the background,
+// the asset can be used once ready() returns true
+template <typename T>
+class AssetHandle {
+public:
+    AssetHandle() = default;
+
+    bool valid() const {
+        return _slot != nullptr;
+    }
+
+    AssetState getState() const {
+        return _slot ? _slot->state.load(std::memory_order_acquire) : AssetState::Failed;
+    }
+
+    bool ready() const {
+        return getState() == AssetState::Ready;
+    }
+
+    bool failed() const {
+        return getState() == AssetState::Failed;
+    }
+
+    // nullptr until the asset is ready
+    T* get() const {
+        return ready() ? _slot->asset.get() : nullptr;
+    }
+
+    T* operator->() const {
+        return get();
+    }
+
+    // the reason of the failure, only valid when failed() returns true
+    const std::string& getError() const {
+        return _slot->error;
+    }
+
+private:
+    struct Slot {
+        std::atomic<AssetState> state{AssetState::Loading};
+        std::unique_ptr<T> asset;
+        std::string error;
+    };
+
+    std::shared_ptr<Slot> _slot;
+
+    friend class AssetLoader;
+};
+
+// load assets in two steps: the file io and parsing run as jobs of the job system, the
+// results are handed to the opengl thread through a lock-free queue and turned into
+// gpu resources by processUploads, which the application calls once per frame
+class AssetLoader {
+public:
+    // the job system must outlive the loader
+    AssetLoader(JobSystem& jobSystem);
+
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // parse() runs on a worker thread and returns the cpu side data of the asset,
+    // upload(data) runs on the opengl thread and returns std::unique_ptr<T>.
+    // both may throw, the exception message is kept in the handle.
+    template <typename T, typename Parse, typename Upload>
+    AssetHandle<T> load(Parse parse, Upload upload);
+
+    // the same with the stages run in order on the opengl thread after upload(data), each as
+    // an upload of its own, so that a long gpu preparation is spread over the frames.
+    // the asset is ready once the last stage is done
+    template <typename T, typename Parse, typename Upload>
+    AssetHandle<T> load(Parse parse, Upload upload, std::vector<std::function<void(T&)>> stages);
+
+    // run the queued uploads until budgetMs is spent, at least one upload runs per call
+    // so a single upload longer than the budget cannot stall the loading
+    void processUploads(double budgetMs);
+
+    // the number of assets neither ready nor failed
+    size_t getPendingCount() const;
+
+private:
+    JobSystem& _jobSystem;
+
+    // the parse jobs in flight, waited for on destruction since they refer to the loader
+    std::vector<JobSystem::Handle> _jobs;
+    std::mutex _jobMutex;
+    std::atomic<bool> _stopped{false};
+
+    MPMCQueue<std::function<void()>> _uploads;
+
+    // the next stages of the staged assets, only touched on the opengl thread
+    std::deque<std::function<void()>> _stageUploads;
+
+    std::atomic<size_t> _pendingCount{0};
+
+    void submit(std::function<void()> job);
+
+    void enqueueUpload(std::function<void()> upload);
+
+    template <typename Slot>
+    void fail(Slot& slot, const std::string& error);
+
+    template <typename T, typename Slot>
+    void runStages(
+        std::shared_ptr<Slot> slot,
+        std::shared_ptr<const std::vector<std::function<void(T&)>>> stages, size_t index);
+};
+
+template <typename T, typename Parse, typename Upload>
+AssetHandle<T> AssetLoader::load(Parse parse, Upload upload) {
+    return load<T>(std::move(parse), std::move(upload), {});
+}
+
+template <typename T, typename Parse, typename Upload>
+AssetHandle<T> AssetLoader::load(
+    Parse parse, Upload upload, std::vector<std::function<void(T&)>> stages) {
+    using Slot = typename AssetHandle<T>::Slot;
+    using Stages = std::vector<std::function<void(T&)>>;
+
+    AssetHandle<T> handle;
+    handle._slot = std::make_shared<Slot>();
+    _pendingCount.fetch_add(1, std::memory_order_relaxed);
+
+    std::shared_ptr<Slot> slot = handle._slot;
+    std::shared_ptr<const Stages> sharedStages = std::make_shared<Stages>(std::move(stages));
+    submit([this, slot, parse, upload, sharedStages]() {
+        using Data = decltype(parse());
+        std::shared_ptr<Data> data;
+        try {
+            data = std::make_shared<Data>(parse());
+        } catch (const std::exception& e) {
+            fail(*slot, e.what());
+            return;
+        }
+
+        enqueueUpload([this, slot, data, upload, sharedStages]() {
+            try {
+                slot->asset = upload(*data);
+            } catch (const std::exception& e) {
+                fail(*slot, e.what());
+                return;
+            }
+
+            runStages<T>(slot, sharedStages, 0);
+        });
+    });
+
+    return handle;
+}
+
+template <typename T, typename Slot>
+void AssetLoader::runStages(
+    std::shared_ptr<Slot> slot, std::shared_ptr<const std::vector<std::function<void(T&)>>> stages,
+    size_t index) {
+    if (index == stages->size()) {
+        slot->state.store(AssetState::Ready, std::memory_order_release);
+        _pendingCount.fetch_sub(1, std::memory_order_relaxed);
+        return;
+    }
+
+    _stageUploads.push_back([this, slot, stages, index]() {
+        try {
+            (*stages)[index](*slot->asset);
+        } catch (const std::exception& e) {
+            fail(*slot, e.what());
+            return;
+        }
+
+        runStages<T>(slot, stages, index + 1);
+    });
+}
+
+template <typename Slot>
+void AssetLoader::fail(Slot& slot, const std::string& error) {
+    slot.error = error;
+    slot.state.store(AssetState::Failed, std::memory_order_release);
+    _pendingCount.fetch_sub(1, std::memory_order_relaxed);
+}
\ No newline at end of file
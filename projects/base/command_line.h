@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// arguments of the form "--name value" or "--name"
+class CommandLine {
+public:
+    CommandLine(int argc, char* argv[]) : _args(argv + (argc > 0 ? 1 : 0), argv + argc) {}
+
+    bool hasFlag(const std::string& name) const {
+        return find(name) != _args.size();
+    }
+
+    std::string getString(const std::string& name, const std::string& defaultValue) const {
+        const size_t index = find(name);
+        if (index + 1 >= _args.size()) {
+            return defaultValue;
+        }
+
+        return _args[index + 1];
+    }
+
+    int getInt(const std::string& name, int defaultValue) const {
+        const std::string value = getString(name, "");
+        if (value.empty()) {
+            return defaultValue;
+        }
+
+        char* end = nullptr;
+        const long result = std::strtol(value.c_str(), &end, 10);
+        if (*end != '\0') {
+            std::cerr << "invalid value " + value + " of " + name << std::endl;
+            return defaultValue;
+        }
+
+        return static_cast<int>(result);
+    }
+
+    float getFloat(const std::string& name, float defaultValue) const {
+        const std::string value = getString(name, "");
+        if (value.empty()) {
+            return defaultValue;
+        }
+
+        char* end = nullptr;
+        const float result = std::strtof(value.c_str(), &end);
+        if (*end != '\0') {
+            std::cerr << "invalid value " + value + " of " + name << std::endl;
+            return defaultValue;
+        }
+
+        return result;
+    }
+
+private:
+    std::vector<std::string> _args;
+
+    size_t find(const std::string& name) const {
+        for (size_t i = 0; i < _args.size(); ++i) {
+            if (_args[i] == name) {
+                return i;
+            }
+        }
+
+        return _args.size();
+    }
+};
\ No newline at end of file
@@ -0,0 +1,391 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+#include <stb_image_write.h>
+
+#include "frame_capture.h"
+
+namespace {
+// frames waiting for the encoder before the next ones are dropped
+constexpr size_t maxQueuedFrames = 8;
+
+uint8_t clampByte(int value) {
+    return static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+}
+}  // namespace
+
+std::vector<uint8_t> readFramebufferPixels(
+    GLuint framebuffer, GLenum readBuffer, int width, int height) {
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+
+    GLint lastReadFramebuffer = 0, lastDrawFramebuffer = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &lastReadFramebuffer);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &lastDrawFramebuffer);
+
+    GLStateCache::bindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    GLint lastReadBuffer = GL_NONE;
+    glGetIntegerv(GL_READ_BUFFER, &lastReadBuffer);
+    glReadBuffer(readBuffer);
+
+    GLint sampleBuffers = 0;
+    glGetIntegerv(GL_SAMPLE_BUFFERS, &sampleBuffers);
+
+    // the multisampled framebuffers are resolved into a temporary one first
+    GLuint resolveFbo = 0, resolveRbo = 0;
+    if (sampleBuffers != 0) {
+        glGenRenderbuffers(1, &resolveRbo);
+        glBindRenderbuffer(GL_RENDERBUFFER, resolveRbo);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glGenFramebuffers(1, &resolveFbo);
+        GLStateCache::bindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFbo);
+        glFramebufferRenderbuffer(
+            GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, resolveRbo);
+        glBlitFramebuffer(
+            0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+        glReadBuffer(lastReadBuffer);
+        GLStateCache::bindFramebuffer(GL_READ_FRAMEBUFFER, resolveFbo);
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+    }
+
+    // the rows are packed tightly, the alignment of the caller is restored after
+    GLint lastPackAlignment = 4;
+    glGetIntegerv(GL_PACK_ALIGNMENT, &lastPackAlignment);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, lastPackAlignment);
+
+    if (resolveFbo != 0) {
+        GLStateCache::deleteFramebuffers(1, &resolveFbo);
+        glDeleteRenderbuffers(1, &resolveRbo);
+    } else {
+        glReadBuffer(lastReadBuffer);
+    }
+
+    GLStateCache::bindFramebuffer(GL_READ_FRAMEBUFFER, lastReadFramebuffer);
+    GLStateCache::bindFramebuffer(GL_DRAW_FRAMEBUFFER, lastDrawFramebuffer);
+
+    return pixels;
+}
+
+FrameCapture::FrameCapture(
+    const std::string& path, CaptureFormat format, int framesPerSecond, uint32_t latency)
+    : _path(path), _format(format), _framesPerSecond(framesPerSecond),
+      _slots(std::max(1u, latency)) {
+    if (_format == CaptureFormat::Png) {
+        std::error_code error;
+        std::filesystem::create_directories(_path, error);
+        if (error) {
+            throw std::runtime_error("create capture directory " + _path + " failure");
+        }
+    } else {
+        _video.open(_path, std::ios::binary);
+        if (!_video) {
+            throw std::runtime_error("open " + _path + " failure");
+        }
+    }
+
+    _encoder = std::thread(&FrameCapture::encoderLoop, this);
+}
+
+FrameCapture::~FrameCapture() {
+    finish();
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopped = true;
+    }
+
+    _jobCondition.notify_all();
+    _encoder.join();
+
+    for (auto& slot : _slots) {
+        if (slot.fence != nullptr) {
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+        }
+
+        if (slot.pbo != 0) {
+            glDeleteBuffers(1, &slot.pbo);
+            slot.pbo = 0;
+        }
+    }
+
+    if (_resolveFbo != 0) {
+        GLStateCache::deleteFramebuffers(1, &_resolveFbo);
+        _resolveFbo = 0;
+    }
+
+    if (_resolveRbo != 0) {
+        glDeleteRenderbuffers(1, &_resolveRbo);
+        _resolveRbo = 0;
+    }
+}
+
+void FrameCapture::capture(GLuint framebuffer, GLenum readBuffer, int width, int height) {
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
+    // the slot was filled latency frames ago, its copy is done by now in practice
+    Slot& slot = _slots[_slotIndex];
+    if (slot.pending) {
+        readBack(slot, false);
+    }
+
+    GLint lastReadFramebuffer = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &lastReadFramebuffer);
+
+    const GLuint source = resolve(framebuffer, readBuffer, width, height);
+    GLStateCache::bindFramebuffer(GL_READ_FRAMEBUFFER, source);
+    GLint lastReadBuffer = GL_NONE;
+    glGetIntegerv(GL_READ_BUFFER, &lastReadBuffer);
+    glReadBuffer(source == framebuffer ? readBuffer : GL_COLOR_ATTACHMENT0);
+
+    const size_t size = static_cast<size_t>(width) * height * 4;
+    if (slot.pbo == 0) {
+        glGenBuffers(1, &slot.pbo);
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    if (slot.size != size) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        slot.size = size;
+    }
+
+    // the copy into the buffer object is queued like a draw, nothing waits for it here
+    GLint lastPackAlignment = 4;
+    glGetIntegerv(GL_PACK_ALIGNMENT, &lastPackAlignment);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glPixelStorei(GL_PACK_ALIGNMENT, lastPackAlignment);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    glReadBuffer(lastReadBuffer);
+    GLStateCache::bindFramebuffer(GL_READ_FRAMEBUFFER, lastReadFramebuffer);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.frameIndex = _frameIndex++;
+    slot.width = width;
+    slot.height = height;
+    slot.pending = true;
+
+    _slotIndex = (_slotIndex + 1) % static_cast<uint32_t>(_slots.size());
+}
+
+void FrameCapture::finish() {
+    // the oldest frame is in the slot to be filled next
+    for (size_t i = 0; i < _slots.size(); ++i) {
+        Slot& slot = _slots[(_slotIndex + i) % _slots.size()];
+        if (slot.pending) {
+            readBack(slot, true);
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idleCondition.wait(lock, [this]() { return _jobs.empty() && !_encoding; });
+}
+
+uint64_t FrameCapture::getCapturedFrameCount() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _capturedFrameCount;
+}
+
+uint64_t FrameCapture::getDroppedFrameCount() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _droppedFrameCount;
+}
+
+GLuint FrameCapture::resolve(GLuint framebuffer, GLenum readBuffer, int width, int height) {
+    GLStateCache::bindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    GLint sampleBuffers = 0;
+    glGetIntegerv(GL_SAMPLE_BUFFERS, &sampleBuffers);
+    if (sampleBuffers == 0) {
+        return framebuffer;
+    }
+
+    if (_resolveFbo == 0) {
+        glGenFramebuffers(1, &_resolveFbo);
+        glGenRenderbuffers(1, &_resolveRbo);
+    }
+
+    GLint lastDrawFramebuffer = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &lastDrawFramebuffer);
+    GLStateCache::bindFramebuffer(GL_DRAW_FRAMEBUFFER, _resolveFbo);
+
+    if (_resolveWidth != width || _resolveHeight != height) {
+        glBindRenderbuffer(GL_RENDERBUFFER, _resolveRbo);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glFramebufferRenderbuffer(
+            GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _resolveRbo);
+        _resolveWidth = width;
+        _resolveHeight = height;
+    }
+
+    GLint lastReadBuffer = GL_NONE;
+    glGetIntegerv(GL_READ_BUFFER, &lastReadBuffer);
+    glReadBuffer(readBuffer);
+    glBlitFramebuffer(
+        0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glReadBuffer(lastReadBuffer);
+
+    GLStateCache::bindFramebuffer(GL_DRAW_FRAMEBUFFER, lastDrawFramebuffer);
+
+    return _resolveFbo;
+}
+
+void FrameCapture::readBack(Slot& slot, bool wait) {
+    waitFence(slot.fence);
+    slot.pending = false;
+
+    std::vector<uint8_t> pixels;
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (wait) {
+            _idleCondition.wait(lock, [this]() { return _jobs.size() < maxQueuedFrames; });
+        } else if (_jobs.size() >= maxQueuedFrames) {
+            ++_droppedFrameCount;
+            return;
+        }
+
+        if (!_freeBuffers.empty()) {
+            pixels = std::move(_freeBuffers.back());
+            _freeBuffers.pop_back();
+        }
+    }
+
+    pixels.resize(slot.size);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.size, GL_MAP_READ_BIT);
+    if (data != nullptr) {
+        std::memcpy(pixels.data(), data, slot.size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (data == nullptr) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ++_droppedFrameCount;
+        return;
+    }
+
+    EncodeJob job;
+    job.frameIndex = slot.frameIndex;
+    job.width = slot.width;
+    job.height = slot.height;
+    job.pixels = std::move(pixels);
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _jobs.push_back(std::move(job));
+    }
+
+    _jobCondition.notify_one();
+}
+
+void FrameCapture::encoderLoop() {
+    for (;;) {
+        EncodeJob job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _jobCondition.wait(lock, [this]() { return _stopped || !_jobs.empty(); });
+            if (_jobs.empty()) {
+                return;
+            }
+
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+            _encoding = true;
+        }
+
+        bool encoded = true;
+        try {
+            encode(job);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            encoded = false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            encoded ? ++_capturedFrameCount : ++_droppedFrameCount;
+            _freeBuffers.push_back(std::move(job.pixels));
+            _encoding = false;
+        }
+
+        _idleCondition.notify_all();
+    }
+}
+
+void FrameCapture::encode(const EncodeJob& job) {
+    switch (_format) {
+    case CaptureFormat::Png: writePng(job); break;
+    case CaptureFormat::Y4m: writeY4m(job); break;
+    }
+}
+
+void FrameCapture::writePng(const EncodeJob& job) {
+    // drop the alpha, which holds whatever the passes left in it, and flip the rows
+    std::vector<uint8_t> rgb(static_cast<size_t>(job.width) * job.height * 3);
+    for (int y = 0; y < job.height; ++y) {
+        const uint8_t* src =
+            job.pixels.data() + static_cast<size_t>(job.height - 1 - y) * job.width * 4;
+        uint8_t* dst = rgb.data() + static_cast<size_t>(y) * job.width * 3;
+        for (int x = 0; x < job.width; ++x) {
+            dst[3 * x + 0] = src[4 * x + 0];
+            dst[3 * x + 1] = src[4 * x + 1];
+            dst[3 * x + 2] = src[4 * x + 2];
+        }
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%06llu.png", (unsigned long long)job.frameIndex);
+    const std::string filePath = (std::filesystem::path(_path) / name).string();
+    if (!stbi_write_png(filePath.c_str(), job.width, job.height, 3, rgb.data(), job.width * 3)) {
+        throw std::runtime_error("write " + filePath + " failure");
+    }
+}
+
+void FrameCapture::writeY4m(const EncodeJob& job) {
+    if (_videoWidth == 0) {
+        _videoWidth = job.width;
+        _videoHeight = job.height;
+        _video << "YUV4MPEG2 W" << _videoWidth << " H" << _videoHeight << " F" << _framesPerSecond
+               << ":1 Ip A1:1 C444\n";
+    } else if (job.width != _videoWidth || job.height != _videoHeight) {
+        throw std::runtime_error(
+            "frame " + std::to_string(job.frameIndex) + " does not match the video size");
+    }
+
+    // bt.601 limited range planes, the rows flipped to top down
+    const size_t planeSize = static_cast<size_t>(job.width) * job.height;
+    _yuv.resize(3 * planeSize);
+    uint8_t* yPlane = _yuv.data();
+    uint8_t* uPlane = yPlane + planeSize;
+    uint8_t* vPlane = uPlane + planeSize;
+    for (int y = 0; y < job.height; ++y) {
+        const uint8_t* src =
+            job.pixels.data() + static_cast<size_t>(job.height - 1 - y) * job.width * 4;
+        const size_t row = static_cast<size_t>(y) * job.width;
+        for (int x = 0; x < job.width; ++x) {
+            const int r = src[4 * x + 0], g = src[4 * x + 1], b = src[4 * x + 2];
+            yPlane[row + x] = clampByte(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+            uPlane[row + x] = clampByte(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            vPlane[row + x] = clampByte(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+
+    _video << "FRAME\n";
+    _video.write(reinterpret_cast<const char*>(_yuv.data()), _yuv.size());
+    if (!_video) {
+        throw std::runtime_error("write " + _path + " failure");
+    }
+}
\ No newline at end of file
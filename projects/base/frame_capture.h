@@ -0,0 +1,117 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gl_utility.h"
+
+enum class CaptureFormat {
+    // one png file per frame in the capture directory
+    Png,
+    // a single uncompressed yuv 4:4:4 video
+    Y4m
+};
+
+// read a color buffer synchronously as rgba8 rows from the bottom up. it waits for the gpu,
+// which is fine for a single frame such as the one of an image comparison
+std::vector<uint8_t> readFramebufferPixels(
+    GLuint framebuffer, GLenum readBuffer, int width, int height);
+
+// capture the rendered frames without stalling the pipeline. each frame is read into a ring
+// of pixel buffer objects and mapped latency frames later, when the copy is done, then the
+// pixels are handed to a background thread for encoding. when the encoder falls behind the
+// frames are dropped instead of blocking the rendering.
+class FrameCapture {
+public:
+    // png captures write path/frame_000000.png and on, y4m captures write the video to path
+    FrameCapture(
+        const std::string& path, CaptureFormat format, int framesPerSecond = 60,
+        uint32_t latency = 3);
+
+    FrameCapture(const FrameCapture&) = delete;
+
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    ~FrameCapture();
+
+    // queue the readback of the color buffer readBuffer of framebuffer, 0 for the window one.
+    // call it once per frame after the frame is rendered
+    void capture(GLuint framebuffer, GLenum readBuffer, int width, int height);
+
+    // encode the frames still in flight and wait for the encoder
+    void finish();
+
+    uint64_t getCapturedFrameCount() const;
+
+    uint64_t getDroppedFrameCount() const;
+
+private:
+    struct Slot {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        size_t size = 0;
+        uint64_t frameIndex = 0;
+        int width = 0;
+        int height = 0;
+        bool pending = false;
+    };
+
+    struct EncodeJob {
+        uint64_t frameIndex = 0;
+        int width = 0;
+        int height = 0;
+        // rgba8 rows from the bottom up as read by opengl
+        std::vector<uint8_t> pixels;
+    };
+
+    std::string _path;
+    CaptureFormat _format;
+    int _framesPerSecond;
+
+    std::vector<Slot> _slots;
+    uint32_t _slotIndex = 0;
+    uint64_t _frameIndex = 0;
+
+    // single sample copy of the multisampled framebuffers, which cannot be read directly
+    GLuint _resolveFbo = 0;
+    GLuint _resolveRbo = 0;
+    int _resolveWidth = 0;
+    int _resolveHeight = 0;
+
+    std::thread _encoder;
+    std::deque<EncodeJob> _jobs;
+    std::vector<std::vector<uint8_t>> _freeBuffers;
+    mutable std::mutex _mutex;
+    std::condition_variable _jobCondition;
+    std::condition_variable _idleCondition;
+    bool _encoding = false;
+    bool _stopped = false;
+    uint64_t _capturedFrameCount = 0;
+    uint64_t _droppedFrameCount = 0;
+
+    // touched by the encoder thread only
+    std::ofstream _video;
+    int _videoWidth = 0;
+    int _videoHeight = 0;
+    std::vector<uint8_t> _yuv;
+
+    GLuint resolve(GLuint framebuffer, GLenum readBuffer, int width, int height);
+
+    // hand the pixels of the slot to the encoder, dropping them when it is behind
+    // unless wait is set
+    void readBack(Slot& slot, bool wait);
+
+    void encoderLoop();
+
+    void encode(const EncodeJob& job);
+
+    void writePng(const EncodeJob& job);
+
+    void writeY4m(const EncodeJob& job);
+};
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <thread>
+
+#include "frame_pacer.h"
+
+namespace {
+double toMs(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+}  // namespace
+
+FramePacer::FramePacer(int maxFrameRate) {
+    if (maxFrameRate > 0) {
+        _period = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(1.0 / maxFrameRate));
+    }
+
+    start();
+}
+
+void FramePacer::start() {
+    _frameBegin = Clock::now();
+    _deadline = _frameBegin;
+    _frameCount = 0;
+    _totalWorkMs = 0.0;
+    _totalWaitMs = 0.0;
+}
+
+void FramePacer::wait() {
+    const Clock::time_point workEnd = Clock::now();
+
+    if (_period.count() > 0) {
+        // a late frame moves the schedule instead of being caught up by a burst of frames
+        _deadline = std::max(_deadline + _period, workEnd);
+
+        const double remainingMs = toMs(_deadline - workEnd);
+        if (remainingMs > _sleepOvershootMs) {
+            const auto sleepTime = std::chrono::duration<double, std::milli>(
+                remainingMs - _sleepOvershootMs);
+            const Clock::time_point sleepBegin = Clock::now();
+            std::this_thread::sleep_for(sleepTime);
+            const double overshootMs = toMs(Clock::now() - sleepBegin) - sleepTime.count();
+            _sleepOvershootMs = std::max(0.95 * _sleepOvershootMs, std::max(overshootMs, 0.1));
+        }
+
+        while (Clock::now() < _deadline) {
+            std::this_thread::yield();
+        }
+    }
+
+    const Clock::time_point waitEnd = Clock::now();
+    _totalWorkMs += toMs(workEnd - _frameBegin);
+    _totalWaitMs += toMs(waitEnd - workEnd);
+    ++_frameCount;
+    _frameBegin = waitEnd;
+}
+
+double FramePacer::getTargetFrameMs() const {
+    return toMs(_period);
+}
+
+uint64_t FramePacer::getFrameCount() const {
+    return _frameCount;
+}
+
+double FramePacer::getMeanWorkMs() const {
+    return _frameCount > 0 ? _totalWorkMs / _frameCount : 0.0;
+}
+
+double FramePacer::getMeanWaitMs() const {
+    return _frameCount > 0 ? _totalWaitMs / _frameCount : 0.0;
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// cap the frame rate and measure how much of a frame is spent working and how much waiting.
+// the wait sleeps for the most of the remaining time and spins for the rest, since a sleep
+// may overshoot by a scheduler tick. the overshoot is estimated from the previous sleeps
+class FramePacer {
+public:
+    // 0 frames per second for no cap, the times are measured either way
+    FramePacer(int maxFrameRate = 0);
+
+    // the frame work begins now
+    void start();
+
+    // call it once the work of a frame is done, it returns when the next frame is due
+    void wait();
+
+    double getTargetFrameMs() const;
+
+    uint64_t getFrameCount() const;
+
+    // means over the frames since start()
+    double getMeanWorkMs() const;
+
+    double getMeanWaitMs() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::duration _period{0};
+    Clock::time_point _frameBegin;
+    Clock::time_point _deadline;
+
+    // the largest recent overshoot of a sleep, decaying so that a single hiccup is forgotten
+    double _sleepOvershootMs = 1.0;
+
+    uint64_t _frameCount = 0;
+    double _totalWorkMs = 0.0;
+    double _totalWaitMs = 0.0;
+};
\ No newline at end of file
@@ -1,45 +1,113 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
+// ring buffer of the latest frame times. the statistics are taken over frame times instead
+// of frame rates, since the mean of the rates hides the long frames users notice
 class FrameRateIndicator {
 public:
-    FrameRateIndicator(int capacity) : _capacity(capacity) {
-        _frameRates.reserve(capacity);
-    }
+    struct Statistics {
+        float meanMs = 0.0f;
+        float minMs = 0.0f;
+        float maxMs = 0.0f;
+        float p50Ms = 0.0f;
+        float p95Ms = 0.0f;
+        float p99Ms = 0.0f;
+    };
+
+    FrameRateIndicator(int capacity) : _frameTimes(std::max(1, capacity), 0.0f) {}
 
     ~FrameRateIndicator() = default;
 
-    void push(float frameRate) {
-        if (_frameRates.size() == _capacity) {
-            _frameRates.erase(_frameRates.begin());
+    void push(float frameTimeMs) {
+        if (_size == static_cast<int>(_frameTimes.size())) {
+            _sum -= _frameTimes[_head];
+        } else {
+            ++_size;
         }
-        _frameRates.push_back(frameRate);
+
+        _frameTimes[_head] = frameTimeMs;
+        _sum += frameTimeMs;
+        _head = (_head + 1) % static_cast<int>(_frameTimes.size());
     }
 
+    // frames per second over the whole ring, i.e. the reciprocal of the mean frame time
     float getAverageFrameRate() const {
-        float avg = 0.0f;
-        for (size_t i = 0; i < _frameRates.size(); ++i) {
-            avg += _frameRates[i];
+        return _sum > 0.0 ? static_cast<float>(1000.0 * _size / _sum) : 0.0f;
+    }
+
+    float getMeanFrameTime() const {
+        return _size > 0 ? static_cast<float>(_sum / _size) : 0.0f;
+    }
+
+    // sorts a copy of the ring, call it at most once per frame
+    Statistics getStatistics() const {
+        Statistics stats;
+        if (_size == 0) {
+            return stats;
+        }
+
+        std::vector<float> sorted(_frameTimes.begin(), _frameTimes.begin() + _size);
+        std::sort(sorted.begin(), sorted.end());
+
+        stats.meanMs = getMeanFrameTime();
+        stats.minMs = sorted.front();
+        stats.maxMs = sorted.back();
+        stats.p50Ms = getPercentile(sorted, 0.50f);
+        stats.p95Ms = getPercentile(sorted, 0.95f);
+        stats.p99Ms = getPercentile(sorted, 0.99f);
+
+        return stats;
+    }
+
+    // frame counts of bucketCount equal buckets in [0, maxMs), the last bucket also
+    // counts the longer frames. maxMs <= 0 spans the longest frame in the ring
+    std::vector<float> getHistogram(int bucketCount, float maxMs = 0.0f) const {
+        std::vector<float> histogram(std::max(1, bucketCount), 0.0f);
+        if (_size == 0) {
+            return histogram;
+        }
+
+        if (maxMs <= 0.0f) {
+            maxMs = *std::max_element(_frameTimes.begin(), _frameTimes.begin() + _size) * 1.001f;
         }
 
-        size_t count = _frameRates.size();
-        if (count == 0) {
-            count = 1;
+        // all the frames may take 0 ms, e.g. with a coarse timer
+        maxMs = std::max(maxMs, 1e-3f);
+
+        const int lastBucket = static_cast<int>(histogram.size()) - 1;
+        for (int i = 0; i < _size; ++i) {
+            const int bucket = static_cast<int>(_frameTimes[i] / maxMs * histogram.size());
+            histogram[std::min(std::max(bucket, 0), lastBucket)] += 1.0f;
         }
 
-        return avg / count;
+        return histogram;
     }
 
+    // the frame times in ms for ImGui::PlotLines, the oldest one is at getOffset()
     const float* getDataPtr() const {
-        return _frameRates.data();
+        return _frameTimes.data();
     }
 
     int getSize() const {
-        return static_cast<int>(_frameRates.size());
+        return _size;
+    }
+
+    int getOffset() const {
+        return _size == static_cast<int>(_frameTimes.size()) ? _head : 0;
     }
 
 private:
-    std::vector<float> _frameRates;
-    const int _capacity;
+    std::vector<float> _frameTimes;
+    int _head = 0;
+    int _size = 0;
+    double _sum = 0.0;
+
+    // nearest rank percentile of the sorted frame times
+    static float getPercentile(const std::vector<float>& sorted, float percentile) {
+        const size_t rank = static_cast<size_t>(std::ceil(percentile * sorted.size()));
+        return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+    }
 };
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+
+#include <imgui.h>
+
+#include "frame_rate_indicator.h"
+
+// the average frame rate, the frame time percentiles, the frame time plot and its histogram
+// of the indicator, call it inside an ImGui window
+inline void drawFrameRatePanel(const FrameRateIndicator& indicator) {
+    const FrameRateIndicator::Statistics stats = indicator.getStatistics();
+    ImGui::Text("avg fps: %.1f", indicator.getAverageFrameRate());
+    ImGui::Text("frame time (ms)");
+    ImGui::Text(
+        "p50 %.2f  p95 %.2f  p99 %.2f  max %.2f", stats.p50Ms, stats.p95Ms, stats.p99Ms,
+        stats.maxMs);
+    ImGui::PlotLines(
+        "##frame time", indicator.getDataPtr(), indicator.getSize(), indicator.getOffset(),
+        nullptr, 0.0f, std::numeric_limits<float>::max(), ImVec2(240.0f, 50.0f));
+
+    const std::vector<float> histogram = indicator.getHistogram(32);
+    ImGui::PlotHistogram(
+        "##frame time histogram", histogram.data(), static_cast<int>(histogram.size()), 0,
+        nullptr, 0.0f, std::numeric_limits<float>::max(), ImVec2(240.0f, 50.0f));
+}
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#include "frame_rate_indicator.h"
+#include "frame_timings.h"
+
+namespace {
+double getElapsedMs(std::chrono::steady_clock::time_point begin) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin)
+        .count();
+}
+
+FrameRateIndicator::Statistics getStatistics(
+    const std::vector<FrameTiming>& frames, double FrameTiming::*member) {
+    FrameRateIndicator indicator(static_cast<int>(frames.size()));
+    for (const auto& frame : frames) {
+        indicator.push(static_cast<float>(frame.*member));
+    }
+
+    return indicator.getStatistics();
+}
+
+bool hasSuffix(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size()
+           && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+struct SummaryColumn {
+    const char* name;
+    double FrameTiming::*member;
+};
+
+// the gpu column is the last one, it is left out without timer queries
+const SummaryColumn summaryColumns[] = {
+    {"frame", &FrameTiming::frameMs},
+    {"cpu", &FrameTiming::cpuMs},
+    {"gpu", &FrameTiming::gpuMs},
+};
+}  // namespace
+
+FrameTimings::FrameTimings(uint32_t latency)
+    : _queries(latency), _slotFrames(_queries.getSlotCount(), 0) {
+    // timer queries are core since OpenGL 3.3 but missing in WebGL
+    _gpuTimingSupported = glQueryCounter != nullptr && glGetQueryObjectui64v != nullptr;
+}
+
+FrameTimings::~FrameTimings() = default;
+
+void FrameTimings::beginFrame() {
+    if (!_frames.empty()) {
+        _frames.back().frameMs = getElapsedMs(_frameBegin);
+    }
+
+    _frameBegin = std::chrono::steady_clock::now();
+    _inFrame = true;
+
+    const uint32_t slotIndex = _queries.getSlotIndex();
+    if (_queries.isPending(slotIndex)) {
+        resolve(slotIndex);
+    }
+
+    _slotFrames[slotIndex] = _frames.size();
+    _frames.emplace_back();
+
+    if (_gpuTimingSupported) {
+        _queries.beginFrame();
+        _queries.record();
+    }
+}
+
+void FrameTimings::endFrame() {
+    if (!_inFrame) {
+        return;
+    }
+
+    if (_gpuTimingSupported) {
+        _queries.record();
+        _queries.endFrame();
+    }
+
+    _frames.back().cpuMs = getElapsedMs(_frameBegin);
+    _inFrame = false;
+}
+
+void FrameTimings::finish() {
+    if (!_frames.empty()) {
+        _frames.back().frameMs = getElapsedMs(_frameBegin);
+    }
+
+    for (uint32_t i = 0; i < _queries.getSlotCount(); ++i) {
+        if (_queries.isPending(i)) {
+            resolve(i);
+        }
+    }
+}
+
+const std::vector<FrameTiming>& FrameTimings::getFrames() const {
+    return _frames;
+}
+
+bool FrameTimings::isGpuTimingSupported() const {
+    return _gpuTimingSupported;
+}
+
+void FrameTimings::save(const std::string& filePath) const {
+    std::ofstream os(filePath);
+    if (!os) {
+        throw std::runtime_error("open " + filePath + " failure");
+    }
+
+    os.setf(std::ios::fixed);
+    os.precision(3);
+
+    if (hasSuffix(filePath, ".json")) {
+        os << "{\n  \"frames\": [";
+        for (size_t i = 0; i < _frames.size(); ++i) {
+            os << (i == 0 ? "\n" : ",\n") << "    {\"frame\": " << i
+               << ", \"frameMs\": " << _frames[i].frameMs << ", \"cpuMs\": " << _frames[i].cpuMs
+               << ", \"gpuMs\": ";
+            if (_gpuTimingSupported) {
+                os << _frames[i].gpuMs << "}";
+            } else {
+                os << "null}";
+            }
+        }
+
+        os << "\n  ],\n  \"summary\": {";
+        for (size_t i = 0; i < getSummaryColumnCount(); ++i) {
+            const auto stats = getStatistics(_frames, summaryColumns[i].member);
+            os << (i == 0 ? "\n" : ",\n") << "    \"" << summaryColumns[i].name << "\": {"
+               << "\"meanMs\": " << stats.meanMs << ", \"p50Ms\": " << stats.p50Ms
+               << ", \"p95Ms\": " << stats.p95Ms << ", \"p99Ms\": " << stats.p99Ms
+               << ", \"maxMs\": " << stats.maxMs << "}";
+        }
+
+        os << "\n  }\n}\n";
+    } else {
+        os << "frame,frame_ms,cpu_ms,gpu_ms\n";
+        for (size_t i = 0; i < _frames.size(); ++i) {
+            os << i << ',' << _frames[i].frameMs << ',' << _frames[i].cpuMs << ',';
+            if (_gpuTimingSupported) {
+                os << _frames[i].gpuMs;
+            }
+
+            os << '\n';
+        }
+
+        // the summary rows are named instead of numbered
+        FrameRateIndicator::Statistics stats[std::size(summaryColumns)];
+        for (size_t i = 0; i < getSummaryColumnCount(); ++i) {
+            stats[i] = getStatistics(_frames, summaryColumns[i].member);
+        }
+
+        const std::pair<const char*, float FrameRateIndicator::Statistics::*> rows[] = {
+            {"mean", &FrameRateIndicator::Statistics::meanMs},
+            {"p50", &FrameRateIndicator::Statistics::p50Ms},
+            {"p95", &FrameRateIndicator::Statistics::p95Ms},
+            {"p99", &FrameRateIndicator::Statistics::p99Ms},
+            {"max", &FrameRateIndicator::Statistics::maxMs},
+        };
+
+        for (const auto& row : rows) {
+            os << row.first;
+            for (size_t i = 0; i < std::size(summaryColumns); ++i) {
+                os << ',';
+                if (i < getSummaryColumnCount()) {
+                    os << stats[i].*row.second;
+                }
+            }
+
+            os << '\n';
+        }
+    }
+
+    if (!os) {
+        throw std::runtime_error("write " + filePath + " failure");
+    }
+}
+
+void FrameTimings::printSummary() const {
+    std::cout << "Benchmark (" << _frames.size() << " frames)\n";
+    for (size_t i = 0; i < getSummaryColumnCount(); ++i) {
+        const SummaryColumn& column = summaryColumns[i];
+        const auto stats = getStatistics(_frames, column.member);
+        std::cout << "+ " << column.name << " ms: mean " << stats.meanMs << ", p50 " << stats.p50Ms
+                  << ", p95 " << stats.p95Ms << ", p99 " << stats.p99Ms << ", max " << stats.maxMs
+                  << '\n';
+    }
+
+    if (!_gpuTimingSupported) {
+        std::cout << "+ gpu ms: timer queries are not supported\n";
+    }
+
+    std::cout << std::endl;
+}
+
+size_t FrameTimings::getSummaryColumnCount() const {
+    return std::size(summaryColumns) - (_gpuTimingSupported ? 0 : 1);
+}
+
+void FrameTimings::resolve(uint32_t slotIndex) {
+    const std::vector<GLuint64> timestamps = _queries.read(slotIndex);
+    _frames[_slotFrames[slotIndex]].gpuMs =
+        1.0e-6 * static_cast<double>(timestamps[1] - timestamps[0]);
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "timestamp_query_ring.h"
+
+struct FrameTiming {
+    // from the begin of the frame to the begin of the next one
+    double frameMs = 0.0;
+    // from the begin of the frame until all its commands are submitted
+    double cpuMs = 0.0;
+    // between the first and the last command of the frame on the gpu,
+    // 0 without timer queries
+    double gpuMs = 0.0;
+};
+
+// cpu and gpu time of every frame of a benchmark run. the gpu time is measured by a pair of
+// timestamp queries per frame in the ring the profiler uses, so reading them never stalls
+class FrameTimings {
+public:
+    FrameTimings(uint32_t latency = 4);
+
+    FrameTimings(const FrameTimings&) = delete;
+
+    FrameTimings& operator=(const FrameTimings&) = delete;
+
+    ~FrameTimings();
+
+    void beginFrame();
+
+    void endFrame();
+
+    // read the queries still in flight, call it after the last frame
+    void finish();
+
+    const std::vector<FrameTiming>& getFrames() const;
+
+    // the gpu columns of the output are left empty without timer queries
+    bool isGpuTimingSupported() const;
+
+    // per frame rows followed by the summary, in json for a .json file and csv otherwise
+    void save(const std::string& filePath) const;
+
+    void printSummary() const;
+
+private:
+    bool _gpuTimingSupported = false;
+    TimestampQueryRing _queries;
+    // the frame recorded in each slot of the ring
+    std::vector<size_t> _slotFrames;
+
+    std::vector<FrameTiming> _frames;
+    std::chrono::steady_clock::time_point _frameBegin;
+    bool _inFrame = false;
+
+    void resolve(uint32_t slotIndex);
+
+    size_t getSummaryColumnCount() const;
+};
\ No newline at end of file
@@ -12,17 +12,17 @@ Framebuffer::Framebuffer(Framebuffer&& rhs) noexcept {
 
 Framebuffer::~Framebuffer() {
     if (_handle != 0) {
-        glDeleteFramebuffers(1, &_handle);
+        GLStateCache::deleteFramebuffers(1, &_handle);
         _handle = 0;
     }
 }
 
 void Framebuffer::bind() {
-    glBindFramebuffer(GL_FRAMEBUFFER, _handle);
+    GLStateCache::bindFramebuffer(GL_FRAMEBUFFER, _handle);
 }
 
 void Framebuffer::unbind() {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLStateCache::bindFramebuffer(GL_FRAMEBUFFER, getDefaultFramebuffer());
 }
 
 void Framebuffer::attachTexture(const Texture& texture, GLenum attachment, int level) {
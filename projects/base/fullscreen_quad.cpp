@@ -8,7 +8,7 @@ FullscreenQuad::FullscreenQuad() {
     glGenVertexArrays(1, &_vao);
     glGenBuffers(1, &_vbo);
 
-    glBindVertexArray(_vao);
+    GLStateCache::bindVertexArray(_vao);
     glBindBuffer(GL_ARRAY_BUFFER, _vbo);
 
     glBufferData(GL_ARRAY_BUFFER, sizeof(_vertices), &_vertices, GL_STATIC_DRAW);
@@ -20,7 +20,7 @@ FullscreenQuad::FullscreenQuad() {
         1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), reinterpret_cast<float*>(2 * sizeof(float)));
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    GLStateCache::bindVertexArray(0);
 }
 
 FullscreenQuad::FullscreenQuad(FullscreenQuad&& rhs) noexcept : _vao(rhs._vao), _vbo(rhs._vbo) {
@@ -30,7 +30,7 @@ FullscreenQuad::FullscreenQuad(FullscreenQuad&& rhs) noexcept : _vao(rhs._vao),
 
 FullscreenQuad::~FullscreenQuad() {
     if (_vao) {
-        glDeleteVertexArrays(1, &_vao);
+        GLStateCache::deleteVertexArrays(1, &_vao);
         _vao = 0;
     }
 
@@ -41,7 +41,6 @@ FullscreenQuad::~FullscreenQuad() {
 }
 
 void FullscreenQuad::draw() const {
-    glBindVertexArray(_vao);
+    GLStateCache::bindVertexArray(_vao);
     glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
 }
\ No newline at end of file
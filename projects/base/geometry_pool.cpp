@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include "geometry_pool.h"
+#include "model.h"
+
+GeometryPool::GeometryPool(size_t vertexCapacity, size_t indexByteCapacity) {
+    _baseVertexSupported = glDrawElementsBaseVertex != nullptr
+                           && glDrawElementsInstancedBaseVertex != nullptr
+                           && glMultiDrawElementsBaseVertex != nullptr;
+
+    glGenVertexArrays(1, &_vao);
+
+    reserve(vertexCapacity, indexByteCapacity);
+
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        cleanup();
+        throw std::runtime_error("OpenGL Error: " + std::to_string(error));
+    }
+}
+
+GeometryPool::GeometryPool(GeometryPool&& rhs) noexcept
+    : _vao(rhs._vao), _vbo(rhs._vbo), _ebo(rhs._ebo), _vertexCapacity(rhs._vertexCapacity),
+      _vertexCount(rhs._vertexCount), _indexByteCapacity(rhs._indexByteCapacity),
+      _indexByteSize(rhs._indexByteSize), _baseVertexSupported(rhs._baseVertexSupported) {
+    rhs._vao = 0;
+    rhs._vbo = 0;
+    rhs._ebo = 0;
+    rhs._vertexCapacity = 0;
+    rhs._vertexCount = 0;
+    rhs._indexByteCapacity = 0;
+    rhs._indexByteSize = 0;
+}
+
+GeometryPool::~GeometryPool() {
+    cleanup();
+}
+
+GeometryPool::Range GeometryPool::add(
+    const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
+    Range range;
+    range.indexCount = static_cast<uint32_t>(indices.size());
+    range.vertexCount = static_cast<uint32_t>(vertices.size());
+
+    const std::vector<uint32_t>* rangeIndices = &indices;
+    if (_baseVertexSupported) {
+        // indices are relative to the base vertex of the range, so the index type only
+        // depends on the vertex count of the mesh itself rather than the size of the pool
+        range.indexType = getIndexType(vertices.size());
+        range.baseVertex = static_cast<int32_t>(_vertexCount);
+    } else {
+        // the indices address the pool from its first vertex, the ranges added before keep
+        // their index type since their indices do not grow
+        range.indexType = getIndexType(_vertexCount + vertices.size());
+        range.baseVertex = 0;
+        _rebasedIndices.clear();
+        for (uint32_t index : indices) {
+            _rebasedIndices.push_back(index + static_cast<uint32_t>(_vertexCount));
+        }
+
+        rangeIndices = &_rebasedIndices;
+    }
+
+    // keep the offset aligned to the size of the index type
+    const size_t indexSize = getIndexTypeSize(range.indexType);
+    range.indexByteOffset = (_indexByteSize + indexSize - 1) / indexSize * indexSize;
+    range.firstIndex = static_cast<uint32_t>(range.indexByteOffset / indexSize);
+
+    const std::vector<uint8_t> indexData = packIndices(*rangeIndices, range.indexType);
+
+    // grow the buffers geometrically when the pool is full
+    const size_t requiredVertices = _vertexCount + vertices.size();
+    const size_t requiredIndexBytes = range.indexByteOffset + indexData.size();
+    if (requiredVertices > _vertexCapacity || requiredIndexBytes > _indexByteCapacity) {
+        reserve(
+            std::max(requiredVertices, 2 * _vertexCapacity),
+            std::max(requiredIndexBytes, 2 * _indexByteCapacity));
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+    glBufferSubData(
+        GL_ARRAY_BUFFER, sizeof(Vertex) * _vertexCount, sizeof(Vertex) * vertices.size(),
+        vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // the element array binding is part of the vao state
+    GLStateCache::bindVertexArray(_vao);
+    glBufferSubData(
+        GL_ELEMENT_ARRAY_BUFFER, range.indexByteOffset, indexData.size(), indexData.data());
+    GLStateCache::bindVertexArray(0);
+
+    _vertexCount = requiredVertices;
+    _indexByteSize = requiredIndexBytes;
+
+    return range;
+}
+
+GeometryPool::Range GeometryPool::add(const Model& model) {
+    return add(model.getVertices(), model.getIndices());
+}
+
+void GeometryPool::bind() const {
+    GLStateCache::bindVertexArray(_vao);
+}
+
+void GeometryPool::unbind() const {
+    GLStateCache::bindVertexArray(0);
+}
+
+void GeometryPool::draw(const Range& range) const {
+    if (!_baseVertexSupported) {
+        glDrawElements(
+            GL_TRIANGLES, static_cast<GLsizei>(range.indexCount), range.indexType,
+            reinterpret_cast<const void*>(range.indexByteOffset));
+        return;
+    }
+
+    glDrawElementsBaseVertex(
+        GL_TRIANGLES, static_cast<GLsizei>(range.indexCount), range.indexType,
+        reinterpret_cast<const void*>(range.indexByteOffset), range.baseVertex);
+}
+
+void GeometryPool::drawInstanced(const Range& range, int amount) const {
+    if (!_baseVertexSupported) {
+        glDrawElementsInstanced(
+            GL_TRIANGLES, static_cast<GLsizei>(range.indexCount), range.indexType,
+            reinterpret_cast<const void*>(range.indexByteOffset), amount);
+        return;
+    }
+
+    glDrawElementsInstancedBaseVertex(
+        GL_TRIANGLES, static_cast<GLsizei>(range.indexCount), range.indexType,
+        reinterpret_cast<const void*>(range.indexByteOffset), amount, range.baseVertex);
+}
+
+void GeometryPool::multiDraw(const std::vector<Range>& ranges) const {
+    // there is no multi draw either where the base vertex draws are missing
+    if (!_baseVertexSupported) {
+        for (const auto& range : ranges) {
+            draw(range);
+        }
+
+        return;
+    }
+
+    // a multi draw call takes a single index type, so batch the ranges per type
+    for (GLenum indexType : {GL_UNSIGNED_SHORT, GL_UNSIGNED_INT}) {
+        _counts.clear();
+        _offsets.clear();
+        _baseVertices.clear();
+
+        for (const auto& range : ranges) {
+            if (range.indexType == indexType) {
+                _counts.push_back(static_cast<GLsizei>(range.indexCount));
+                _offsets.push_back(reinterpret_cast<const void*>(range.indexByteOffset));
+                _baseVertices.push_back(range.baseVertex);
+            }
+        }
+
+        if (!_counts.empty()) {
+            glMultiDrawElementsBaseVertex(
+                GL_TRIANGLES, _counts.data(), indexType, _offsets.data(),
+                static_cast<GLsizei>(_counts.size()), _baseVertices.data());
+        }
+    }
+}
+
+GLuint GeometryPool::getVao() const {
+    return _vao;
+}
+
+GLuint GeometryPool::getVbo() const {
+    return _vbo;
+}
+
+GLuint GeometryPool::getEbo() const {
+    return _ebo;
+}
+
+size_t GeometryPool::getVertexCount() const {
+    return _vertexCount;
+}
+
+size_t GeometryPool::getIndexByteSize() const {
+    return _indexByteSize;
+}
+
+void GeometryPool::reserve(size_t vertexCapacity, size_t indexByteCapacity) {
+    GLuint vbo = 0, ebo = 0;
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+    glBufferData(GL_COPY_WRITE_BUFFER, sizeof(Vertex) * vertexCapacity, nullptr, GL_STATIC_DRAW);
+    if (_vertexCount > 0) {
+        glBindBuffer(GL_COPY_READ_BUFFER, _vbo);
+        glCopyBufferSubData(
+            GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(Vertex) * _vertexCount);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ebo);
+    glBufferData(GL_COPY_WRITE_BUFFER, indexByteCapacity, nullptr, GL_STATIC_DRAW);
+    if (_indexByteSize > 0) {
+        glBindBuffer(GL_COPY_READ_BUFFER, _ebo);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, _indexByteSize);
+    }
+
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    if (_vbo != 0) {
+        glDeleteBuffers(1, &_vbo);
+    }
+
+    if (_ebo != 0) {
+        glDeleteBuffers(1, &_ebo);
+    }
+
+    _vbo = vbo;
+    _ebo = ebo;
+    _vertexCapacity = vertexCapacity;
+    _indexByteCapacity = indexByteCapacity;
+
+    // point the vao to the new buffers with the same layout as Model
+    GLStateCache::bindVertexArray(_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
+
+    glVertexAttribPointer(
+        0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(
+        1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(
+        2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
+    glEnableVertexAttribArray(2);
+
+    GLStateCache::bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GeometryPool::cleanup() {
+    if (_ebo != 0) {
+        glDeleteBuffers(1, &_ebo);
+        _ebo = 0;
+    }
+
+    if (_vbo != 0) {
+        glDeleteBuffers(1, &_vbo);
+        _vbo = 0;
+    }
+
+    if (_vao != 0) {
+        GLStateCache::deleteVertexArrays(1, &_vao);
+        _vao = 0;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+
+#include "gl_utility.h"
+#include "vertex.h"
+
+class Model;
+
+// suballocates the vertices and indices of many meshes from one vertex buffer and one
+// index buffer, so that a frame can bind a single vertex array and issue many draws.
+// without the base vertex draws (OpenGL ES 3.0, WebGL 2) the indices are rebased to the
+// pool at upload and the ranges have a base vertex of 0
+class GeometryPool {
+public:
+    struct Range {
+        GLenum indexType = GL_UNSIGNED_INT;
+        uint32_t indexCount = 0;
+        // first index in units of the index type, usable in indirect draw commands
+        uint32_t firstIndex = 0;
+        size_t indexByteOffset = 0;
+        int32_t baseVertex = 0;
+        uint32_t vertexCount = 0;
+    };
+
+    GeometryPool(size_t vertexCapacity, size_t indexByteCapacity);
+
+    GeometryPool(const GeometryPool&) = delete;
+
+    GeometryPool(GeometryPool&& rhs) noexcept;
+
+    ~GeometryPool();
+
+    Range add(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+
+    Range add(const Model& model);
+
+    void bind() const;
+
+    void unbind() const;
+
+    void draw(const Range& range) const;
+
+    void drawInstanced(const Range& range, int amount) const;
+
+    void multiDraw(const std::vector<Range>& ranges) const;
+
+    GLuint getVao() const;
+
+    GLuint getVbo() const;
+
+    GLuint getEbo() const;
+
+    size_t getVertexCount() const;
+
+    size_t getIndexByteSize() const;
+
+private:
+    GLuint _vao = 0;
+    GLuint _vbo = 0;
+    GLuint _ebo = 0;
+
+    size_t _vertexCapacity = 0;
+    size_t _vertexCount = 0;
+
+    size_t _indexByteCapacity = 0;
+    size_t _indexByteSize = 0;
+
+    bool _baseVertexSupported = true;
+
+    // scratch arrays of multiDraw and add to avoid allocations every call
+    mutable std::vector<GLsizei> _counts;
+    mutable std::vector<const void*> _offsets;
+    mutable std::vector<GLint> _baseVertices;
+    std::vector<uint32_t> _rebasedIndices;
+
+    void reserve(size_t vertexCapacity, size_t indexByteCapacity);
+
+    void cleanup();
+};
\ No newline at end of file
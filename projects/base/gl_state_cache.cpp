@@ -0,0 +1,342 @@
+#include <cstddef>
+#include <vector>
+
+#include "gl_state_cache.h"
+
+namespace {
+constexpr GLuint unknownName = ~0u;
+constexpr GLenum unknownEnum = ~0u;
+
+// the texture targets tracked per unit, the others are passed through
+constexpr GLenum textureTargets[] = {
+    GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_3D,
+    GL_TEXTURE_2D_MULTISAMPLE};
+constexpr int textureTargetCount = sizeof(textureTargets) / sizeof(textureTargets[0]);
+
+constexpr GLenum capabilities[] = {GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE};
+constexpr int capabilityCount = sizeof(capabilities) / sizeof(capabilities[0]);
+
+struct TextureUnit {
+    GLuint textures[textureTargetCount];
+    GLuint sampler;
+};
+
+struct State {
+    GLuint program;
+    GLuint vertexArray;
+    GLuint drawFramebuffer;
+    GLuint readFramebuffer;
+    GLenum activeTexture;
+    std::vector<TextureUnit> textureUnits;
+    GLint viewport[4];
+    bool viewportKnown;
+    // -1 when unknown
+    int capabilities[capabilityCount];
+    GLenum blendSourceFactor;
+    GLenum blendDestinationFactor;
+    GLenum depthFunc;
+    int depthMask;
+    GLenum cullFace;
+    GLStateCache::Counters counters;
+
+    State() {
+        reset();
+    }
+
+    void reset() {
+        program = unknownName;
+        vertexArray = unknownName;
+        drawFramebuffer = unknownName;
+        readFramebuffer = unknownName;
+        activeTexture = unknownEnum;
+        textureUnits.clear();
+        viewportKnown = false;
+        for (int& capability : capabilities) {
+            capability = -1;
+        }
+        blendSourceFactor = unknownEnum;
+        blendDestinationFactor = unknownEnum;
+        depthFunc = unknownEnum;
+        depthMask = -1;
+        cullFace = unknownEnum;
+    }
+};
+
+State& getState() {
+    static State state;
+    return state;
+}
+
+// false when the call can be skipped, counting it either way
+bool update(bool changed) {
+    GLStateCache::Counters& counters = getState().counters;
+    if (changed) {
+        ++counters.issued;
+    } else {
+        ++counters.skipped;
+    }
+
+    return changed;
+}
+
+TextureUnit& getTextureUnit(size_t index) {
+    std::vector<TextureUnit>& units = getState().textureUnits;
+    if (index >= units.size()) {
+        TextureUnit unknownUnit;
+        for (GLuint& texture : unknownUnit.textures) {
+            texture = unknownName;
+        }
+        unknownUnit.sampler = unknownName;
+        units.resize(index + 1, unknownUnit);
+    }
+
+    return units[index];
+}
+
+int getTextureTargetIndex(GLenum target) {
+    for (int i = 0; i < textureTargetCount; ++i) {
+        if (textureTargets[i] == target) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+int getCapabilityIndex(GLenum capability) {
+    for (int i = 0; i < capabilityCount; ++i) {
+        if (capabilities[i] == capability) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void setCapability(GLenum capability, bool enabled) {
+    const int index = getCapabilityIndex(capability);
+    if (index < 0) {
+        update(true);
+    } else {
+        int& state = getState().capabilities[index];
+        if (!update(state != static_cast<int>(enabled))) {
+            return;
+        }
+        state = enabled;
+    }
+
+    if (enabled) {
+        glEnable(capability);
+    } else {
+        glDisable(capability);
+    }
+}
+}  // namespace
+
+void GLStateCache::useProgram(GLuint program) {
+    State& state = getState();
+    if (update(state.program != program)) {
+        state.program = program;
+        glUseProgram(program);
+    }
+}
+
+void GLStateCache::bindVertexArray(GLuint vertexArray) {
+    State& state = getState();
+    if (update(state.vertexArray != vertexArray)) {
+        state.vertexArray = vertexArray;
+        glBindVertexArray(vertexArray);
+    }
+}
+
+void GLStateCache::activeTexture(GLenum unit) {
+    State& state = getState();
+    if (update(state.activeTexture != unit)) {
+        state.activeTexture = unit;
+        glActiveTexture(unit);
+    }
+}
+
+void GLStateCache::bindTexture(GLenum target, GLuint texture) {
+    State& state = getState();
+    const int targetIndex = getTextureTargetIndex(target);
+    if (targetIndex < 0 || state.activeTexture == unknownEnum) {
+        update(true);
+        glBindTexture(target, texture);
+        return;
+    }
+
+    GLuint& bound = getTextureUnit(state.activeTexture - GL_TEXTURE0).textures[targetIndex];
+    if (update(bound != texture)) {
+        bound = texture;
+        glBindTexture(target, texture);
+    }
+}
+
+void GLStateCache::bindSampler(GLuint unit, GLuint sampler) {
+    GLuint& bound = getTextureUnit(unit).sampler;
+    if (update(bound != sampler)) {
+        bound = sampler;
+        glBindSampler(unit, sampler);
+    }
+}
+
+void GLStateCache::bindFramebuffer(GLenum target, GLuint framebuffer) {
+    State& state = getState();
+    const bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+    const bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+    const bool changed = (draw && state.drawFramebuffer != framebuffer)
+                         || (read && state.readFramebuffer != framebuffer);
+    if (update(changed)) {
+        if (draw) {
+            state.drawFramebuffer = framebuffer;
+        }
+        if (read) {
+            state.readFramebuffer = framebuffer;
+        }
+        glBindFramebuffer(target, framebuffer);
+    }
+}
+
+void GLStateCache::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    State& state = getState();
+    const bool changed = !state.viewportKnown || state.viewport[0] != x
+                         || state.viewport[1] != y || state.viewport[2] != width
+                         || state.viewport[3] != height;
+    if (update(changed)) {
+        state.viewport[0] = x;
+        state.viewport[1] = y;
+        state.viewport[2] = width;
+        state.viewport[3] = height;
+        state.viewportKnown = true;
+        glViewport(x, y, width, height);
+    }
+}
+
+void GLStateCache::enable(GLenum capability) {
+    setCapability(capability, true);
+}
+
+void GLStateCache::disable(GLenum capability) {
+    setCapability(capability, false);
+}
+
+void GLStateCache::blendFunc(GLenum sourceFactor, GLenum destinationFactor) {
+    State& state = getState();
+    const bool changed = state.blendSourceFactor != sourceFactor
+                         || state.blendDestinationFactor != destinationFactor;
+    if (update(changed)) {
+        state.blendSourceFactor = sourceFactor;
+        state.blendDestinationFactor = destinationFactor;
+        glBlendFunc(sourceFactor, destinationFactor);
+    }
+}
+
+void GLStateCache::depthFunc(GLenum func) {
+    State& state = getState();
+    if (update(state.depthFunc != func)) {
+        state.depthFunc = func;
+        glDepthFunc(func);
+    }
+}
+
+void GLStateCache::depthMask(GLboolean flag) {
+    State& state = getState();
+    if (update(state.depthMask != static_cast<int>(flag))) {
+        state.depthMask = flag;
+        glDepthMask(flag);
+    }
+}
+
+void GLStateCache::cullFace(GLenum mode) {
+    State& state = getState();
+    if (update(state.cullFace != mode)) {
+        state.cullFace = mode;
+        glCullFace(mode);
+    }
+}
+
+void GLStateCache::deleteProgram(GLuint program) {
+    // a program in use is only deleted once it is no longer used
+    State& state = getState();
+    if (state.program == program) {
+        state.program = unknownName;
+    }
+
+    glDeleteProgram(program);
+}
+
+void GLStateCache::deleteVertexArrays(GLsizei count, const GLuint* vertexArrays) {
+    State& state = getState();
+    for (GLsizei i = 0; i < count; ++i) {
+        if (vertexArrays[i] != 0 && state.vertexArray == vertexArrays[i]) {
+            state.vertexArray = 0;
+        }
+    }
+
+    glDeleteVertexArrays(count, vertexArrays);
+}
+
+void GLStateCache::deleteTextures(GLsizei count, const GLuint* textures) {
+    for (GLsizei i = 0; i < count; ++i) {
+        if (textures[i] == 0) {
+            continue;
+        }
+
+        for (TextureUnit& unit : getState().textureUnits) {
+            for (GLuint& texture : unit.textures) {
+                if (texture == textures[i]) {
+                    texture = 0;
+                }
+            }
+        }
+    }
+
+    glDeleteTextures(count, textures);
+}
+
+void GLStateCache::deleteSamplers(GLsizei count, const GLuint* samplers) {
+    for (GLsizei i = 0; i < count; ++i) {
+        if (samplers[i] == 0) {
+            continue;
+        }
+
+        for (TextureUnit& unit : getState().textureUnits) {
+            if (unit.sampler == samplers[i]) {
+                unit.sampler = 0;
+            }
+        }
+    }
+
+    glDeleteSamplers(count, samplers);
+}
+
+void GLStateCache::deleteFramebuffers(GLsizei count, const GLuint* framebuffers) {
+    State& state = getState();
+    for (GLsizei i = 0; i < count; ++i) {
+        if (framebuffers[i] == 0) {
+            continue;
+        }
+
+        if (state.drawFramebuffer == framebuffers[i]) {
+            state.drawFramebuffer = 0;
+        }
+        if (state.readFramebuffer == framebuffers[i]) {
+            state.readFramebuffer = 0;
+        }
+    }
+
+    glDeleteFramebuffers(count, framebuffers);
+}
+
+void GLStateCache::invalidate() {
+    getState().reset();
+}
+
+GLStateCache::Counters GLStateCache::getCounters() {
+    return getState().counters;
+}
+
+void GLStateCache::resetCounters() {
+    getState().counters = Counters();
+}
\ No newline at end of file
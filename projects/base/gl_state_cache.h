@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glad/gl.h>
+
+// shadow of the opengl binding and fixed function state which drops the calls that would not
+// change anything. the functions mirror the gl calls they replace, all code sharing the
+// context goes through them so that the shadow stays in sync. the state the shadow has not
+// seen is unknown and always set. use it on the opengl thread only.
+// a library changing the state behind the cache must restore it, or call invalidate() after
+class GLStateCache {
+public:
+    struct Counters {
+        uint64_t issued = 0;
+        uint64_t skipped = 0;
+    };
+
+    static void useProgram(GLuint program);
+
+    static void bindVertexArray(GLuint vertexArray);
+
+    // unit is GL_TEXTURE0 + i as for glActiveTexture
+    static void activeTexture(GLenum unit);
+
+    // bind to the active unit
+    static void bindTexture(GLenum target, GLuint texture);
+
+    static void bindSampler(GLuint unit, GLuint sampler);
+
+    static void bindFramebuffer(GLenum target, GLuint framebuffer);
+
+    static void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    // GL_BLEND, GL_DEPTH_TEST and GL_CULL_FACE are tracked, the others are passed through
+    static void enable(GLenum capability);
+
+    static void disable(GLenum capability);
+
+    static void blendFunc(GLenum sourceFactor, GLenum destinationFactor);
+
+    static void depthFunc(GLenum func);
+
+    static void depthMask(GLboolean flag);
+
+    static void cullFace(GLenum mode);
+
+    // the deleted objects are unbound by opengl, their names may be reused right away
+    static void deleteProgram(GLuint program);
+
+    static void deleteVertexArrays(GLsizei count, const GLuint* vertexArrays);
+
+    static void deleteTextures(GLsizei count, const GLuint* textures);
+
+    static void deleteSamplers(GLsizei count, const GLuint* samplers);
+
+    static void deleteFramebuffers(GLsizei count, const GLuint* framebuffers);
+
+    // forget the whole state, the next calls are all issued
+    static void invalidate();
+
+    // the calls issued to opengl and the ones skipped since the last reset
+    static Counters getCounters();
+
+    static void resetCounters();
+};
\ No newline at end of file
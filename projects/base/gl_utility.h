@@ -1,10 +1,15 @@
 #pragma once
 
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include <glad/gl.h>
 
+#include "gl_state_cache.h"
+
 inline GLenum implCheckGLErrors(const char* file, int line) {
     GLenum errorCode;
     while ((errorCode = glGetError()) != GL_NO_ERROR) {
@@ -26,4 +31,76 @@ inline GLenum implCheckGLErrors(const char* file, int line) {
     return errorCode;
 }
 
-#define checkGLErrors() implCheckGLErrors(__FILE__, __LINE__)
\ No newline at end of file
+#define checkGLErrors() implCheckGLErrors(__FILE__, __LINE__)
+
+// the framebuffer standing in for the window one, 0 unless the application renders offscreen
+inline GLuint& implDefaultFramebuffer() {
+    static GLuint handle = 0;
+    return handle;
+}
+
+inline GLuint getDefaultFramebuffer() {
+    return implDefaultFramebuffer();
+}
+
+inline void setDefaultFramebuffer(GLuint handle) {
+    implDefaultFramebuffer() = handle;
+}
+
+// block until the gpu has passed the fence, then delete it. the first wait flushes the
+// commands so that the fence is guaranteed to signal
+inline void waitFence(GLsync& fence) {
+    if (fence == nullptr) {
+        return;
+    }
+
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    for (;;) {
+        const GLenum result = glClientWaitSync(fence, flags, 1000000);
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED
+            || result == GL_WAIT_FAILED) {
+            break;
+        }
+
+        flags = 0;
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+// layout of the commands in GL_DRAW_INDIRECT_BUFFER for glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+    unsigned int count;
+    unsigned int instanceCount;
+    unsigned int firstIndex;
+    int baseVertex;
+    unsigned int baseInstance;
+};
+
+// 16-bit indices can address 65536 vertices, which covers most of the meshes in the projects
+inline GLenum getIndexType(size_t vertexCount) {
+    return vertexCount <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+inline size_t getIndexTypeSize(GLenum indexType) {
+    switch (indexType) {
+    case GL_UNSIGNED_BYTE: return sizeof(uint8_t);
+    case GL_UNSIGNED_SHORT: return sizeof(uint16_t);
+    default: return sizeof(uint32_t);
+    }
+}
+
+inline std::vector<uint8_t> packIndices(const std::vector<uint32_t>& indices, GLenum indexType) {
+    std::vector<uint8_t> data(indices.size() * getIndexTypeSize(indexType));
+    if (indexType == GL_UNSIGNED_SHORT) {
+        uint16_t* dst = reinterpret_cast<uint16_t*>(data.data());
+        for (size_t i = 0; i < indices.size(); ++i) {
+            dst[i] = static_cast<uint16_t>(indices[i]);
+        }
+    } else {
+        std::memcpy(data.data(), indices.data(), data.size());
+    }
+
+    return data;
+}
\ No newline at end of file
@@ -1,5 +1,10 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <random>
 #include <regex>
 #include <sstream>
 #include <stdexcept>
@@ -8,6 +13,54 @@
 
 #include "glsl_program.h"
 
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace {
+struct ProgramBinaryHeader {
+    uint32_t magic;
+    uint32_t format;
+    uint32_t length;
+};
+
+constexpr uint32_t programBinaryMagic = 0x42505347; // "GSPB"
+
+// 64-bit FNV-1a
+uint64_t hashBytes(const void* data, size_t size, uint64_t hash) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+uint64_t hashString(const std::string& str, uint64_t hash) {
+    // hash the terminating zero as well so that concatenations differ
+    return hashBytes(str.c_str(), str.size() + 1, hash);
+}
+
+bool hasExtension(const char* extension) {
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (GLint i = 0; i < extensionCount; ++i) {
+        const char* name =
+            reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        if (std::strcmp(name, extension) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+} // namespace
+
+std::string GLSLProgram::_binaryCacheDirectory;
+
+bool GLSLProgram::_parallelCompileSupported = false;
+
 GLSLProgram::GLSLProgram() {
     _handle = glCreateProgram();
     if (_handle == 0) {
@@ -16,7 +69,12 @@ GLSLProgram::GLSLProgram() {
 }
 
 GLSLProgram::GLSLProgram(GLSLProgram&& rhs) noexcept
-    : _handle(rhs._handle), _vertexShaders(std::move(rhs._vertexShaders)),
+    : _handle(rhs._handle), _linkState(rhs._linkState), _binaryKey(rhs._binaryKey),
+      _defines(std::move(rhs._defines)), _shaderSources(std::move(rhs._shaderSources)),
+      _transformFeedbackVaryings(std::move(rhs._transformFeedbackVaryings)),
+      _transformFeedbackBufferMode(rhs._transformFeedbackBufferMode),
+      _uniformLocations(std::move(rhs._uniformLocations)),
+      _vertexShaders(std::move(rhs._vertexShaders)),
       _geometryShaders(std::move(rhs._geometryShaders)),
       _fragmentShaders(std::move(rhs._fragmentShaders)) {
     rhs._handle = 0;
@@ -39,83 +97,125 @@ GLSLProgram::~GLSLProgram() {
     }
 
     if (_handle) {
-        glDeleteProgram(_handle);
+        GLStateCache::deleteProgram(_handle);
         _handle = 0;
     }
 }
 
 void GLSLProgram::attachVertexShader(const std::string& code) {
-    GLuint vertexShader = createShader(code, GL_VERTEX_SHADER);
-    glAttachShader(_handle, vertexShader);
-    _vertexShaders.push_back(vertexShader);
+    _shaderSources.push_back({GL_VERTEX_SHADER, preprocess(code, ""), ""});
 }
 
 void GLSLProgram::attachGeometryShader(const std::string& code) {
-    GLuint geometryShader = createShader(code, GL_GEOMETRY_SHADER);
-    glAttachShader(_handle, geometryShader);
-    _geometryShaders.push_back(geometryShader);
+    _shaderSources.push_back({GL_GEOMETRY_SHADER, preprocess(code, ""), ""});
 }
 
 void GLSLProgram::attachFragmentShader(const std::string& code) {
-    GLuint fragmentShader = createShader(code, GL_FRAGMENT_SHADER);
-    glAttachShader(_handle, fragmentShader);
-    _fragmentShaders.push_back(fragmentShader);
+    _shaderSources.push_back({GL_FRAGMENT_SHADER, preprocess(code, ""), ""});
 }
 
 void GLSLProgram::attachVertexShaderFromFile(const std::string& filePath) {
-    const std::string& code = readFile(filePath);
-    try {
-        attachVertexShader(code);
-    } catch (const std::runtime_error&) {
-        std::cerr << "Compile " << filePath << " error" << std::endl;
-        throw;
-    }
+    const std::string directory = std::filesystem::path(filePath).parent_path().string();
+    _shaderSources.push_back(
+        {GL_VERTEX_SHADER, preprocess(readFile(filePath), directory), filePath});
 }
 
 void GLSLProgram::attachGeometryShaderFromFile(const std::string& filePath) {
-    const std::string& code = readFile(filePath);
-    try {
-        attachGeometryShader(code);
-    } catch (const std::runtime_error&) {
-        std::cerr << "Compile " << filePath << " error" << std::endl;
-        throw;
-    }
+    const std::string directory = std::filesystem::path(filePath).parent_path().string();
+    _shaderSources.push_back(
+        {GL_GEOMETRY_SHADER, preprocess(readFile(filePath), directory), filePath});
 }
 
 void GLSLProgram::attachFragmentShaderFromFile(const std::string& filePath) {
-    const std::string& code = readFile(filePath);
-    try {
-        attachFragmentShader(code);
-    } catch (const std::runtime_error&) {
-        std::cerr << "Compile " << filePath << " error" << std::endl;
-        throw;
-    }
+    const std::string directory = std::filesystem::path(filePath).parent_path().string();
+    _shaderSources.push_back(
+        {GL_FRAGMENT_SHADER, preprocess(readFile(filePath), directory), filePath});
+}
+
+void GLSLProgram::addDefine(const std::string& name, const std::string& value) {
+    _defines.push_back(value.empty() ? name : name + " " + value);
 }
 
 void GLSLProgram::setTransformFeedbackVaryings(
     const std::vector<const char*>& varyings, GLenum bufferMode) {
     glTransformFeedbackVaryings(
         _handle, static_cast<GLsizei>(varyings.size()), varyings.data(), bufferMode);
+
+    _transformFeedbackVaryings.assign(varyings.begin(), varyings.end());
+    _transformFeedbackBufferMode = bufferMode;
 }
 
 void GLSLProgram::link() {
+    beginLink();
+    finishLink();
+}
+
+void GLSLProgram::beginLink() {
+    const bool useBinaryCache = !_binaryCacheDirectory.empty();
+    _binaryKey = useBinaryCache ? computeBinaryKey() : 0;
+    if (useBinaryCache && loadBinary(_binaryKey)) {
+        _linkState = LinkState::LoadedFromBinary;
+        return;
+    }
+
+    compileShaders();
+
+    if (useBinaryCache) {
+        glProgramParameteri(_handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
     glLinkProgram(_handle);
+    _linkState = LinkState::Linking;
+}
 
-    GLint success;
-    glGetProgramiv(_handle, GL_LINK_STATUS, &success);
-    if (!success) {
-        char buffer[1024];
-        glGetProgramInfoLog(_handle, sizeof(buffer), NULL, buffer);
-        throw std::runtime_error("link program error: " + std::string(buffer));
+bool GLSLProgram::isLinked() const {
+    return _linkState == LinkState::Linked;
+}
+
+bool GLSLProgram::isLinkComplete() const {
+    if (_linkState != LinkState::Linking || !_parallelCompileSupported) {
+        return true;
+    }
+
+    GLint completed = GL_FALSE;
+    glGetProgramiv(_handle, GL_COMPLETION_STATUS_KHR, &completed);
+    return completed == GL_TRUE;
+}
+
+void GLSLProgram::finishLink() {
+    if (_linkState == LinkState::Linked) {
+        return;
     }
+
+    if (_linkState == LinkState::Linking) {
+        GLint success;
+        glGetProgramiv(_handle, GL_LINK_STATUS, &success);
+        if (!success) {
+            // report the compile error of the shader first, which fails the link as well
+            for (const auto& source : _shaderSources) {
+                checkShader(source);
+            }
+
+            char buffer[1024];
+            glGetProgramInfoLog(_handle, sizeof(buffer), NULL, buffer);
+            throw std::runtime_error("link program error: " + std::string(buffer));
+        }
+
+        if (!_binaryCacheDirectory.empty()) {
+            saveBinary(_binaryKey);
+        }
+    }
+
+    _linkState = LinkState::Linked;
+    buildUniformLocationTable();
 }
 
 void GLSLProgram::use() {
-    glUseProgram(_handle);
+    GLStateCache::useProgram(_handle);
 }
 
 void GLSLProgram::unuse() {
-    glUseProgram(0);
+    GLStateCache::useProgram(0);
 }
 
 int GLSLProgram::getUniformBlockSize(const std::string& name) const {
@@ -154,7 +254,7 @@ int GLSLProgram::getUniformBlockVariableOffset(const std::string& name) const {
 }
 
 void GLSLProgram::setUniformBool(const std::string& name, bool value) const {
-    GLint location = glGetUniformLocation(_handle, name.c_str());
+    GLint location = getUniformLocation(name);
     if (location == -1) {
         std::cerr << "find uniform " + name + " location failure" << std::endl;
     }
@@ -163,7 +263,7 @@ void GLSLProgram::setUniformBool(const std::string& name, bool value) const {
 }
 
 void GLSLProgram::setUniformInt(const std::string& name, int value) const {
-    GLint location = glGetUniformLocation(_handle, name.c_str());
+    GLint location = getUniformLocation(name);
     if (location == -1) {
         std::cerr << "find uniform " + name + " location failure" << std::endl;
     }
@@ -172,7 +272,7 @@ void GLSLProgram::setUniformInt(const std::string& name, int value) const {
 }
 
 void GLSLProgram::setUniformUint(const std::string& name, uint32_t value) const {
-    GLint location = glGetUniformLocation(_handle, name.c_str());
+    GLint location = getUniformLocation(name);
     if (location == -1) {
         std::cerr << "find uniform " + name + " location failure" << std::endl;
     }
@@ -181,7 +281,7 @@ void GLSLProgram::setUniformUint(const std::string& name, uint32_t value) const
 }
 
 void GLSLProgram::setUniformFloat(const std::string& name, float value) const {
-    GLint location = glGetUniformLocation(_handle, name.c_str());
+    GLint location = getUniformLocation(name);
     if (location == -1) {
         std::cerr << "find uniform " + name + " location failure" << std::endl;
     }
@@ -190,7 +290,7 @@ void GLSLProgram::setUniformFloat(const std::string& name, float value) const {
 }
 
 void GLSLProgram::setUniformVec2(const std::string& name, const glm::vec2& v2) const {
-    GLint location = glGetUniformLocation(_handle, name.c_str());
+    GLint location = getUniformLocation(name);
     if (location == -1) {
         std::cerr << "find uniform " + name + " location failure" << std::endl;
     }
@@ -199,7 +299,7 @@ void GLSLProgram::setUniformVec2(const std::string& name, const glm::vec2& v2) c
 }
 
 void GLSLProgram::setUniformVec3(const std::string& name, const glm::vec3& v3) const {
-    GLint location = glGetUniformLocation(_handle, name.c_str());
+    GLint location = getUniformLocation(name);
     if (location == -1) {
         std::cerr << "find uniform " + name + " location failure" << std::endl;
     }
@@ -208,7 +308,7 @@ void GLSLProgram::setUniformVec3(const std::string& name, const glm::vec3& v3) c
 }
 
 void GLSLProgram::setUniformVec4(const std::string& name, const glm::vec4& v4) const {
-    GLint location = glGetUniformLocation(_handle, name.c_str());
+    GLint location = getUniformLocation(name);
     if (location == -1) {
         std::cerr << "find uniform " + name + " location failure" << std::endl;
     }
@@ -217,7 +317,7 @@ void GLSLProgram::setUniformVec4(const std::string& name, const glm::vec4& v4) c
 }
 
 void GLSLProgram::setUniformMat2(const std::string& name, const glm::mat2& mat2) const {
-    GLint location = glGetUniformLocation(_handle, name.c_str());
+    GLint location = getUniformLocation(name);
     if (location == -1) {
         std::cerr << "find uniform " + name + " location failure" << std::endl;
     }
@@ -226,7 +326,7 @@ void GLSLProgram::setUniformMat2(const std::string& name, const glm::mat2& mat2)
 }
 
 void GLSLProgram::setUniformMat3(const std::string& name, const glm::mat3& mat3) const {
-    GLint location = glGetUniformLocation(_handle, name.c_str());
+    GLint location = getUniformLocation(name);
     if (location == -1) {
         std::cerr << "find uniform " + name + " location failure" << std::endl;
     }
@@ -235,7 +335,7 @@ void GLSLProgram::setUniformMat3(const std::string& name, const glm::mat3& mat3)
 }
 
 void GLSLProgram::setUniformMat4(const std::string& name, const glm::mat4& mat4) const {
-    GLint location = glGetUniformLocation(_handle, name.c_str());
+    GLint location = getUniformLocation(name);
     if (location == -1) {
         std::cerr << "find uniform " + name + " location failure" << std::endl;
     }
@@ -252,6 +352,186 @@ void GLSLProgram::setUniformBlockBinding(const std::string& name, uint32_t bindi
     glUniformBlockBinding(_handle, blockIndex, binding);
 }
 
+GLint GLSLProgram::getUniformLocation(const std::string& name) const {
+    auto it = std::lower_bound(
+        _uniformLocations.begin(), _uniformLocations.end(), name,
+        [](const UniformLocation& lhs, const std::string& rhs) { return lhs.name < rhs; });
+    if (it == _uniformLocations.end() || it->name != name) {
+        return -1;
+    }
+
+    return it->location;
+}
+
+GLint GLSLProgram::resolveUniformLocation(const std::string& name) const {
+    GLint location = getUniformLocation(name);
+    if (location == -1) {
+        std::cerr << "find uniform " + name + " location failure" << std::endl;
+    }
+
+    return location;
+}
+
+void GLSLProgram::setUniform(UniformHandle<bool> handle, bool value) const {
+    glUniform1i(handle.location, static_cast<int>(value));
+}
+
+void GLSLProgram::setUniform(UniformHandle<int> handle, int value) const {
+    glUniform1i(handle.location, value);
+}
+
+void GLSLProgram::setUniform(UniformHandle<uint32_t> handle, uint32_t value) const {
+    glUniform1ui(handle.location, value);
+}
+
+void GLSLProgram::setUniform(UniformHandle<float> handle, float value) const {
+    glUniform1f(handle.location, value);
+}
+
+void GLSLProgram::setUniform(UniformHandle<glm::vec2> handle, const glm::vec2& v2) const {
+    glUniform2fv(handle.location, 1, glm::value_ptr(v2));
+}
+
+void GLSLProgram::setUniform(UniformHandle<glm::vec3> handle, const glm::vec3& v3) const {
+    glUniform3fv(handle.location, 1, glm::value_ptr(v3));
+}
+
+void GLSLProgram::setUniform(UniformHandle<glm::vec4> handle, const glm::vec4& v4) const {
+    glUniform4fv(handle.location, 1, glm::value_ptr(v4));
+}
+
+void GLSLProgram::setUniform(UniformHandle<glm::mat2> handle, const glm::mat2& mat2) const {
+    glUniformMatrix2fv(handle.location, 1, GL_FALSE, glm::value_ptr(mat2));
+}
+
+void GLSLProgram::setUniform(UniformHandle<glm::mat3> handle, const glm::mat3& mat3) const {
+    glUniformMatrix3fv(handle.location, 1, GL_FALSE, glm::value_ptr(mat3));
+}
+
+void GLSLProgram::setUniform(UniformHandle<glm::mat4> handle, const glm::mat4& mat4) const {
+    glUniformMatrix4fv(handle.location, 1, GL_FALSE, glm::value_ptr(mat4));
+}
+
+void GLSLProgram::buildUniformLocationTable() {
+    _uniformLocations.clear();
+
+    GLint uniformCount = 0;
+    glGetProgramiv(_handle, GL_ACTIVE_UNIFORMS, &uniformCount);
+
+    GLint maxNameLength = 0;
+    glGetProgramiv(_handle, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+    std::vector<char> nameBuffer(std::max(maxNameLength, 1));
+
+    for (GLint i = 0; i < uniformCount; ++i) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = GL_NONE;
+        glGetActiveUniform(
+            _handle, static_cast<GLuint>(i), static_cast<GLsizei>(nameBuffer.size()), &length,
+            &size, &type, nameBuffer.data());
+
+        std::string name(nameBuffer.data(), length);
+        GLint location = glGetUniformLocation(_handle, name.c_str());
+        // members of uniform blocks have no location
+        if (location == -1) {
+            continue;
+        }
+
+        // an array is reported once as name[0], register the base name and every element
+        const std::string suffix = "[0]";
+        const bool isArray =
+            name.size() > suffix.size()
+            && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+        if (!isArray) {
+            _uniformLocations.push_back({name, location});
+            continue;
+        }
+
+        const std::string baseName = name.substr(0, name.size() - suffix.size());
+        _uniformLocations.push_back({baseName, location});
+        _uniformLocations.push_back({name, location});
+        for (GLint j = 1; j < size; ++j) {
+            const std::string elementName = baseName + "[" + std::to_string(j) + "]";
+            _uniformLocations.push_back(
+                {elementName, glGetUniformLocation(_handle, elementName.c_str())});
+        }
+    }
+
+    std::sort(
+        _uniformLocations.begin(), _uniformLocations.end(),
+        [](const UniformLocation& lhs, const UniformLocation& rhs) { return lhs.name < rhs.name; });
+}
+
+std::string GLSLProgram::preprocess(const std::string& code, const std::string& directory) const {
+    std::vector<std::string> includedFiles;
+    std::string result = resolveIncludes(code, directory, includedFiles);
+    if (_defines.empty()) {
+        return result;
+    }
+
+    std::string defines;
+    for (const auto& define : _defines) {
+        defines += "#define " + define + "\n";
+    }
+
+    // nothing but comments may precede the #version directive
+    size_t position = 0;
+    const size_t versionPosition = result.find("#version");
+    if (versionPosition != std::string::npos) {
+        position = result.find('\n', versionPosition);
+        if (position == std::string::npos) {
+            result += '\n';
+            position = result.size();
+        } else {
+            position += 1;
+        }
+    }
+
+    result.insert(position, defines);
+
+    return result;
+}
+
+std::string GLSLProgram::resolveIncludes(
+    const std::string& code, const std::string& directory,
+    std::vector<std::string>& includedFiles) {
+    const std::string directive = "#include";
+
+    std::istringstream is(code);
+    std::string result;
+    std::string line;
+    while (std::getline(is, line)) {
+        const size_t begin = line.find_first_not_of(" \t");
+        if (begin == std::string::npos || line.compare(begin, directive.size(), directive) != 0) {
+            result += line + "\n";
+            continue;
+        }
+
+        const size_t open = line.find('"', begin + directive.size());
+        const size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+        if (close == std::string::npos) {
+            throw std::runtime_error("invalid include directive: " + line);
+        }
+
+        // the path is relative to the including file
+        const std::filesystem::path path =
+            (std::filesystem::path(directory) / line.substr(open + 1, close - open - 1))
+                .lexically_normal();
+        const std::string filePath = path.generic_string();
+
+        // every file is included once, which also breaks include cycles
+        if (std::find(includedFiles.begin(), includedFiles.end(), filePath)
+            != includedFiles.end()) {
+            continue;
+        }
+
+        includedFiles.push_back(filePath);
+        result += resolveIncludes(readFile(filePath), path.parent_path().string(), includedFiles);
+    }
+
+    return result;
+}
+
 std::string GLSLProgram::readFile(const std::string& filePath) {
     std::ifstream is;
     is.exceptions(std::ifstream::failbit | std::ifstream::badbit);
@@ -267,6 +547,204 @@ std::string GLSLProgram::readFile(const std::string& filePath) {
     }
 }
 
+void GLSLProgram::initParallelCompile(GLADloadfunc load) {
+    _parallelCompileSupported = hasExtension("GL_KHR_parallel_shader_compile")
+                                || hasExtension("GL_ARB_parallel_shader_compile");
+    if (!_parallelCompileSupported) {
+        return;
+    }
+
+    // the extensions are not in the generated loader, fetch the entry point by name
+    using MaxShaderCompilerThreadsFunc = void(GLAD_API_PTR*)(GLuint);
+    auto maxShaderCompilerThreads =
+        reinterpret_cast<MaxShaderCompilerThreadsFunc>(load("glMaxShaderCompilerThreadsKHR"));
+    if (maxShaderCompilerThreads == nullptr) {
+        maxShaderCompilerThreads =
+            reinterpret_cast<MaxShaderCompilerThreadsFunc>(load("glMaxShaderCompilerThreadsARB"));
+    }
+
+    // let the driver use as many threads as it likes
+    if (maxShaderCompilerThreads != nullptr) {
+        maxShaderCompilerThreads(0xFFFFFFFFu);
+    }
+}
+
+bool GLSLProgram::isParallelCompileSupported() {
+    return _parallelCompileSupported;
+}
+
+void GLSLProgram::setBinaryCacheDirectory(const std::string& directory, GLADloadfunc load) {
+    _binaryCacheDirectory.clear();
+    if (directory.empty()) {
+        return;
+    }
+
+    // program binaries are core since opengl 4.1 and offered by ARB_get_program_binary to
+    // the older contexts, whose entry points the loader leaves out. they have the core names
+    bool binarySupported = GLAD_GL_VERSION_4_1;
+    if (!binarySupported && hasExtension("GL_ARB_get_program_binary")) {
+        glad_glGetProgramBinary =
+            reinterpret_cast<PFNGLGETPROGRAMBINARYPROC>(load("glGetProgramBinary"));
+        glad_glProgramBinary = reinterpret_cast<PFNGLPROGRAMBINARYPROC>(load("glProgramBinary"));
+        glad_glProgramParameteri =
+            reinterpret_cast<PFNGLPROGRAMPARAMETERIPROC>(load("glProgramParameteri"));
+        binarySupported = glGetProgramBinary != nullptr && glProgramBinary != nullptr
+                          && glProgramParameteri != nullptr;
+    }
+
+    // some drivers support no format at all
+    GLint formatCount = 0;
+    if (binarySupported) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    }
+
+    if (formatCount == 0) {
+        std::cerr << "program binary is not supported, shader cache disabled" << std::endl;
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        std::cerr << "create shader cache " + directory + " failure: " << error.message()
+                  << std::endl;
+        return;
+    }
+
+    _binaryCacheDirectory = directory;
+}
+
+void GLSLProgram::compileShaders() {
+    // the compile status is not queried here, which would wait for the compilation
+    for (auto& source : _shaderSources) {
+        source.shader = createShader(source.code, source.type);
+        glAttachShader(_handle, source.shader);
+        switch (source.type) {
+        case GL_VERTEX_SHADER: _vertexShaders.push_back(source.shader); break;
+        case GL_GEOMETRY_SHADER: _geometryShaders.push_back(source.shader); break;
+        case GL_FRAGMENT_SHADER: _fragmentShaders.push_back(source.shader); break;
+        }
+    }
+}
+
+void GLSLProgram::checkShader(const ShaderSource& source) {
+    GLint success;
+    glGetShaderiv(source.shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char buffer[1024];
+        glGetShaderInfoLog(source.shader, sizeof(buffer), nullptr, buffer);
+        std::cerr << source.code << std::endl;
+        if (!source.filePath.empty()) {
+            std::cerr << "Compile " << source.filePath << " error" << std::endl;
+        }
+        throw std::runtime_error("compile error: \n" + std::string(buffer));
+    }
+}
+
+uint64_t GLSLProgram::computeBinaryKey() const {
+    // a binary is only valid for the same driver, so the driver strings are a part of the key
+    uint64_t hash = 0xcbf29ce484222325ull;
+    hash = hashString(reinterpret_cast<const char*>(glGetString(GL_RENDERER)), hash);
+    hash = hashString(reinterpret_cast<const char*>(glGetString(GL_VERSION)), hash);
+
+    for (const auto& source : _shaderSources) {
+        hash = hashBytes(&source.type, sizeof(source.type), hash);
+        hash = hashString(source.code, hash);
+    }
+
+    for (const auto& varying : _transformFeedbackVaryings) {
+        hash = hashString(varying, hash);
+    }
+    hash = hashBytes(&_transformFeedbackBufferMode, sizeof(_transformFeedbackBufferMode), hash);
+
+    return hash;
+}
+
+std::string GLSLProgram::getBinaryPath(uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(_binaryCacheDirectory) / name).string();
+}
+
+bool GLSLProgram::loadBinary(uint64_t key) {
+    std::ifstream is(getBinaryPath(key), std::ios::binary);
+    if (!is) {
+        return false;
+    }
+
+    ProgramBinaryHeader header;
+    if (!is.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || header.magic != programBinaryMagic) {
+        return false;
+    }
+
+    // the length is not trusted for the allocation, it must cover the rest of the file
+    const std::streampos binaryBegin = is.tellg();
+    is.seekg(0, std::ios::end);
+    const std::streamoff binaryLength = is.tellg() - binaryBegin;
+    is.seekg(binaryBegin);
+    if (!is || binaryLength != static_cast<std::streamoff>(header.length)) {
+        return false;
+    }
+
+    std::vector<char> binary(header.length);
+    if (!is.read(binary.data(), binary.size())) {
+        return false;
+    }
+
+    glProgramBinary(_handle, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+    // the driver rejects binaries of another format or version, compile from the sources then
+    GLint success = GL_FALSE;
+    glGetProgramiv(_handle, GL_LINK_STATUS, &success);
+    if (success != GL_TRUE) {
+        while (glGetError() != GL_NO_ERROR) {}
+        return false;
+    }
+
+    return true;
+}
+
+void GLSLProgram::saveBinary(uint64_t key) const {
+    GLint length = 0;
+    glGetProgramiv(_handle, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    std::vector<char> binary(length);
+    GLenum format = GL_NONE;
+    glGetProgramBinary(_handle, length, nullptr, &format, binary.data());
+
+    const ProgramBinaryHeader header = {
+        programBinaryMagic, static_cast<uint32_t>(format), static_cast<uint32_t>(length)};
+
+    // write a temporary file and rename it over the binary, so that a crash or another run
+    // writing the same binary never leaves a torn file behind
+    const std::string path = getBinaryPath(key);
+    const std::string tempPath = path + "." + std::to_string(std::random_device()()) + ".tmp";
+    {
+        std::ofstream os(tempPath, std::ios::binary | std::ios::trunc);
+        os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        os.write(binary.data(), binary.size());
+        if (!os) {
+            std::cerr << "write program binary " + path + " failure" << std::endl;
+            os.close();
+            std::error_code error;
+            std::filesystem::remove(tempPath, error);
+            return;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        std::cerr << "write program binary " + path + " failure: " << error.message()
+                  << std::endl;
+        std::filesystem::remove(tempPath, error);
+    }
+}
+
 GLuint GLSLProgram::createShader(const std::string& code, GLenum shaderType) {
     GLuint shader = glCreateShader(shaderType);
     if (shader == 0) {
@@ -277,14 +755,96 @@ GLuint GLSLProgram::createShader(const std::string& code, GLenum shaderType) {
     glShaderSource(shader, 1, &codeBuf, nullptr);
     glCompileShader(shader);
 
-    GLint success;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        char buffer[1024];
-        glGetShaderInfoLog(shader, sizeof(buffer), nullptr, buffer);
-        std::cerr << code << std::endl;
-        throw std::runtime_error("compile error: \n" + std::string(buffer));
+    return shader;
+}
+
+void GLSLProgramBatch::add(GLSLProgram& program) {
+    program.beginLink();
+    _pending.push_back(&program);
+}
+
+bool GLSLProgramBatch::poll() {
+    if (!GLSLProgram::isParallelCompileSupported()) {
+        // without the completion query, finish one program per call to spread the stalls
+        if (!_pending.empty()) {
+            _pending.front()->finishLink();
+            _pending.erase(_pending.begin());
+        }
+
+        return _pending.empty();
     }
 
-    return shader;
+    for (auto it = _pending.begin(); it != _pending.end();) {
+        if ((*it)->isLinkComplete()) {
+            (*it)->finishLink();
+            it = _pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    return _pending.empty();
+}
+
+void GLSLProgramBatch::finish() {
+    for (auto program : _pending) {
+        program->finishLink();
+    }
+
+    _pending.clear();
+}
+
+size_t GLSLProgramBatch::getPendingCount() const {
+    return _pending.size();
+}
+
+GLSLProgramVariants::GLSLProgramVariants(
+    const std::string& vertexShaderPath, const std::string& fragmentShaderPath,
+    const std::vector<std::string>& features)
+    : _vertexShaderPath(vertexShaderPath), _fragmentShaderPath(fragmentShaderPath),
+      _features(features) {
+    if (_features.size() > 32) {
+        throw std::runtime_error("a program supports at most 32 features");
+    }
+}
+
+GLSLProgram& GLSLProgramVariants::get(uint32_t featureMask) {
+    auto it = _variants.find(featureMask);
+    if (it == _variants.end()) {
+        it = _variants.emplace(featureMask, create(featureMask)).first;
+        it->second->beginLink();
+    }
+
+    // a prepared variant may still be linking in a batch
+    it->second->finishLink();
+
+    return *it->second;
+}
+
+GLSLProgram& GLSLProgramVariants::prepare(uint32_t featureMask, GLSLProgramBatch& batch) {
+    auto it = _variants.find(featureMask);
+    if (it == _variants.end()) {
+        it = _variants.emplace(featureMask, create(featureMask)).first;
+        batch.add(*it->second);
+    }
+
+    return *it->second;
+}
+
+size_t GLSLProgramVariants::getVariantCount() const {
+    return _variants.size();
+}
+
+std::unique_ptr<GLSLProgram> GLSLProgramVariants::create(uint32_t featureMask) const {
+    std::unique_ptr<GLSLProgram> program(new GLSLProgram);
+    for (size_t i = 0; i < _features.size(); ++i) {
+        if (featureMask & (1u << i)) {
+            program->addDefine(_features[i]);
+        }
+    }
+
+    program->attachVertexShaderFromFile(_vertexShaderPath);
+    program->attachFragmentShaderFromFile(_fragmentShaderPath);
+
+    return program;
 }
\ No newline at end of file
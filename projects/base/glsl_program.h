@@ -1,12 +1,25 @@
 #pragma once
 
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <glm/glm.hpp>
 
 #include "gl_utility.h"
 
+// location of a uniform resolved once by name, the type selects the matching setter.
+// the handle stays valid until the program is linked again.
+template <typename T>
+struct UniformHandle {
+    GLint location = -1;
+
+    bool valid() const {
+        return location != -1;
+    }
+};
+
 class GLSLProgram {
 public:
     GLSLProgram();
@@ -15,6 +28,11 @@ public:
 
     ~GLSLProgram();
 
+    // define a macro in the shaders attached afterwards, right after their #version directive
+    void addDefine(const std::string& name, const std::string& value = "");
+
+    // the attached shaders may #include "file" relative to the including file,
+    // a file is included only once per shader
     void attachVertexShader(const std::string& code);
 
     void attachGeometryShader(const std::string& filePath);
@@ -29,8 +47,21 @@ public:
 
     void setTransformFeedbackVaryings(const std::vector<const char*>& varyings, GLenum bufferMode);
 
+    // compile the attached shaders and link them, or load the program from the binary cache
+    // when a binary of the same sources and driver exists
     void link();
 
+    // link() in two steps: beginLink() only submits the work to the driver, which may
+    // compile in the background, finishLink() waits for it and reports the errors
+    void beginLink();
+
+    // whether finishLink() would not block, always true without parallel compilation support
+    bool isLinkComplete() const;
+
+    void finishLink();
+
+    bool isLinked() const;
+
     void use();
 
     void unuse();
@@ -63,9 +94,83 @@ public:
 
     void setUniformBlockBinding(const std::string& name, uint32_t binding) const;
 
+    // look up the location in the table built by link(), -1 for inactive uniforms
+    GLint getUniformLocation(const std::string& name) const;
+
+    template <typename T>
+    UniformHandle<T> getUniformHandle(const std::string& name) const {
+        UniformHandle<T> handle;
+        handle.location = resolveUniformLocation(name);
+        return handle;
+    }
+
+    void setUniform(UniformHandle<bool> handle, bool value) const;
+
+    void setUniform(UniformHandle<int> handle, int value) const;
+
+    void setUniform(UniformHandle<uint32_t> handle, uint32_t value) const;
+
+    void setUniform(UniformHandle<float> handle, float value) const;
+
+    void setUniform(UniformHandle<glm::vec2> handle, const glm::vec2& v2) const;
+
+    void setUniform(UniformHandle<glm::vec3> handle, const glm::vec3& v3) const;
+
+    void setUniform(UniformHandle<glm::vec4> handle, const glm::vec4& v4) const;
+
+    void setUniform(UniformHandle<glm::mat2> handle, const glm::mat2& mat2) const;
+
+    void setUniform(UniformHandle<glm::mat3> handle, const glm::mat3& mat3) const;
+
+    void setUniform(UniformHandle<glm::mat4> handle, const glm::mat4& mat4) const;
+
+    // store linked program binaries in the directory and reuse them in later runs,
+    // an empty directory disables the cache. it needs a current opengl context, load
+    // fetches the entry points of ARB_get_program_binary for the contexts before 4.1
+    static void setBinaryCacheDirectory(const std::string& directory, GLADloadfunc load);
+
+    // detect KHR_parallel_shader_compile and let the driver compile on its own threads.
+    // it needs a current opengl context.
+    static void initParallelCompile(GLADloadfunc load);
+
+    static bool isParallelCompileSupported();
+
 private:
+    struct UniformLocation {
+        std::string name;
+        GLint location;
+    };
+
+    struct ShaderSource {
+        GLenum type;
+        std::string code;
+        std::string filePath;
+        GLuint shader = 0;
+    };
+
+    enum class LinkState {
+        Unlinked,
+        Linking,
+        LoadedFromBinary,
+        Linked
+    };
+
     GLuint _handle = 0;
 
+    LinkState _linkState = LinkState::Unlinked;
+    uint64_t _binaryKey = 0;
+
+    std::vector<std::string> _defines;
+
+    // shaders are compiled in beginLink() so that a cached binary skips the compilation
+    std::vector<ShaderSource> _shaderSources;
+
+    std::vector<std::string> _transformFeedbackVaryings;
+    GLenum _transformFeedbackBufferMode = GL_NONE;
+
+    // active uniforms outside uniform blocks sorted by name
+    std::vector<UniformLocation> _uniformLocations;
+
     std::vector<GLuint> _vertexShaders;
 
     std::vector<GLuint> _geometryShaders;
@@ -74,5 +179,78 @@ private:
 
     static std::string readFile(const std::string& filePath);
 
+    std::string preprocess(const std::string& code, const std::string& directory) const;
+
+    static std::string resolveIncludes(
+        const std::string& code, const std::string& directory,
+        std::vector<std::string>& includedFiles);
+
+    static std::string _binaryCacheDirectory;
+
+    static bool _parallelCompileSupported;
+
     static GLuint createShader(const std::string& code, GLenum shaderType);
+
+    void compileShaders();
+
+    static void checkShader(const ShaderSource& source);
+
+    uint64_t computeBinaryKey() const;
+
+    std::string getBinaryPath(uint64_t key) const;
+
+    bool loadBinary(uint64_t key);
+
+    void saveBinary(uint64_t key) const;
+
+    void buildUniformLocationTable();
+
+    // getUniformLocation with a warning for inactive uniforms
+    GLint resolveUniformLocation(const std::string& name) const;
+};
+
+// link several programs together so that the driver can compile them in parallel,
+// the application keeps rendering frames while poll() returns false
+class GLSLProgramBatch {
+public:
+    // start linking the program, all shaders must have been attached
+    void add(GLSLProgram& program);
+
+    // finish the programs whose compilation has completed, true when all are linked
+    bool poll();
+
+    // wait for all programs to be linked
+    void finish();
+
+    size_t getPendingCount() const;
+
+private:
+    std::vector<GLSLProgram*> _pending;
+};
+
+// the programs of one vertex and fragment shader specialized by features. feature i is
+// enabled by bit i of the mask and defined as a macro in both shaders, so a variant only
+// contains the code paths it uses. variants are compiled on their first request.
+class GLSLProgramVariants {
+public:
+    GLSLProgramVariants(
+        const std::string& vertexShaderPath, const std::string& fragmentShaderPath,
+        const std::vector<std::string>& features);
+
+    // the linked variant, it blocks when the variant has to be compiled
+    GLSLProgram& get(uint32_t featureMask);
+
+    // start compiling the variant in the batch ahead of its use
+    GLSLProgram& prepare(uint32_t featureMask, GLSLProgramBatch& batch);
+
+    size_t getVariantCount() const;
+
+private:
+    std::string _vertexShaderPath;
+    std::string _fragmentShaderPath;
+    std::vector<std::string> _features;
+
+    std::unordered_map<uint32_t, std::unique_ptr<GLSLProgram>> _variants;
+
+    std::unique_ptr<GLSLProgram> create(uint32_t featureMask) const;
 };
\ No newline at end of file
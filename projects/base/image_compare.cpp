@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include "image_compare.h"
+
+namespace {
+// d65 white point
+const glm::vec3 whitePoint = glm::vec3(0.950428545f, 1.0f, 1.088900371f);
+
+// blur of the achromatic and the chromatic channels in pixels, a rough stand-in for the
+// contrast sensitivity of the eye at about 67 pixels per degree
+constexpr float achromaticSigma = 0.8f;
+constexpr float chromaticSigma = 1.6f;
+
+// the FLIP constants of the color error mapping and the feature error exponent
+constexpr float hyabExponent = 0.7f;
+constexpr float colorCutoff = 0.4f;
+constexpr float colorTarget = 0.95f;
+constexpr float featureExponent = 0.5f;
+
+float srgbToLinear(uint8_t value) {
+    const float c = value / 255.0f;
+    return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+glm::vec3 linearRgbToXyz(const glm::vec3& c) {
+    return glm::vec3(
+        0.4124564f * c.r + 0.3575761f * c.g + 0.1804375f * c.b,
+        0.2126729f * c.r + 0.7151522f * c.g + 0.0721750f * c.b,
+        0.0193339f * c.r + 0.1191920f * c.g + 0.9503041f * c.b);
+}
+
+// the linear opponent space FLIP filters in
+glm::vec3 xyzToYcxcz(const glm::vec3& xyz) {
+    const glm::vec3 n = xyz / whitePoint;
+    return glm::vec3(116.0f * n.y - 16.0f, 500.0f * (n.x - n.y), 200.0f * (n.y - n.z));
+}
+
+glm::vec3 ycxczToXyz(const glm::vec3& c) {
+    const float y = (c.x + 16.0f) / 116.0f;
+    return glm::vec3(c.y / 500.0f + y, y, y - c.z / 200.0f) * whitePoint;
+}
+
+glm::vec3 xyzToLab(const glm::vec3& xyz) {
+    const float delta = 6.0f / 29.0f;
+    auto f = [delta](float t) {
+        return t > delta * delta * delta ? std::cbrt(t) : t / (3.0f * delta * delta) + 4.0f / 29.0f;
+    };
+
+    const glm::vec3 n = xyz / whitePoint;
+    const float fx = f(n.x), fy = f(n.y), fz = f(n.z);
+    return glm::vec3(116.0f * fy - 16.0f, 500.0f * (fx - fy), 200.0f * (fy - fz));
+}
+
+// hybrid of the city block distance in lightness and the euclidean one in chroma
+float hyab(const glm::vec3& a, const glm::vec3& b) {
+    const glm::vec3 d = a - b;
+    return std::abs(d.x) + std::sqrt(d.y * d.y + d.z * d.z);
+}
+
+std::vector<glm::vec3> toYcxcz(const uint8_t* image, size_t pixelCount) {
+    std::vector<glm::vec3> result(pixelCount);
+    for (size_t i = 0; i < pixelCount; ++i) {
+        const glm::vec3 linear = glm::vec3(
+            srgbToLinear(image[3 * i + 0]), srgbToLinear(image[3 * i + 1]),
+            srgbToLinear(image[3 * i + 2]));
+        result[i] = xyzToYcxcz(linearRgbToXyz(linear));
+    }
+
+    return result;
+}
+
+std::vector<float> gaussianKernel(float sigma) {
+    const int radius = static_cast<int>(std::ceil(3.0f * sigma));
+    std::vector<float> kernel(2 * radius + 1);
+    float sum = 0.0f;
+    for (int i = -radius; i <= radius; ++i) {
+        kernel[i + radius] = std::exp(-0.5f * i * i / (sigma * sigma));
+        sum += kernel[i + radius];
+    }
+
+    for (auto& weight : kernel) {
+        weight /= sum;
+    }
+
+    return kernel;
+}
+
+// separable blur with the edges clamped, the luminance and the chroma differently
+void blur(std::vector<glm::vec3>& image, int width, int height) {
+    const std::vector<float> kernels[2] = {
+        gaussianKernel(achromaticSigma), gaussianKernel(chromaticSigma)};
+    const int radii[2] = {
+        static_cast<int>(kernels[0].size() / 2), static_cast<int>(kernels[1].size() / 2)};
+
+    std::vector<glm::vec3> temp(image.size());
+    for (int pass = 0; pass < 2; ++pass) {
+        const std::vector<glm::vec3>& src = pass == 0 ? image : temp;
+        std::vector<glm::vec3>& dst = pass == 0 ? temp : image;
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                glm::vec3 sum(0.0f);
+                for (int k = 0; k < 2; ++k) {
+                    for (int i = -radii[k]; i <= radii[k]; ++i) {
+                        const int sx = pass == 0 ? std::min(std::max(x + i, 0), width - 1) : x;
+                        const int sy = pass == 0 ? y : std::min(std::max(y + i, 0), height - 1);
+                        const glm::vec3& c = src[static_cast<size_t>(sy) * width + sx];
+                        const float weight = kernels[k][i + radii[k]];
+                        if (k == 0) {
+                            sum.x += weight * c.x;
+                        } else {
+                            sum.y += weight * c.y;
+                            sum.z += weight * c.z;
+                        }
+                    }
+                }
+
+                dst[static_cast<size_t>(y) * width + x] = sum;
+            }
+        }
+    }
+}
+
+// edge and point strength of the normalized luminance, both in [0, 1]
+glm::vec2 detectFeatures(const std::vector<glm::vec3>& image, int width, int height, int x, int y) {
+    auto luminance = [&](int dx, int dy) {
+        const int sx = std::min(std::max(x + dx, 0), width - 1);
+        const int sy = std::min(std::max(y + dy, 0), height - 1);
+        return (image[static_cast<size_t>(sy) * width + sx].x + 16.0f) / 116.0f;
+    };
+
+    const float gx = luminance(1, -1) + 2.0f * luminance(1, 0) + luminance(1, 1)
+                     - luminance(-1, -1) - 2.0f * luminance(-1, 0) - luminance(-1, 1);
+    const float gy = luminance(-1, 1) + 2.0f * luminance(0, 1) + luminance(1, 1)
+                     - luminance(-1, -1) - 2.0f * luminance(0, -1) - luminance(1, -1);
+    const float laplacian = 4.0f * luminance(0, 0) - luminance(-1, 0) - luminance(1, 0)
+                            - luminance(0, -1) - luminance(0, 1);
+
+    return glm::clamp(
+        glm::vec2(0.25f * std::sqrt(gx * gx + gy * gy), 0.25f * std::abs(laplacian)), 0.0f,
+        1.0f);
+}
+}  // namespace
+
+ImageDifference compareImages(
+    const uint8_t* test, const uint8_t* reference, int width, int height) {
+    ImageDifference difference;
+    difference.width = width;
+    difference.height = height;
+
+    const size_t pixelCount = static_cast<size_t>(width) * height;
+    if (pixelCount == 0) {
+        return difference;
+    }
+
+    double squaredError = 0.0;
+    for (size_t i = 0; i < 3 * pixelCount; ++i) {
+        const double d = (static_cast<int>(test[i]) - static_cast<int>(reference[i])) / 255.0;
+        squaredError += d * d;
+    }
+
+    difference.rmse = std::sqrt(squaredError / (3 * pixelCount));
+
+    const std::vector<glm::vec3> testYcxcz = toYcxcz(test, pixelCount);
+    const std::vector<glm::vec3> referenceYcxcz = toYcxcz(reference, pixelCount);
+    std::vector<glm::vec3> testFiltered = testYcxcz;
+    std::vector<glm::vec3> referenceFiltered = referenceYcxcz;
+    blur(testFiltered, width, height);
+    blur(referenceFiltered, width, height);
+
+    // the largest color difference is the one between green and blue
+    const float maxColorError = std::pow(
+        hyab(xyzToLab(linearRgbToXyz(glm::vec3(0.0f, 1.0f, 0.0f))),
+             xyzToLab(linearRgbToXyz(glm::vec3(0.0f, 0.0f, 1.0f)))),
+        hyabExponent);
+    const float cutoff = colorCutoff * maxColorError;
+
+    difference.errorMap.resize(pixelCount);
+    double errorSum = 0.0;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const size_t i = static_cast<size_t>(y) * width + x;
+
+            const float colorDifference = std::pow(
+                hyab(xyzToLab(ycxczToXyz(testFiltered[i])),
+                     xyzToLab(ycxczToXyz(referenceFiltered[i]))),
+                hyabExponent);
+            // the differences below the cutoff take most of the error range
+            const float colorError =
+                colorDifference < cutoff
+                    ? colorTarget / cutoff * colorDifference
+                    : colorTarget
+                          + (colorDifference - cutoff) / (maxColorError - cutoff)
+                                * (1.0f - colorTarget);
+
+            const glm::vec2 testFeatures = detectFeatures(testYcxcz, width, height, x, y);
+            const glm::vec2 referenceFeatures =
+                detectFeatures(referenceYcxcz, width, height, x, y);
+            const glm::vec2 featureDifference = glm::abs(testFeatures - referenceFeatures);
+            const float featureError = std::pow(
+                std::max(featureDifference.x, featureDifference.y) / std::sqrt(2.0f),
+                featureExponent);
+
+            const float error =
+                std::min(std::pow(std::min(colorError, 1.0f), 1.0f - featureError), 1.0f);
+            difference.errorMap[i] = error;
+            difference.maxError = std::max(difference.maxError, static_cast<double>(error));
+            errorSum += error;
+        }
+    }
+
+    difference.meanError = errorSum / pixelCount;
+
+    return difference;
+}
+
+std::vector<uint8_t> renderErrorMap(const ImageDifference& difference) {
+    std::vector<uint8_t> image(3 * difference.errorMap.size());
+    for (size_t i = 0; i < difference.errorMap.size(); ++i) {
+        const float t = 3.0f * std::min(std::max(difference.errorMap[i], 0.0f), 1.0f);
+        const glm::vec3 color = glm::clamp(glm::vec3(t, t - 1.0f, t - 2.0f), 0.0f, 1.0f);
+        image[3 * i + 0] = static_cast<uint8_t>(255.0f * color.r + 0.5f);
+        image[3 * i + 1] = static_cast<uint8_t>(255.0f * color.g + 0.5f);
+        image[3 * i + 2] = static_cast<uint8_t>(255.0f * color.b + 0.5f);
+    }
+
+    return image;
+}
\ No newline at end of file
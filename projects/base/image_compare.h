@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct ImageDifference {
+    // root mean square error of the srgb channels in [0, 1]
+    double rmse = 0.0;
+    // mean and max of the perceptual error in [0, 1]
+    double meanError = 0.0;
+    double maxError = 0.0;
+    int width = 0;
+    int height = 0;
+    // perceptual error of every pixel, rows from the top
+    std::vector<float> errorMap;
+};
+
+// compare a test image with a reference one, both tightly packed srgb rgb8 rows of the same
+// size. the perceptual error follows FLIP (Andersson et al. 2020) in a simplified form:
+// the color difference is taken in a blurred opponent space and amplified where the edges
+// and points of the two images differ
+ImageDifference compareImages(
+    const uint8_t* test, const uint8_t* reference, int width, int height);
+
+// the error map as a black, red, yellow and white heat map in rgb8
+std::vector<uint8_t> renderErrorMap(const ImageDifference& difference);
\ No newline at end of file
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "input.h"
+
+// per frame input and delta time of a run, replayed to drive another run the same way.
+// the key states are stored as the changes from the previous frame. ImGui reads the events
+// through its own glfw callbacks, so the interaction with the ui is not recorded
+class InputRecording {
+public:
+    void record(const Input& input, float deltaTime) {
+        Frame frame;
+        frame.deltaTime = deltaTime;
+        frame.mouse = input.mouse;
+        frame.firstKeyChange = static_cast<uint32_t>(_keyChanges.size());
+
+        for (int key = 0; key < static_cast<int>(_keyStates.size()); ++key) {
+            if (input.keyboard.keyStates[key] != _keyStates[key]) {
+                _keyChanges.push_back({key, input.keyboard.keyStates[key]});
+                _keyStates[key] = input.keyboard.keyStates[key];
+            }
+        }
+
+        frame.keyChangeCount = static_cast<uint32_t>(_keyChanges.size()) - frame.firstKeyChange;
+        _frames.push_back(frame);
+    }
+
+    // overwrite the input and delta time with the next recorded frame,
+    // returns false when all the frames are replayed
+    bool replay(Input& input, float& deltaTime) {
+        if (_cursor == _frames.size()) {
+            return false;
+        }
+
+        const Frame& frame = _frames[_cursor++];
+        for (uint32_t i = 0; i < frame.keyChangeCount; ++i) {
+            const KeyChange& change = _keyChanges[frame.firstKeyChange + i];
+            _keyStates[change.key] = change.state;
+        }
+
+        input.mouse = frame.mouse;
+        input.keyboard.keyStates = _keyStates;
+        deltaTime = frame.deltaTime;
+
+        return true;
+    }
+
+    size_t getFrameCount() const {
+        return _frames.size();
+    }
+
+    void save(const std::string& filePath) const {
+        std::ofstream os(filePath, std::ios::binary);
+        if (!os) {
+            throw std::runtime_error("open " + filePath + " failure");
+        }
+
+        os.write(magic, sizeof(magic));
+        write(os, static_cast<uint32_t>(_frames.size()));
+        for (const auto& frame : _frames) {
+            write(os, frame.deltaTime);
+            write(os, frame.mouse.press.left);
+            write(os, frame.mouse.press.middle);
+            write(os, frame.mouse.press.right);
+            write(os, frame.mouse.move.xNow);
+            write(os, frame.mouse.move.yNow);
+            write(os, frame.mouse.move.xOld);
+            write(os, frame.mouse.move.yOld);
+            write(os, frame.mouse.scroll.xOffset);
+            write(os, frame.mouse.scroll.yOffset);
+            write(os, frame.keyChangeCount);
+            for (uint32_t i = 0; i < frame.keyChangeCount; ++i) {
+                const KeyChange& change = _keyChanges[frame.firstKeyChange + i];
+                write(os, static_cast<int16_t>(change.key));
+                write(os, static_cast<int16_t>(change.state));
+            }
+        }
+
+        if (!os) {
+            throw std::runtime_error("write " + filePath + " failure");
+        }
+    }
+
+    void load(const std::string& filePath) {
+        std::ifstream is(filePath, std::ios::binary);
+        if (!is) {
+            throw std::runtime_error("open " + filePath + " failure");
+        }
+
+        char fileMagic[sizeof(magic)] = {};
+        is.read(fileMagic, sizeof(fileMagic));
+        if (!is || std::string(fileMagic, sizeof(fileMagic)) != std::string(magic, sizeof(magic))) {
+            throw std::runtime_error(filePath + " is not an input recording");
+        }
+
+        *this = InputRecording();
+
+        // the counts are not trusted for allocations, a truncated file fails at its end
+        uint32_t frameCount = 0;
+        read(is, frameCount);
+        for (uint32_t frameIndex = 0; frameIndex < frameCount && is; ++frameIndex) {
+            Frame frame;
+            read(is, frame.deltaTime);
+            read(is, frame.mouse.press.left);
+            read(is, frame.mouse.press.middle);
+            read(is, frame.mouse.press.right);
+            read(is, frame.mouse.move.xNow);
+            read(is, frame.mouse.move.yNow);
+            read(is, frame.mouse.move.xOld);
+            read(is, frame.mouse.move.yOld);
+            read(is, frame.mouse.scroll.xOffset);
+            read(is, frame.mouse.scroll.yOffset);
+            read(is, frame.keyChangeCount);
+            frame.firstKeyChange = static_cast<uint32_t>(_keyChanges.size());
+            for (uint32_t i = 0; i < frame.keyChangeCount; ++i) {
+                int16_t key = 0, state = 0;
+                read(is, key);
+                read(is, state);
+                if (!is) {
+                    break;
+                }
+
+                if (key < 0 || key >= static_cast<int>(_keyStates.size())) {
+                    throw std::runtime_error(
+                        "invalid key " + std::to_string(key) + " in " + filePath);
+                }
+
+                _keyChanges.push_back({key, state});
+            }
+
+            _frames.push_back(frame);
+        }
+
+        if (!is) {
+            throw std::runtime_error("read " + filePath + " failure");
+        }
+    }
+
+private:
+    struct KeyChange {
+        int key;
+        int state;
+    };
+
+    struct Frame {
+        float deltaTime = 0.0f;
+        Input::Mouse mouse;
+        uint32_t firstKeyChange = 0;
+        uint32_t keyChangeCount = 0;
+    };
+
+    static constexpr char magic[4] = {'C', 'G', 'I', '1'};
+
+    std::vector<Frame> _frames;
+    std::vector<KeyChange> _keyChanges;
+    // the key states after the last recorded or replayed frame
+    std::array<int, GLFW_KEY_LAST + 1> _keyStates = {GLFW_RELEASE};
+    size_t _cursor = 0;
+
+    template <typename T>
+    static void write(std::ofstream& os, const T& value) {
+        os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    static void read(std::ifstream& is, T& value) {
+        is.read(reinterpret_cast<char*>(&value), sizeof(T));
+    }
+};
\ No newline at end of file
@@ -4,7 +4,7 @@
 InstancedModel::InstancedModel(
     const std::string& filepath, const std::vector<glm::mat4>& modelMatrices)
     : Model(filepath), _modelMatrices(modelMatrices) {
-    glBindVertexArray(_vao);
+    GLStateCache::bindVertexArray(_vao);
 
     glGenBuffers(1, &_instanceVbo);
     glBindBuffer(GL_ARRAY_BUFFER, _instanceVbo);
@@ -28,9 +28,9 @@ InstancedModel::InstancedModel(
     glVertexAttribDivisor(5, 1);
     glVertexAttribDivisor(6, 1);
 
-    glBindVertexArray(0);
+    GLStateCache::bindVertexArray(0);
 
-    glBindVertexArray(_boxVao);
+    GLStateCache::bindVertexArray(_boxVao);
     glBindBuffer(GL_ARRAY_BUFFER, _instanceVbo);
 
     glEnableVertexAttribArray(1);
@@ -47,7 +47,7 @@ InstancedModel::InstancedModel(
     glVertexAttribDivisor(3, 1);
     glVertexAttribDivisor(4, 1);
 
-    glBindVertexArray(0);
+    GLStateCache::bindVertexArray(0);
 }
 
 InstancedModel::InstancedModel(InstancedModel&& rhs) noexcept
@@ -75,31 +75,35 @@ const std::vector<glm::mat4>& InstancedModel::getModelMatrices() const {
 }
 
 void InstancedModel::draw() const {
-    glBindVertexArray(_vao);
+    GLStateCache::bindVertexArray(_vao);
     glDrawElementsInstanced(
-        GL_TRIANGLES, static_cast<GLsizei>(_indices.size()), GL_UNSIGNED_INT, 0,
+        GL_TRIANGLES, static_cast<GLsizei>(_indices.size()), _indexType, 0,
         static_cast<GLsizei>(_modelMatrices.size()));
-    glBindVertexArray(0);
 }
 
 void InstancedModel::draw(int amount) const {
-    glBindVertexArray(_vao);
+    GLStateCache::bindVertexArray(_vao);
     glDrawElementsInstanced(
-        GL_TRIANGLES, static_cast<GLsizei>(_indices.size()), GL_UNSIGNED_INT, 0, amount);
-    glBindVertexArray(0);
+        GL_TRIANGLES, static_cast<GLsizei>(_indices.size()), _indexType, 0, amount);
+}
+
+void InstancedModel::drawLod(int level, int amount) const {
+    const Lod& lod = _lods[level];
+    GLStateCache::bindVertexArray(_vao);
+    glDrawElementsInstanced(
+        GL_TRIANGLES, static_cast<GLsizei>(lod.indexCount), _indexType,
+        reinterpret_cast<const void*>(lod.firstIndex * getIndexTypeSize(_indexType)), amount);
 }
 
 void InstancedModel::drawBoundingBox() const {
-    glBindVertexArray(_boxVao);
+    GLStateCache::bindVertexArray(_boxVao);
     glDrawElementsInstanced(
         GL_LINES, 24, GL_UNSIGNED_INT, 0, static_cast<GLsizei>(_modelMatrices.size()));
-    glBindVertexArray(0);
 }
 
 void InstancedModel::drawBoundingBox(int amount) const {
-    glBindVertexArray(_boxVao);
+    GLStateCache::bindVertexArray(_boxVao);
     glDrawElementsInstanced(GL_LINES, 24, GL_UNSIGNED_INT, 0, amount);
-    glBindVertexArray(0);
 }
 
 GLuint InstancedModel::getInstacenVbo() const {
@@ -24,6 +24,8 @@ public:
 
     void draw(int amount) const;
 
+    void drawLod(int level, int amount) const;
+
     void drawBoundingBox() const override;
 
     void drawBoundingBox(int amount) const;
@@ -0,0 +1,256 @@
+#include <algorithm>
+
+#include "job_system.h"
+
+namespace {
+// the pool and the worker index of the calling thread
+thread_local const JobSystem* currentJobSystem = nullptr;
+thread_local int currentWorkerIndex = -1;
+}  // namespace
+
+bool JobSystem::Handle::finished() const {
+    return _job == nullptr || _job->finished.load(std::memory_order_acquire);
+}
+
+JobSystem::JobSystem(size_t workerCount) {
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    // no threads in the browser without pthread support, the jobs run when they are ready
+    workerCount = 0;
+#else
+    if (workerCount == 0) {
+        const size_t hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = std::max<size_t>(1, hardwareThreads > 1 ? hardwareThreads - 1 : 1);
+    }
+#endif
+
+    for (size_t i = 0; i < workerCount; ++i) {
+        _queues.emplace_back(new WorkQueue);
+    }
+
+    for (size_t i = 0; i < workerCount; ++i) {
+        _workers.emplace_back(&JobSystem::workerLoop, this, static_cast<int>(i));
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _stopped.store(true);
+    }
+
+    _sleepCondition.notify_all();
+    // the destroying thread helps to drain the queues, the workers leave once they are empty
+    while (tryRunJob(-1)) {
+    }
+
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+}
+
+JobSystem::Handle JobSystem::schedule(std::function<void()> task, const char* name) {
+    return schedule(std::move(task), {}, name);
+}
+
+JobSystem::Handle JobSystem::schedule(
+    std::function<void()> task, const std::vector<Handle>& dependencies, const char* name) {
+    auto job = std::make_shared<Job>();
+    job->task = std::move(task);
+    job->name = name;
+
+    for (const auto& dependency : dependencies) {
+        if (dependency._job == nullptr) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(dependency._job->mutex);
+        if (!dependency._job->finished.load(std::memory_order_acquire)) {
+            job->pendingDependencies.fetch_add(1, std::memory_order_relaxed);
+            dependency._job->continuations.push_back(job);
+        }
+    }
+
+    release(job);
+
+    return Handle(job);
+}
+
+JobSystem::Handle JobSystem::then(
+    const Handle& job, std::function<void()> task, const char* name) {
+    return schedule(std::move(task), {job}, name);
+}
+
+void JobSystem::wait(const Handle& job) {
+    const int workerIndex = getCurrentWorker();
+    while (!job.finished()) {
+        if (!tryRunJob(workerIndex)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::parallelFor(
+    size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)>& body,
+    const char* name) {
+    if (end <= begin) {
+        return;
+    }
+
+    grainSize = std::max<size_t>(1, grainSize);
+    const size_t chunkCount = (end - begin + grainSize - 1) / grainSize;
+
+    // the first chunk is left for the calling thread
+    std::atomic<size_t> remaining{chunkCount - 1};
+    for (size_t i = 1; i < chunkCount; ++i) {
+        const size_t chunkBegin = begin + i * grainSize;
+        const size_t chunkEnd = std::min(end, chunkBegin + grainSize);
+        schedule(
+            [&body, &remaining, chunkBegin, chunkEnd]() {
+                body(chunkBegin, chunkEnd);
+                remaining.fetch_sub(1, std::memory_order_release);
+            },
+            name);
+    }
+
+    if (_beginScope && name != nullptr) {
+        _beginScope(name);
+    }
+
+    body(begin, std::min(end, begin + grainSize));
+
+    if (_endScope && name != nullptr) {
+        _endScope();
+    }
+
+    const int workerIndex = getCurrentWorker();
+    while (remaining.load(std::memory_order_acquire) != 0) {
+        if (!tryRunJob(workerIndex)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+size_t JobSystem::getWorkerCount() const {
+    return _workers.size();
+}
+
+void JobSystem::setScopeHooks(
+    std::function<void(const char*)> beginScope, std::function<void()> endScope) {
+    _beginScope = std::move(beginScope);
+    _endScope = std::move(endScope);
+}
+
+void JobSystem::release(const std::shared_ptr<Job>& job) {
+    if (job->pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        enqueue(job);
+    }
+}
+
+void JobSystem::enqueue(std::shared_ptr<Job> job) {
+    if (_workers.empty()) {
+        run(job);
+        return;
+    }
+
+    // a worker keeps the jobs it spawns, the other threads spread theirs over the workers
+    const int workerIndex = getCurrentWorker();
+    size_t queueIndex = static_cast<size_t>(workerIndex);
+    if (workerIndex < 0) {
+        queueIndex = _nextQueue.fetch_add(1, std::memory_order_relaxed) % _queues.size();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_queues[queueIndex]->mutex);
+        _queues[queueIndex]->jobs.push_back(std::move(job));
+    }
+
+    _queuedCount.fetch_add(1, std::memory_order_release);
+
+    // taking the lock orders the wake up after the predicate check of a worker going to sleep
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+    }
+    _sleepCondition.notify_one();
+}
+
+bool JobSystem::tryRunJob(int workerIndex) {
+    std::shared_ptr<Job> job;
+
+    if (workerIndex >= 0) {
+        WorkQueue& queue = *_queues[workerIndex];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty()) {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+        }
+    }
+
+    const size_t queueCount = _queues.size();
+    const size_t first = workerIndex >= 0 ? static_cast<size_t>(workerIndex) + 1 : 0;
+    for (size_t i = 0; job == nullptr && i < queueCount; ++i) {
+        WorkQueue& queue = *_queues[(first + i) % queueCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty()) {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+        }
+    }
+
+    if (job == nullptr) {
+        return false;
+    }
+
+    _queuedCount.fetch_sub(1, std::memory_order_relaxed);
+    run(job);
+
+    return true;
+}
+
+void JobSystem::run(const std::shared_ptr<Job>& job) {
+    const bool scoped = _beginScope && _endScope && job->name != nullptr;
+    if (scoped) {
+        _beginScope(job->name);
+    }
+
+    job->task();
+    job->task = nullptr;
+
+    if (scoped) {
+        _endScope();
+    }
+
+    std::vector<std::shared_ptr<Job>> continuations;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->finished.store(true, std::memory_order_release);
+        continuations.swap(job->continuations);
+    }
+
+    for (const auto& continuation : continuations) {
+        release(continuation);
+    }
+}
+
+int JobSystem::getCurrentWorker() const {
+    return currentJobSystem == this ? currentWorkerIndex : -1;
+}
+
+void JobSystem::workerLoop(int workerIndex) {
+    currentJobSystem = this;
+    currentWorkerIndex = workerIndex;
+
+    for (;;) {
+        if (tryRunJob(workerIndex)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _sleepCondition.wait(lock, [this]() {
+            return _stopped.load() || _queuedCount.load(std::memory_order_acquire) > 0;
+        });
+
+        if (_stopped.load() && _queuedCount.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
\ No newline at end of file
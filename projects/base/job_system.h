@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// thread pool shared by the subsystems so that they do not oversubscribe the cores. every
+// worker owns a deque, it runs its newest job first and steals the oldest jobs of the others
+// when its own deque is empty. a thread waiting for a job runs the queued jobs meanwhile,
+// so waiting inside a job or on the main thread never idles a core.
+// the jobs must not throw, a job reports its failure through the state it captures.
+class JobSystem {
+private:
+    struct Job;
+
+public:
+    // reference to a scheduled job, an empty handle counts as finished
+    class Handle {
+    public:
+        Handle() = default;
+
+        bool valid() const {
+            return _job != nullptr;
+        }
+
+        bool finished() const;
+
+    private:
+        std::shared_ptr<Job> _job;
+
+        explicit Handle(std::shared_ptr<Job> job) : _job(std::move(job)) {}
+
+        friend class JobSystem;
+    };
+
+    // 0 workers means one less than the hardware threads, at least one
+    JobSystem(size_t workerCount = 0);
+
+    JobSystem(const JobSystem&) = delete;
+
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // the jobs scheduled before are finished first, so their handles stay valid.
+    // the jobs must not schedule new work once the destruction has begun
+    ~JobSystem();
+
+    // the name must outlive the job system, a string literal in practice
+    Handle schedule(std::function<void()> task, const char* name = nullptr);
+
+    // run the task once all the dependencies are finished
+    Handle schedule(
+        std::function<void()> task, const std::vector<Handle>& dependencies,
+        const char* name = nullptr);
+
+    // continuation of a single job
+    Handle then(const Handle& job, std::function<void()> task, const char* name = nullptr);
+
+    // run the queued jobs until the job is finished
+    void wait(const Handle& job);
+
+    // call body(chunkBegin, chunkEnd) for the chunks of grainSize elements in [begin, end)
+    // in parallel and return when all of them are done, the calling thread takes part
+    void parallelFor(
+        size_t begin, size_t end, size_t grainSize,
+        const std::function<void(size_t, size_t)>& body, const char* name = nullptr);
+
+    size_t getWorkerCount() const;
+
+    // called around every named job on the thread running it, e.g. to open a profiler scope.
+    // set them before the first job is scheduled
+    void setScopeHooks(
+        std::function<void(const char*)> beginScope, std::function<void()> endScope);
+
+private:
+    struct Job {
+        std::function<void()> task;
+        const char* name = nullptr;
+        // the unfinished dependencies plus one held until the job is fully scheduled
+        std::atomic<int> pendingDependencies{1};
+        std::atomic<bool> finished{false};
+        // guards the continuations against the job finishing concurrently
+        std::mutex mutex;
+        std::vector<std::shared_ptr<Job>> continuations;
+    };
+
+    struct WorkQueue {
+        std::deque<std::shared_ptr<Job>> jobs;
+        std::mutex mutex;
+    };
+
+    std::vector<std::thread> _workers;
+    std::vector<std::unique_ptr<WorkQueue>> _queues;
+    std::atomic<size_t> _nextQueue{0};
+
+    std::atomic<size_t> _queuedCount{0};
+    std::mutex _sleepMutex;
+    std::condition_variable _sleepCondition;
+    std::atomic<bool> _stopped{false};
+
+    std::function<void(const char*)> _beginScope;
+    std::function<void()> _endScope;
+
+    void release(const std::shared_ptr<Job>& job);
+
+    void enqueue(std::shared_ptr<Job> job);
+
+    // run one queued job, the own deque of the worker first, false when there is none
+    bool tryRunJob(int workerIndex);
+
+    void run(const std::shared_ptr<Job>& job);
+
+    // the worker index of the calling thread, -1 for the threads outside the pool
+    int getCurrentWorker() const;
+
+    void workerLoop(int workerIndex);
+};
\ No newline at end of file
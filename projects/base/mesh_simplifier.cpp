@@ -0,0 +1,333 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <unordered_map>
+
+#include "mesh_simplifier.h"
+
+namespace {
+// symmetric 4x4 matrix of the plane quadric, with the accumulated area as weight
+struct Quadric {
+    double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+    double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+    double a22 = 0.0, a23 = 0.0;
+    double a33 = 0.0;
+    double weight = 0.0;
+
+    Quadric& operator+=(const Quadric& rhs) {
+        a00 += rhs.a00, a01 += rhs.a01, a02 += rhs.a02, a03 += rhs.a03;
+        a11 += rhs.a11, a12 += rhs.a12, a13 += rhs.a13;
+        a22 += rhs.a22, a23 += rhs.a23;
+        a33 += rhs.a33;
+        weight += rhs.weight;
+
+        return *this;
+    }
+};
+
+Quadric makePlaneQuadric(double a, double b, double c, double d, double weight) {
+    Quadric q;
+    q.a00 = weight * a * a, q.a01 = weight * a * b, q.a02 = weight * a * c;
+    q.a03 = weight * a * d, q.a11 = weight * b * b, q.a12 = weight * b * c;
+    q.a13 = weight * b * d, q.a22 = weight * c * c, q.a23 = weight * c * d;
+    q.a33 = weight * d * d;
+    q.weight = weight;
+
+    return q;
+}
+
+// root of the weighted mean squared distance from the point to the planes
+double evaluate(const Quadric& q, const glm::vec3& p) {
+    if (q.weight <= 0.0) {
+        return 0.0;
+    }
+
+    const double x = p.x, y = p.y, z = p.z;
+    const double e = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z + q.a33
+                     + 2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z)
+                     + 2.0 * (q.a03 * x + q.a13 * y + q.a23 * z);
+
+    return std::sqrt(std::max(e, 0.0) / q.weight);
+}
+
+struct Collapse {
+    double error;
+    uint32_t from;
+    uint32_t to;
+    uint32_t fromVersion;
+    uint32_t toVersion;
+
+    bool operator>(const Collapse& rhs) const {
+        return error > rhs.error;
+    }
+};
+
+uint64_t makeEdgeKey(uint32_t a, uint32_t b) {
+    return (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+}
+} // namespace
+
+std::vector<uint32_t> simplifyMesh(
+    const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+    size_t targetIndexCount, float targetError, float* resultError) {
+    if (resultError) {
+        *resultError = 0.0f;
+    }
+
+    const size_t vertexCount = vertices.size();
+    const size_t faceCount = indices.size() / 3;
+
+    // 1. weld the vertices sharing the same position, so that the uv and normal seams
+    //    are collapsed as one vertex instead of tearing the surface apart
+    std::vector<uint32_t> order(vertexCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&vertices](uint32_t lhs, uint32_t rhs) {
+        const glm::vec3& a = vertices[lhs].position;
+        const glm::vec3& b = vertices[rhs].position;
+        return a.x != b.x ? a.x < b.x : (a.y != b.y ? a.y < b.y : a.z < b.z);
+    });
+
+    std::vector<uint32_t> remap(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        const bool same = i > 0 && vertices[order[i]].position == vertices[order[i - 1]].position;
+        remap[order[i]] = same ? remap[order[i - 1]] : order[i];
+    }
+
+    std::vector<std::vector<uint32_t>> wedges(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        wedges[remap[v]].push_back(v);
+    }
+
+    glm::vec3 minPosition(std::numeric_limits<float>::max());
+    glm::vec3 maxPosition(-std::numeric_limits<float>::max());
+    for (const auto& v : vertices) {
+        minPosition = glm::min(minPosition, v.position);
+        maxPosition = glm::max(maxPosition, v.position);
+    }
+
+    const glm::vec3 size = maxPosition - minPosition;
+    const double extent = std::max(size.x, std::max(size.y, size.z));
+    if (faceCount == 0 || !(extent > 0.0)) {
+        return indices;
+    }
+
+    // 2. accumulate the area weighted plane quadrics of the faces on the welded vertices
+    std::vector<uint32_t> corners(indices.begin(), indices.begin() + 3 * faceCount);
+    std::vector<Quadric> quadrics(vertexCount);
+    std::vector<std::vector<uint32_t>> adjacency(vertexCount);
+    std::vector<char> faceAlive(faceCount, 1);
+    std::unordered_map<uint64_t, int> edgeUses;
+    size_t aliveFaceCount = faceCount;
+
+    for (uint32_t f = 0; f < faceCount; ++f) {
+        const uint32_t a = remap[corners[3 * f + 0]];
+        const uint32_t b = remap[corners[3 * f + 1]];
+        const uint32_t c = remap[corners[3 * f + 2]];
+        if (a == b || b == c || c == a) {
+            faceAlive[f] = 0;
+            --aliveFaceCount;
+            continue;
+        }
+
+        const glm::vec3 p0 = vertices[a].position;
+        const glm::vec3 n = glm::cross(vertices[b].position - p0, vertices[c].position - p0);
+        const float length = glm::length(n);
+        if (length > 0.0f) {
+            const glm::vec3 u = n / length;
+            const double area = 0.5 * static_cast<double>(length);
+            const Quadric q = makePlaneQuadric(u.x, u.y, u.z, -glm::dot(u, p0), area);
+            quadrics[a] += q;
+            quadrics[b] += q;
+            quadrics[c] += q;
+        }
+
+        adjacency[a].push_back(f);
+        adjacency[b].push_back(f);
+        adjacency[c].push_back(f);
+
+        ++edgeUses[makeEdgeKey(a, b)];
+        ++edgeUses[makeEdgeKey(b, c)];
+        ++edgeUses[makeEdgeKey(c, a)];
+    }
+
+    // 3. lock the vertices on open borders and non-manifold edges to keep the silhouette
+    std::vector<char> locked(vertexCount, 0);
+    for (const auto& edge : edgeUses) {
+        if (edge.second != 2) {
+            locked[static_cast<uint32_t>(edge.first >> 32)] = 1;
+            locked[static_cast<uint32_t>(edge.first & 0xffffffffu)] = 1;
+        }
+    }
+
+    // 4. collect the collapse candidates in a min heap, stale entries are skipped
+    //    lazily by comparing the versions of the endpoints
+    std::vector<uint32_t> versions(vertexCount, 0);
+    std::vector<char> vertexAlive(vertexCount, 1);
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap;
+
+    auto pushCollapse = [&](uint32_t from, uint32_t to) {
+        if (locked[from]) {
+            return;
+        }
+
+        Quadric q = quadrics[from];
+        q += quadrics[to];
+        heap.push({evaluate(q, vertices[to].position), from, to, versions[from], versions[to]});
+    };
+
+    auto pushEdges = [&](uint32_t v) {
+        for (uint32_t f : adjacency[v]) {
+            if (!faceAlive[f]) {
+                continue;
+            }
+
+            for (int k = 0; k < 3; ++k) {
+                const uint32_t u = remap[corners[3 * f + k]];
+                if (u != v) {
+                    pushCollapse(v, u);
+                    pushCollapse(u, v);
+                }
+            }
+        }
+    };
+
+    for (uint32_t f = 0; f < faceCount; ++f) {
+        if (!faceAlive[f]) {
+            continue;
+        }
+
+        for (int k = 0; k < 3; ++k) {
+            const uint32_t a = remap[corners[3 * f + k]];
+            const uint32_t b = remap[corners[3 * f + (k + 1) % 3]];
+            pushCollapse(a, b);
+            pushCollapse(b, a);
+        }
+    }
+
+    // reject the collapse if any remaining face around the vertex flips
+    auto isCollapseValid = [&](uint32_t from, uint32_t to) {
+        for (uint32_t f : adjacency[from]) {
+            if (!faceAlive[f]) {
+                continue;
+            }
+
+            glm::vec3 p[3], q[3];
+            bool containsTo = false;
+            for (int k = 0; k < 3; ++k) {
+                const uint32_t v = remap[corners[3 * f + k]];
+                containsTo = containsTo || v == to;
+                p[k] = vertices[v].position;
+                q[k] = v == from ? vertices[to].position : p[k];
+            }
+
+            if (containsTo) {
+                continue;
+            }
+
+            const glm::vec3 n0 = glm::cross(p[1] - p[0], p[2] - p[0]);
+            const glm::vec3 n1 = glm::cross(q[1] - q[0], q[2] - q[0]);
+            if (glm::dot(n0, n1) <= 0.0f) {
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    // the wedge of the target with the closest attributes replaces the collapsed one
+    auto findClosestWedge = [&](uint32_t vertex, uint32_t to) {
+        uint32_t result = to;
+        float minDistance = std::numeric_limits<float>::max();
+        for (uint32_t w : wedges[to]) {
+            const glm::vec3 dn = vertices[w].normal - vertices[vertex].normal;
+            const glm::vec2 dt = vertices[w].texCoord - vertices[vertex].texCoord;
+            const float distance = glm::dot(dn, dn) + glm::dot(dt, dt);
+            if (distance < minDistance) {
+                minDistance = distance;
+                result = w;
+            }
+        }
+
+        return result;
+    };
+
+    // 5. collapse the cheapest edges until one of the targets is reached
+    const double errorLimit = static_cast<double>(targetError) * extent;
+    double maxError = 0.0;
+    while (aliveFaceCount * 3 > targetIndexCount && !heap.empty()) {
+        const Collapse collapse = heap.top();
+        heap.pop();
+
+        const uint32_t from = collapse.from;
+        const uint32_t to = collapse.to;
+        if (!vertexAlive[from] || !vertexAlive[to] || versions[from] != collapse.fromVersion
+            || versions[to] != collapse.toVersion) {
+            continue;
+        }
+
+        if (collapse.error > errorLimit) {
+            break;
+        }
+
+        if (!isCollapseValid(from, to)) {
+            continue;
+        }
+
+        for (uint32_t f : adjacency[from]) {
+            if (!faceAlive[f]) {
+                continue;
+            }
+
+            bool containsTo = false;
+            for (int k = 0; k < 3; ++k) {
+                containsTo = containsTo || remap[corners[3 * f + k]] == to;
+            }
+
+            if (containsTo) {
+                faceAlive[f] = 0;
+                --aliveFaceCount;
+                continue;
+            }
+
+            for (int k = 0; k < 3; ++k) {
+                uint32_t& corner = corners[3 * f + k];
+                if (remap[corner] == from) {
+                    corner = findClosestWedge(corner, to);
+                }
+            }
+
+            adjacency[to].push_back(f);
+        }
+
+        adjacency[from].clear();
+        adjacency[to].erase(
+            std::remove_if(
+                adjacency[to].begin(), adjacency[to].end(),
+                [&faceAlive](uint32_t f) { return !faceAlive[f]; }),
+            adjacency[to].end());
+
+        quadrics[to] += quadrics[from];
+        vertexAlive[from] = 0;
+        ++versions[to];
+        maxError = std::max(maxError, collapse.error);
+
+        pushEdges(to);
+    }
+
+    std::vector<uint32_t> result;
+    result.reserve(aliveFaceCount * 3);
+    for (uint32_t f = 0; f < faceCount; ++f) {
+        if (faceAlive[f]) {
+            result.insert(result.end(), corners.begin() + 3 * f, corners.begin() + 3 * f + 3);
+        }
+    }
+
+    if (resultError) {
+        *resultError = static_cast<float>(maxError / extent);
+    }
+
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "vertex.h"
+
+// simplify a triangle mesh with quadric error metrics (Garland and Heckbert 1997).
+// every edge collapse moves a vertex onto one of its neighbors, so the returned indices
+// still refer to the input vertex array and a lod chain can share one vertex buffer.
+// the simplification stops when the index count reaches targetIndexCount or the next
+// collapse would exceed targetError, which is relative to the largest extent of the mesh.
+std::vector<uint32_t> simplifyMesh(
+    const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+    size_t targetIndexCount, float targetError, float* resultError = nullptr);
\ No newline at end of file
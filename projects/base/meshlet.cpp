@@ -0,0 +1,264 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "meshlet.h"
+
+namespace {
+void computeMeshletBounds(
+    const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices,
+    Meshlet& meshlet) {
+    const uint32_t end = meshlet.firstIndex + meshlet.indexCount;
+    for (uint32_t i = meshlet.firstIndex; i < end; ++i) {
+        const glm::vec3& p = positions[indices[i]];
+        meshlet.box.min = glm::min(meshlet.box.min, p);
+        meshlet.box.max = glm::max(meshlet.box.max, p);
+    }
+
+    meshlet.center = 0.5f * (meshlet.box.min + meshlet.box.max);
+    meshlet.radius = 0.0f;
+    for (uint32_t i = meshlet.firstIndex; i < end; ++i) {
+        const glm::vec3& p = positions[indices[i]];
+        meshlet.radius = std::max(meshlet.radius, glm::length(p - meshlet.center));
+    }
+
+    // the cone axis is the average of the face normals
+    std::vector<glm::vec3> normals;
+    normals.reserve(meshlet.indexCount / 3);
+    glm::vec3 axis(0.0f);
+    for (uint32_t i = meshlet.firstIndex; i < end; i += 3) {
+        const glm::vec3& p0 = positions[indices[i + 0]];
+        const glm::vec3& p1 = positions[indices[i + 1]];
+        const glm::vec3& p2 = positions[indices[i + 2]];
+        const glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+        const float length = glm::length(n);
+        if (length > 0.0f) {
+            normals.push_back(n / length);
+            axis += normals.back();
+        }
+    }
+
+    const float axisLength = glm::length(axis);
+    if (normals.empty() || axisLength == 0.0f) {
+        return;
+    }
+
+    meshlet.coneAxis = axis / axisLength;
+
+    float minDot = 1.0f;
+    for (const auto& n : normals) {
+        minDot = std::min(minDot, glm::dot(meshlet.coneAxis, n));
+    }
+
+    // the cone is too wide to be ever culled
+    if (minDot <= 0.1f) {
+        meshlet.coneCutoff = 1.0f;
+    } else {
+        meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+    }
+}
+} // namespace
+
+std::vector<Meshlet> buildMeshlets(
+    const std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices, size_t maxVertices,
+    size_t maxTriangles) {
+    const size_t vertexCount = positions.size();
+    const size_t faceCount = indices.size() / 3;
+
+    // weld the vertices by position so that faces split by uv or normal seams are
+    // still treated as neighbors
+    std::vector<uint32_t> order(vertexCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&positions](uint32_t lhs, uint32_t rhs) {
+        const glm::vec3& a = positions[lhs];
+        const glm::vec3& b = positions[rhs];
+        return a.x != b.x ? a.x < b.x : (a.y != b.y ? a.y < b.y : a.z < b.z);
+    });
+
+    std::vector<uint32_t> remap(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        const bool same = i > 0 && positions[order[i]] == positions[order[i - 1]];
+        remap[order[i]] = same ? remap[order[i - 1]] : order[i];
+    }
+
+    // faces around each welded vertex in a compressed row layout
+    std::vector<uint32_t> faceOffsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < 3 * faceCount; ++i) {
+        ++faceOffsets[remap[indices[i]] + 1];
+    }
+
+    for (size_t v = 0; v < vertexCount; ++v) {
+        faceOffsets[v + 1] += faceOffsets[v];
+    }
+
+    std::vector<uint32_t> vertexFaces(3 * faceCount);
+    std::vector<uint32_t> cursors(faceOffsets.begin(), faceOffsets.end() - 1);
+    for (size_t i = 0; i < 3 * faceCount; ++i) {
+        vertexFaces[cursors[remap[indices[i]]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<uint32_t> reordered;
+    reordered.reserve(3 * faceCount);
+    std::vector<Meshlet> meshlets;
+
+    std::vector<char> emitted(faceCount, 0);
+    std::vector<char> inMeshlet(vertexCount, 0);
+    std::vector<uint32_t> meshletVertices;
+    size_t meshletFaceCount = 0;
+    size_t seed = 0;
+
+    auto countNewVertices = [&](uint32_t f) {
+        size_t count = 0;
+        for (int k = 0; k < 3; ++k) {
+            count += inMeshlet[indices[3 * f + k]] ? 0 : 1;
+        }
+        return count;
+    };
+
+    auto finishMeshlet = [&]() {
+        if (meshletFaceCount == 0) {
+            return;
+        }
+
+        Meshlet meshlet;
+        meshlet.indexCount = static_cast<uint32_t>(3 * meshletFaceCount);
+        meshlet.firstIndex = static_cast<uint32_t>(reordered.size()) - meshlet.indexCount;
+        meshlets.push_back(meshlet);
+
+        for (uint32_t v : meshletVertices) {
+            inMeshlet[v] = 0;
+        }
+
+        meshletVertices.clear();
+        meshletFaceCount = 0;
+    };
+
+    // grow each meshlet greedily with the face sharing the most vertices with it,
+    // which keeps the clusters compact and their bounds tight
+    for (;;) {
+        if (meshletFaceCount == maxTriangles) {
+            finishMeshlet();
+        }
+
+        int64_t best = -1;
+        size_t bestNewVertices = 3;
+        for (uint32_t v : meshletVertices) {
+            const uint32_t w = remap[v];
+            for (uint32_t i = faceOffsets[w]; i < faceOffsets[w + 1]; ++i) {
+                const uint32_t f = vertexFaces[i];
+                if (emitted[f]) {
+                    continue;
+                }
+
+                const size_t newVertices = countNewVertices(f);
+                if (meshletVertices.size() + newVertices <= maxVertices
+                    && (best < 0 || newVertices < bestNewVertices)) {
+                    best = f;
+                    bestNewVertices = newVertices;
+                }
+            }
+        }
+
+        // start a new meshlet from the next face in order when no neighbor fits
+        if (best < 0) {
+            finishMeshlet();
+            while (seed < faceCount && emitted[seed]) {
+                ++seed;
+            }
+
+            if (seed == faceCount) {
+                break;
+            }
+
+            best = static_cast<int64_t>(seed);
+        }
+
+        const uint32_t f = static_cast<uint32_t>(best);
+        for (int k = 0; k < 3; ++k) {
+            const uint32_t v = indices[3 * f + k];
+            if (!inMeshlet[v]) {
+                inMeshlet[v] = 1;
+                meshletVertices.push_back(v);
+            }
+            reordered.push_back(v);
+        }
+
+        emitted[f] = 1;
+        ++meshletFaceCount;
+    }
+
+    reordered.insert(reordered.end(), indices.begin() + 3 * faceCount, indices.end());
+    indices.swap(reordered);
+
+    for (auto& meshlet : meshlets) {
+        computeMeshletBounds(positions, indices, meshlet);
+    }
+
+    return meshlets;
+}
+
+void cullMeshlets(
+    const Meshlet* meshlets, size_t meshletCount, const glm::mat4& modelMatrix,
+    const glm::mat4& viewProjection, const glm::vec3& viewPosition,
+    std::vector<DrawElementsIndirectCommand>& commands) {
+    // extract the frustum planes from the rows of the view projection matrix,
+    // the normals point inside the frustum
+    glm::vec4 planes[6];
+    for (int i = 0; i < 3; ++i) {
+        const glm::vec4 row(
+            viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        const glm::vec4 w(
+            viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+        planes[2 * i + 0] = w + row;
+        planes[2 * i + 1] = w - row;
+    }
+
+    for (auto& plane : planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+
+    const glm::mat3 linear(modelMatrix);
+    const float scale = std::max(
+        glm::length(linear[0]), std::max(glm::length(linear[1]), glm::length(linear[2])));
+
+    const size_t begin = commands.size();
+    for (size_t m = 0; m < meshletCount; ++m) {
+        const Meshlet& meshlet = meshlets[m];
+        const glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(meshlet.center, 1.0f));
+        const float radius = meshlet.radius * scale;
+
+        bool visible = true;
+        for (int i = 0; i < 6 && visible; ++i) {
+            visible = glm::dot(glm::vec3(planes[i]), center) + planes[i].w >= -radius;
+        }
+
+        if (visible && meshlet.coneCutoff < 1.0f) {
+            const glm::vec3 axis = glm::normalize(linear * meshlet.coneAxis);
+            const glm::vec3 direction = center - viewPosition;
+            visible = glm::dot(direction, axis)
+                      < meshlet.coneCutoff * glm::length(direction) + radius;
+        }
+
+        if (!visible) {
+            continue;
+        }
+
+        if (commands.size() > begin) {
+            DrawElementsIndirectCommand& last = commands.back();
+            if (last.firstIndex + last.count == meshlet.firstIndex) {
+                last.count += meshlet.indexCount;
+                continue;
+            }
+        }
+
+        commands.push_back({meshlet.indexCount, 1, meshlet.firstIndex, 0, 0});
+    }
+}
+
+void cullMeshlets(
+    const std::vector<Meshlet>& meshlets, const glm::mat4& modelMatrix,
+    const glm::mat4& viewProjection, const glm::vec3& viewPosition,
+    std::vector<DrawElementsIndirectCommand>& commands) {
+    cullMeshlets(
+        meshlets.data(), meshlets.size(), modelMatrix, viewProjection, viewPosition, commands);
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bounding_box.h"
+#include "gl_utility.h"
+
+// a small cluster of triangles with bounds for culling at a finer granularity than models
+struct Meshlet {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+
+    // bounding volumes in the model space
+    BoundingBox box;
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+
+    // all triangle normals lie in the cone around the axis, the cluster faces away from
+    // the viewer when dot(normalize(center - view), axis) >= cutoff, with the radius
+    // taken into account. a cutoff of 1 means the cone is too wide to cull.
+    glm::vec3 coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+    float coneCutoff = 1.0f;
+};
+
+// reorder the triangles of indices into meshlets of at most maxVertices vertices and
+// maxTriangles triangles, the meshlets refer to consecutive ranges of the reordered indices
+std::vector<Meshlet> buildMeshlets(
+    const std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices,
+    size_t maxVertices = 64, size_t maxTriangles = 124);
+
+// append the draw commands of the meshlets passing the frustum and backface cone tests,
+// adjacent visible meshlets are merged into one command. the cone test assumes the model
+// matrix has no shear or non-uniform scale.
+void cullMeshlets(
+    const Meshlet* meshlets, size_t meshletCount, const glm::mat4& modelMatrix,
+    const glm::mat4& viewProjection, const glm::vec3& viewPosition,
+    std::vector<DrawElementsIndirectCommand>& commands);
+
+// all the meshlets of a mesh
+void cullMeshlets(
+    const std::vector<Meshlet>& meshlets, const glm::mat4& modelMatrix,
+    const glm::mat4& viewProjection, const glm::vec3& viewPosition,
+    std::vector<DrawElementsIndirectCommand>& commands);
\ No newline at end of file
@@ -14,9 +14,44 @@
 #pragma warning(pop)
 #endif
 
+#include "mesh_simplifier.h"
 #include "model.h"
+#include "simd_bounds.h"
 
 Model::Model(const std::string& filepath) {
+    loadObj(filepath, _vertices, _indices);
+
+    computeBoundingBox();
+
+    initGLResources();
+
+    initBoxGLResources();
+
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        cleanup();
+        throw std::runtime_error("OpenGL Error: " + std::to_string(error));
+    }
+}
+
+Model::Model(std::vector<Vertex> vertices, std::vector<uint32_t> indices)
+    : _vertices(std::move(vertices)), _indices(std::move(indices)) {
+
+    computeBoundingBox();
+
+    initGLResources();
+
+    initBoxGLResources();
+
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        cleanup();
+        throw std::runtime_error("OpenGL Error: " + std::to_string(error));
+    }
+}
+
+void Model::loadObj(
+    const std::string& filepath, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
     tinyobj::attrib_t attrib;
     std::vector<tinyobj::shape_t> shapes;
     std::vector<tinyobj::material_t> materials;
@@ -40,8 +75,8 @@ Model::Model(const std::string& filepath) {
         throw std::runtime_error("Loading model " + filepath + " error:\n" + err);
     }
 
-    std::vector<Vertex> vertices;
-    std::vector<uint32_t> indices;
+    vertices.clear();
+    indices.clear();
     std::unordered_map<Vertex, uint32_t> uniqueVertices;
 
     for (const auto& shape : shapes) {
@@ -72,49 +107,20 @@ Model::Model(const std::string& filepath) {
             indices.push_back(uniqueVertices[vertex]);
         }
     }
-
-    _vertices = vertices;
-    _indices = indices;
-
-    computeBoundingBox();
-
-    initGLResources();
-
-    initBoxGLResources();
-
-    GLenum error = glGetError();
-    if (error != GL_NO_ERROR) {
-        cleanup();
-        throw std::runtime_error("OpenGL Error: " + std::to_string(error));
-    }
-}
-
-Model::Model(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
-    : _vertices(vertices), _indices(indices) {
-
-    computeBoundingBox();
-
-    initGLResources();
-
-    initBoxGLResources();
-
-    GLenum error = glGetError();
-    if (error != GL_NO_ERROR) {
-        cleanup();
-        throw std::runtime_error("OpenGL Error: " + std::to_string(error));
-    }
 }
 
 Model::Model(Model&& rhs) noexcept
     : _vertices(std::move(rhs._vertices)), _indices(std::move(rhs._indices)),
       _boundingBox(std::move(rhs._boundingBox)), _vao(rhs._vao), _vbo(rhs._vbo), _ebo(rhs._ebo),
-      _boxVao(rhs._boxVao), _boxVbo(rhs._boxVbo), _boxEbo(rhs._boxEbo) {
-    _vao = 0;
-    _vbo = 0;
-    _ebo = 0;
-    _boxVao = 0;
-    _boxVbo = 0;
-    _boxEbo = 0;
+      _indexType(rhs._indexType), _lods(std::move(rhs._lods)),
+      _meshlets(std::move(rhs._meshlets)), _boxVao(rhs._boxVao), _boxVbo(rhs._boxVbo),
+      _boxEbo(rhs._boxEbo) {
+    rhs._vao = 0;
+    rhs._vbo = 0;
+    rhs._ebo = 0;
+    rhs._boxVao = 0;
+    rhs._boxVbo = 0;
+    rhs._boxEbo = 0;
 }
 
 Model::~Model() {
@@ -128,6 +134,9 @@ Model& Model::operator=(Model&& rhs) noexcept {
         std::swap(_vao, rhs._vao);
         std::swap(_vbo, rhs._vbo);
         std::swap(_ebo, rhs._ebo);
+        std::swap(_indexType, rhs._indexType);
+        _lods = std::move(rhs._lods);
+        _meshlets = std::move(rhs._meshlets);
         std::swap(_boxVao, rhs._boxVao);
         std::swap(_boxVbo, rhs._boxVbo);
         std::swap(_boxEbo, rhs._boxEbo);
@@ -141,15 +150,123 @@ BoundingBox Model::getBoundingBox() const {
 }
 
 void Model::draw() const {
-    glBindVertexArray(_vao);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(_indices.size()), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    GLStateCache::bindVertexArray(_vao);
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(_indices.size()), _indexType, 0);
 }
 
 void Model::drawBoundingBox() const {
-    glBindVertexArray(_boxVao);
+    GLStateCache::bindVertexArray(_boxVao);
     glDrawElements(GL_LINES, 24, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+}
+
+void Model::generateLods(const std::vector<float>& errorTargets) {
+    const glm::vec3 size = _boundingBox.max - _boundingBox.min;
+    const float extent = std::max(size.x, std::max(size.y, size.z));
+
+    std::vector<uint32_t> lodIndices = _indices;
+    _lods.resize(1);
+
+    // simplify from the full detail mesh every time to avoid accumulating the error
+    for (const float target : errorTargets) {
+        float error = 0.0f;
+        const std::vector<uint32_t> simplified =
+            simplifyMesh(_vertices, _indices, 0, target, &error);
+        if (simplified.empty() || simplified.size() * 10 > _lods.back().indexCount * 9) {
+            continue;
+        }
+
+        Lod lod;
+        lod.firstIndex = static_cast<uint32_t>(lodIndices.size());
+        lod.indexCount = static_cast<uint32_t>(simplified.size());
+        lod.error = error * extent;
+        _lods.push_back(lod);
+
+        lodIndices.insert(lodIndices.end(), simplified.begin(), simplified.end());
+    }
+
+    const std::vector<uint8_t> indexData = packIndices(lodIndices, _indexType);
+
+    GLStateCache::bindVertexArray(_vao);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexData.size(), indexData.data(), GL_STATIC_DRAW);
+    GLStateCache::bindVertexArray(0);
+}
+
+void Model::copyLods(const Model& source) {
+    if (source._vertices.size() != _vertices.size() || source._indices != _indices) {
+        throw std::runtime_error("copy lods from a different mesh");
+    }
+
+    const Lod& last = source._lods.back();
+    const GLsizeiptr size = (static_cast<GLsizeiptr>(last.firstIndex) + last.indexCount)
+                            * getIndexTypeSize(_indexType);
+
+    // the copy targets leave the element buffer of the bound vao alone
+    glBindBuffer(GL_COPY_READ_BUFFER, source._ebo);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _ebo);
+    glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STATIC_DRAW);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, size);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    _lods = source._lods;
+}
+
+int Model::getLodCount() const {
+    return static_cast<int>(_lods.size());
+}
+
+const Model::Lod& Model::getLod(int level) const {
+    return _lods[level];
+}
+
+int Model::selectLod(
+    const glm::mat4& modelMatrix, const glm::vec3& viewPosition, float projectionScale,
+    float errorThreshold) const {
+    const float scale = std::max(
+        glm::length(glm::vec3(modelMatrix[0])),
+        std::max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
+
+    // distance from the view position to the bounding sphere
+    const glm::vec3 center =
+        glm::vec3(modelMatrix * glm::vec4(0.5f * (_boundingBox.min + _boundingBox.max), 1.0f));
+    const float radius = 0.5f * glm::length(_boundingBox.max - _boundingBox.min) * scale;
+    const float distance = std::max(glm::length(center - viewPosition) - radius, 1e-4f);
+
+    for (int level = static_cast<int>(_lods.size()) - 1; level > 0; --level) {
+        if (_lods[level].error * scale / distance * projectionScale <= errorThreshold) {
+            return level;
+        }
+    }
+
+    return 0;
+}
+
+void Model::drawLod(int level) const {
+    const Lod& lod = _lods[level];
+    GLStateCache::bindVertexArray(_vao);
+    glDrawElements(
+        GL_TRIANGLES, static_cast<GLsizei>(lod.indexCount), _indexType,
+        reinterpret_cast<const void*>(lod.firstIndex * getIndexTypeSize(_indexType)));
+}
+
+void Model::buildMeshlets(size_t maxVertices, size_t maxTriangles) {
+    std::vector<glm::vec3> positions(_vertices.size());
+    for (size_t i = 0; i < _vertices.size(); ++i) {
+        positions[i] = _vertices[i].position;
+    }
+
+    _meshlets = ::buildMeshlets(positions, _indices, maxVertices, maxTriangles);
+
+    // the index count is unchanged, so the lod levels behind stay in place
+    const std::vector<uint8_t> indexData = packIndices(_indices, _indexType);
+
+    GLStateCache::bindVertexArray(_vao);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indexData.size(), indexData.data());
+    GLStateCache::bindVertexArray(0);
+}
+
+const std::vector<Meshlet>& Model::getMeshlets() const {
+    return _meshlets;
 }
 
 GLuint Model::getVao() const {
@@ -160,6 +277,10 @@ GLuint Model::getBoundingBoxVao() const {
     return _boxVao;
 }
 
+GLenum Model::getIndexType() const {
+    return _indexType;
+}
+
 size_t Model::getVertexCount() const {
     return _vertices.size();
 }
@@ -176,15 +297,21 @@ void Model::initGLResources() {
     // create a element array buffer
     glGenBuffers(1, &_ebo);
 
-    glBindVertexArray(_vao);
+    GLStateCache::bindVertexArray(_vao);
     glBindBuffer(GL_ARRAY_BUFFER, _vbo);
     glBufferData(
         GL_ARRAY_BUFFER, sizeof(Vertex) * _vertices.size(), _vertices.data(), GL_STATIC_DRAW);
 
+    // narrow the indices to 16 bits when the vertex count allows
+    _indexType = ::getIndexType(_vertices.size());
+    const std::vector<uint8_t> indexData = packIndices(_indices, _indexType);
+
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
-    glBufferData(
-        GL_ELEMENT_ARRAY_BUFFER, _indices.size() * sizeof(uint32_t), _indices.data(),
-        GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexData.size(), indexData.data(), GL_STATIC_DRAW);
+
+    Lod lod;
+    lod.indexCount = static_cast<uint32_t>(_indices.size());
+    _lods.assign(1, lod);
 
     // specify layout, size of a vertex, data type, normalize, sizeof vertex array, offset of the
     // attribute
@@ -198,28 +325,16 @@ void Model::initGLResources() {
         2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
     glEnableVertexAttribArray(2);
 
-    glBindVertexArray(0);
+    GLStateCache::bindVertexArray(0);
 }
 
 void Model::computeBoundingBox() {
-    float minX = std::numeric_limits<float>::max();
-    float minY = std::numeric_limits<float>::max();
-    float minZ = std::numeric_limits<float>::max();
-    float maxX = -std::numeric_limits<float>::max();
-    float maxY = -std::numeric_limits<float>::max();
-    float maxZ = -std::numeric_limits<float>::max();
-
-    for (const auto& v : _vertices) {
-        minX = std::min(v.position.x, minX);
-        minY = std::min(v.position.y, minY);
-        minZ = std::min(v.position.z, minZ);
-        maxX = std::max(v.position.x, maxX);
-        maxY = std::max(v.position.y, maxY);
-        maxZ = std::max(v.position.z, maxZ);
+    if (_vertices.empty()) {
+        _boundingBox = BoundingBox();
+        return;
     }
 
-    _boundingBox.min = glm::vec3(minX, minY, minZ);
-    _boundingBox.max = glm::vec3(maxX, maxY, maxZ);
+    _boundingBox = computeBounds(&_vertices[0].position.x, _vertices.size(), sizeof(Vertex));
 }
 
 void Model::initBoxGLResources() {
@@ -241,7 +356,7 @@ void Model::initBoxGLResources() {
     glGenBuffers(1, &_boxVbo);
     glGenBuffers(1, &_boxEbo);
 
-    glBindVertexArray(_boxVao);
+    GLStateCache::bindVertexArray(_boxVao);
     glBindBuffer(GL_ARRAY_BUFFER, _boxVbo);
     glBufferData(
         GL_ARRAY_BUFFER, boxVertices.size() * sizeof(glm::vec3), boxVertices.data(),
@@ -255,7 +370,7 @@ void Model::initBoxGLResources() {
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0);
     glEnableVertexAttribArray(0);
 
-    glBindVertexArray(0);
+    GLStateCache::bindVertexArray(0);
 }
 
 void Model::cleanup() {
@@ -270,7 +385,7 @@ void Model::cleanup() {
     }
 
     if (_boxVao) {
-        glDeleteVertexArrays(1, &_boxVao);
+        GLStateCache::deleteVertexArrays(1, &_boxVao);
         _boxVao = 0;
     }
 
@@ -285,7 +400,7 @@ void Model::cleanup() {
     }
 
     if (_vao != 0) {
-        glDeleteVertexArrays(1, &_vao);
+        GLStateCache::deleteVertexArrays(1, &_vao);
         _vao = 0;
     }
 }
\ No newline at end of file
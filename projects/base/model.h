@@ -1,23 +1,56 @@
 #pragma once
 
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "asset_loader.h"
 #include "bounding_box.h"
 #include "gl_utility.h"
+#include "meshlet.h"
 #include "transform.h"
 #include "vertex.h"
 
 class Model {
 public:
+    // a level of detail stored after the full detail indices in the element buffer
+    struct Lod {
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+        // geometric error in the model space
+        float error = 0.0f;
+    };
+
     Model(const std::string& filepath);
 
-    Model(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+    Model(std::vector<Vertex> vertices, std::vector<uint32_t> indices);
 
     Model(Model&& rhs) noexcept;
 
     virtual ~Model();
 
+    // read an obj file into vertices and indices, it does not touch opengl
+    // and can run on any thread
+    static void loadObj(
+        const std::string& filepath, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+    // parse the obj file on a loader thread, the opengl resources are created
+    // when the loader processes the uploads
+    static AssetHandle<Model> loadAsync(AssetLoader& loader, const std::string& filepath) {
+        using MeshData = std::pair<std::vector<Vertex>, std::vector<uint32_t>>;
+        return loader.load<Model>(
+            [filepath]() {
+                MeshData data;
+                loadObj(filepath, data.first, data.second);
+                return data;
+            },
+            [](MeshData& data) {
+                return std::unique_ptr<Model>(
+                    new Model(std::move(data.first), std::move(data.second)));
+            });
+    }
+
     Model& operator=(const Model& rhs) = delete;
 
     Model& operator=(Model&& rhs) noexcept;
@@ -26,6 +59,8 @@ public:
 
     GLuint getBoundingBoxVao() const;
 
+    GLenum getIndexType() const;
+
     size_t getVertexCount() const;
 
     size_t getFaceCount() const;
@@ -36,6 +71,31 @@ public:
 
     virtual void drawBoundingBox() const;
 
+    // simplify the mesh at the given relative error targets and append the levels
+    // to the element buffer, levels which barely reduce the mesh are skipped
+    void generateLods(const std::vector<float>& errorTargets);
+
+    // take over the lod chain of a model loaded from the same mesh, the levels are copied
+    // on the gpu instead of simplifying the mesh again
+    void copyLods(const Model& source);
+
+    int getLodCount() const;
+
+    const Lod& getLod(int level) const;
+
+    // choose the coarsest level whose error projects to less than errorThreshold pixels,
+    // projectionScale is the pixel count of a unit length at unit distance
+    int selectLod(
+        const glm::mat4& modelMatrix, const glm::vec3& viewPosition, float projectionScale,
+        float errorThreshold = 1.0f) const;
+
+    void drawLod(int level) const;
+
+    // split the full detail mesh into meshlets, which reorders the full detail indices
+    void buildMeshlets(size_t maxVertices = 64, size_t maxTriangles = 124);
+
+    const std::vector<Meshlet>& getMeshlets() const;
+
     const std::vector<uint32_t>& getIndices() const {
         return _indices;
     }
@@ -61,6 +121,12 @@ protected:
     GLuint _vao = 0;
     GLuint _vbo = 0;
     GLuint _ebo = 0;
+    GLenum _indexType = GL_UNSIGNED_INT;
+
+    // lod 0 is the full detail mesh
+    std::vector<Lod> _lods;
+
+    std::vector<Meshlet> _meshlets;
 
     GLuint _boxVao = 0;
     GLuint _boxVbo = 0;
@@ -0,0 +1,358 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "profiler.h"
+
+namespace {
+// open scopes of the threads not owning the profiler
+std::vector<std::pair<const char*, double>>& threadScopeStack() {
+    thread_local std::vector<std::pair<const char*, double>> stack;
+    return stack;
+}
+
+std::string escapeJson(const char* text) {
+    std::string result;
+    for (const char* c = text; *c != '\0'; ++c) {
+        switch (*c) {
+        case '"': result += "\\\""; break;
+        case '\\': result += "\\\\"; break;
+        case '\n': result += "\\n"; break;
+        default: result += *c; break;
+        }
+    }
+
+    return result;
+}
+
+class TraceWriter {
+public:
+    TraceWriter(std::ostream& os) : _os(os) {
+        _os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        _os.setf(std::ios::fixed);
+        _os.precision(3);
+    }
+
+    ~TraceWriter() {
+        _os << "\n]}\n";
+    }
+
+    void threadName(uint32_t tid, const std::string& name) {
+        next();
+        _os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"name\":\"" << name << "\"}}";
+    }
+
+    // the trace event timestamps are in microseconds
+    void complete(const char* name, uint32_t tid, double beginMs, double endMs) {
+        next();
+        _os << "{\"name\":\"" << escapeJson(name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+            << ",\"ts\":" << 1000.0 * beginMs << ",\"dur\":" << 1000.0 * (endMs - beginMs) << "}";
+    }
+
+    void counter(const char* name, double timeMs, double value) {
+        next();
+        _os << "{\"name\":\"" << escapeJson(name) << "\",\"ph\":\"C\",\"pid\":1,\"ts\":"
+            << 1000.0 * timeMs << ",\"args\":{\"value\":" << value << "}}";
+    }
+
+private:
+    std::ostream& _os;
+    bool _first = true;
+
+    void next() {
+        _os << (_first ? "\n" : ",\n");
+        _first = false;
+    }
+};
+
+// the gpu gets its own track, the thread owning the profiler is track 1 and
+// the other threads follow
+constexpr uint32_t gpuTrack = 0;
+
+void writeTraceEvents(
+    std::ostream& os, const std::vector<ProfileFrameRecord>& frames, uint32_t threadCount) {
+    TraceWriter writer(os);
+    writer.threadName(gpuTrack, "gpu");
+    writer.threadName(1, "main");
+    for (uint32_t i = 1; i <= threadCount; ++i) {
+        writer.threadName(i + 1, "thread " + std::to_string(i));
+    }
+
+    for (const auto& frame : frames) {
+        for (const auto& scope : frame.scopes) {
+            writer.complete(scope.name, 1, scope.cpuBeginMs, scope.cpuEndMs);
+            if (frame.gpuOriginCpuMs >= 0.0 && scope.gpuBeginMs >= 0.0) {
+                writer.complete(
+                    scope.name, gpuTrack, frame.gpuOriginCpuMs + scope.gpuBeginMs,
+                    frame.gpuOriginCpuMs + scope.gpuEndMs);
+            }
+        }
+
+        for (const auto& scope : frame.threadScopes) {
+            writer.complete(scope.name, scope.threadIndex + 1, scope.cpuBeginMs, scope.cpuEndMs);
+        }
+
+        const double frameBeginMs = frame.scopes.empty() ? 0.0 : frame.scopes[0].cpuBeginMs;
+        for (const auto& counter : frame.counters) {
+            writer.counter(counter.first, frameBeginMs, counter.second);
+        }
+    }
+}
+} // namespace
+
+Profiler::Profiler(uint32_t latency)
+    : _slots(std::max<uint32_t>(1, latency)), _queries(latency),
+      _epoch(std::chrono::steady_clock::now()), _ownerThread(std::this_thread::get_id()) {
+    // timer queries are core since OpenGL 3.3 but missing in WebGL
+    _gpuTimingSupported = glQueryCounter != nullptr && glGetQueryObjectui64v != nullptr;
+}
+
+Profiler::~Profiler() {
+    // keep the frames captured so far when the application quits during a capture
+    if (!_capturedFrames.empty()) {
+        writeCapture();
+    }
+}
+
+void Profiler::setOwnerThread(std::thread::id id) {
+    _ownerThread.store(id);
+}
+
+void Profiler::beginFrame() {
+    if (_inFrame) {
+        endFrame();
+    }
+
+    // reuse the slot of the frame issued latency frames ago
+    FrameSlot& slot = _slots[_slotIndex];
+    if (slot.pending) {
+        resolve(_slotIndex);
+    }
+
+    slot.record.frameIndex = _frameIndex++;
+    slot.record.scopes.clear();
+    slot.record.threadScopes.clear();
+    slot.record.counters.clear();
+    slot.record.gpuOriginCpuMs = -1.0;
+    slot.queryIndices.clear();
+    _queries.beginFrame();
+
+    // relate the gpu clock to the cpu clock to align the gpu scopes in the trace
+    slot.gpuClockSampled = false;
+    const uint64_t index = slot.record.frameIndex;
+    if (_gpuTimingSupported && index >= _captureBegin && index < _captureEnd) {
+        GLint64 gpuTime = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+        slot.gpuClockOffsetMs = getCpuTimeMs() - 1e-6 * gpuTime;
+        slot.gpuClockSampled = true;
+    }
+
+    _inFrame = true;
+    beginScope("frame");
+}
+
+void Profiler::endFrame() {
+    if (!_inFrame) {
+        return;
+    }
+
+    // close the scopes left open, then the frame itself
+    while (_scopeStack.size() > 1) {
+        endScope();
+    }
+
+    FrameSlot& slot = _slots[_slotIndex];
+    slot.record.scopes[0].cpuEndMs = getCpuTimeMs();
+    slot.queryIndices[0].second = slot.queryIndices[0].first >= 0 ? recordTimestamp() : -1;
+    _scopeStack.clear();
+
+    {
+        std::lock_guard<std::mutex> lock(_threadMutex);
+        slot.record.threadScopes.swap(_pendingThreadScopes);
+        _pendingThreadScopes.clear();
+    }
+
+    slot.pending = true;
+    _inFrame = false;
+    _slotIndex = (_slotIndex + 1) % static_cast<uint32_t>(_slots.size());
+    _queries.endFrame();
+}
+
+void Profiler::beginScope(const char* name, bool gpu) {
+    if (std::this_thread::get_id() != _ownerThread.load()) {
+        beginThreadScope(name);
+        return;
+    }
+
+    if (!_inFrame) {
+        return;
+    }
+
+    FrameSlot& slot = _slots[_slotIndex];
+
+    ProfileScopeRecord scope;
+    scope.name = name;
+    scope.depth = static_cast<int>(_scopeStack.size());
+    scope.cpuBeginMs = getCpuTimeMs();
+
+    _scopeStack.push_back(slot.record.scopes.size());
+    slot.record.scopes.push_back(scope);
+    slot.queryIndices.push_back({gpu ? recordTimestamp() : -1, -1});
+}
+
+void Profiler::endScope() {
+    if (std::this_thread::get_id() != _ownerThread.load()) {
+        endThreadScope();
+        return;
+    }
+
+    // the frame scope is closed by endFrame
+    if (!_inFrame || _scopeStack.size() <= 1) {
+        return;
+    }
+
+    FrameSlot& slot = _slots[_slotIndex];
+    const size_t index = _scopeStack.back();
+    _scopeStack.pop_back();
+
+    slot.record.scopes[index].cpuEndMs = getCpuTimeMs();
+    if (slot.queryIndices[index].first >= 0) {
+        slot.queryIndices[index].second = recordTimestamp();
+    }
+}
+
+void Profiler::setCounter(const char* name, double value) {
+    if (!_inFrame) {
+        return;
+    }
+
+    _slots[_slotIndex].record.counters.push_back({name, value});
+}
+
+void Profiler::startCapture(
+    const std::string& filePath, uint32_t frameCount, uint32_t skipFrames) {
+    if (!_capturedFrames.empty()) {
+        writeCapture();
+    }
+
+    // frames are numbered when they begin, the next one gets _frameIndex
+    std::lock_guard<std::mutex> lock(_uiMutex);
+    _captureFilePath = filePath;
+    _captureBegin = _frameIndex + skipFrames;
+    _captureEnd = _captureBegin + frameCount;
+}
+
+bool Profiler::isCapturing() const {
+    std::lock_guard<std::mutex> lock(_uiMutex);
+    return _captureEnd > _captureBegin;
+}
+
+const ProfileFrameRecord& Profiler::getLastFrame() const {
+    return _lastFrame;
+}
+
+bool Profiler::isGpuTimingSupported() const {
+    return _gpuTimingSupported;
+}
+
+double Profiler::getCpuTimeMs() const {
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - _epoch;
+    return elapsed.count();
+}
+
+int Profiler::recordTimestamp() {
+    return _gpuTimingSupported ? _queries.record() : -1;
+}
+
+void Profiler::resolve(uint32_t slotIndex) {
+    FrameSlot& slot = _slots[slotIndex];
+    slot.pending = false;
+
+    const std::vector<GLuint64> timestamps = _queries.read(slotIndex);
+
+    const int frameBegin = slot.queryIndices.empty() ? -1 : slot.queryIndices[0].first;
+    for (size_t i = 0; i < slot.record.scopes.size(); ++i) {
+        const auto& indices = slot.queryIndices[i];
+        if (frameBegin < 0 || indices.first < 0 || indices.second < 0) {
+            continue;
+        }
+
+        const GLuint64 origin = timestamps[frameBegin];
+        slot.record.scopes[i].gpuBeginMs = 1e-6 * (timestamps[indices.first] - origin);
+        slot.record.scopes[i].gpuEndMs = 1e-6 * (timestamps[indices.second] - origin);
+    }
+
+    if (frameBegin >= 0 && slot.gpuClockSampled) {
+        slot.record.gpuOriginCpuMs = 1e-6 * timestamps[frameBegin] + slot.gpuClockOffsetMs;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_uiMutex);
+        std::swap(_lastFrame, slot.record);
+    }
+
+    const uint64_t index = _lastFrame.frameIndex;
+    if (index >= _captureBegin && index < _captureEnd) {
+        _capturedFrames.push_back(_lastFrame);
+        if (index + 1 == _captureEnd) {
+            writeCapture();
+        }
+    }
+}
+
+void Profiler::beginThreadScope(const char* name) {
+    threadScopeStack().push_back({name, getCpuTimeMs()});
+}
+
+void Profiler::endThreadScope() {
+    auto& stack = threadScopeStack();
+    if (stack.empty()) {
+        return;
+    }
+
+    ProfileScopeRecord scope;
+    scope.name = stack.back().first;
+    scope.cpuBeginMs = stack.back().second;
+    scope.cpuEndMs = getCpuTimeMs();
+    stack.pop_back();
+    scope.depth = static_cast<int>(stack.size());
+
+    std::lock_guard<std::mutex> lock(_threadMutex);
+    scope.threadIndex = getThreadIndex(std::this_thread::get_id());
+    _pendingThreadScopes.push_back(scope);
+}
+
+uint32_t Profiler::getThreadIndex(std::thread::id id) {
+    auto it = std::find(_threads.begin(), _threads.end(), id);
+    if (it == _threads.end()) {
+        it = _threads.insert(_threads.end(), id);
+    }
+
+    return static_cast<uint32_t>(it - _threads.begin()) + 1;
+}
+
+void Profiler::writeCapture() {
+    std::ofstream os(_captureFilePath);
+    if (!os) {
+        std::cerr << "cannot write the trace to " << _captureFilePath << std::endl;
+    } else {
+        uint32_t threadCount = 0;
+        {
+            std::lock_guard<std::mutex> lock(_threadMutex);
+            threadCount = static_cast<uint32_t>(_threads.size());
+        }
+
+        writeTraceEvents(os, _capturedFrames, threadCount);
+        std::cout << "trace of " << _capturedFrames.size() << " frames written to "
+                  << _captureFilePath << std::endl;
+    }
+
+    _capturedFrames.clear();
+
+    std::lock_guard<std::mutex> lock(_uiMutex);
+    _captureBegin = 0;
+    _captureEnd = 0;
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gl_utility.h"
+#include "timestamp_query_ring.h"
+
+struct ProfileScopeRecord {
+    // the name must outlive the profiler, a string literal in practice
+    const char* name = nullptr;
+    // 0 for the frame itself, the scopes nested in it are one level deeper
+    int depth = 0;
+    // 0 for the thread owning the profiler, the other threads are numbered from 1
+    uint32_t threadIndex = 0;
+    // milliseconds since the profiler was created
+    double cpuBeginMs = 0.0;
+    double cpuEndMs = 0.0;
+    // milliseconds since the gpu started the frame, negative without gpu timing
+    double gpuBeginMs = -1.0;
+    double gpuEndMs = -1.0;
+};
+
+struct ProfileFrameRecord {
+    uint64_t frameIndex = 0;
+    // the scopes in the order they began, scopes[0] spans the whole frame
+    std::vector<ProfileScopeRecord> scopes;
+    // cpu scopes of the other threads ended during the frame
+    std::vector<ProfileScopeRecord> threadScopes;
+    std::vector<std::pair<const char*, double>> counters;
+    // cpu time of the first gpu timestamp of the frame, negative when not measured
+    double gpuOriginCpuMs = -1.0;
+};
+
+// hierarchical cpu and gpu profiler. the gpu time of a scope is measured by timestamp
+// queries at its begin and end, which can nest unlike GL_TIME_ELAPSED queries. the results
+// are read latency frames later from a TimestampQueryRing, which never stalls the pipeline.
+// scopes may also be opened on other threads, they are recorded on the cpu only.
+// the ui may be drawn on another thread than the one issuing the frames.
+class Profiler {
+public:
+    Profiler(uint32_t latency = 4);
+
+    Profiler(const Profiler&) = delete;
+
+    Profiler& operator=(const Profiler&) = delete;
+
+    ~Profiler();
+
+    // the thread issuing the frames, the one creating the profiler by default
+    void setOwnerThread(std::thread::id id);
+
+    void beginFrame();
+
+    void endFrame();
+
+    // scopes outside a frame are ignored on the thread owning the profiler
+    void beginScope(const char* name, bool gpu = true);
+
+    void endScope();
+
+    // per frame value such as the draw call count, call it between beginFrame and endFrame
+    void setCounter(const char* name, double value);
+
+    // write the frames [skipFrames, skipFrames + frameCount) from the next one on to filePath
+    // in the chrome trace event format, which chrome://tracing and ui.perfetto.dev open
+    void startCapture(const std::string& filePath, uint32_t frameCount, uint32_t skipFrames = 0);
+
+    bool isCapturing() const;
+
+    // the latest frame with resolved gpu times, empty before the first one is resolved.
+    // call it on the thread owning the profiler
+    const ProfileFrameRecord& getLastFrame() const;
+
+    bool isGpuTimingSupported() const;
+
+    // draw the profiler window, call it between ImGui::NewFrame() and ImGui::Render().
+    // it is defined in profiler_ui.cpp, which only the projects with ImGui build
+    void renderUI() const;
+
+private:
+    struct FrameSlot {
+        ProfileFrameRecord record;
+        // begin and end query of each scope in the slot of the ring, -1 for the cpu only scopes
+        std::vector<std::pair<int, int>> queryIndices;
+        // cpu minus gpu clock in milliseconds, sampled for the captured frames only
+        double gpuClockOffsetMs = 0.0;
+        bool gpuClockSampled = false;
+        bool pending = false;
+    };
+
+    // the slots of the frames and the ones of the queries advance together
+    std::vector<FrameSlot> _slots;
+    uint32_t _slotIndex = 0;
+    TimestampQueryRing _queries;
+    uint64_t _frameIndex = 0;
+    bool _inFrame = false;
+    bool _gpuTimingSupported = false;
+
+    // indices of the open scopes in the record of the current frame
+    std::vector<size_t> _scopeStack;
+
+    ProfileFrameRecord _lastFrame;
+
+    // guards the state renderUI reads against the thread owning the profiler
+    mutable std::mutex _uiMutex;
+
+    std::chrono::steady_clock::time_point _epoch;
+
+    std::atomic<std::thread::id> _ownerThread;
+    std::mutex _threadMutex;
+    std::vector<std::thread::id> _threads;
+    std::vector<ProfileScopeRecord> _pendingThreadScopes;
+
+    std::string _captureFilePath;
+    uint64_t _captureBegin = 0;
+    uint64_t _captureEnd = 0;
+    std::vector<ProfileFrameRecord> _capturedFrames;
+
+    mutable bool _showGpuTimeline = true;
+
+    double getCpuTimeMs() const;
+
+    int recordTimestamp();
+
+    void resolve(uint32_t slotIndex);
+
+    void beginThreadScope(const char* name);
+
+    void endThreadScope();
+
+    uint32_t getThreadIndex(std::thread::id id);
+
+    void writeCapture();
+};
+
+// profile the enclosing block as a scope of the current frame
+class ProfileScope {
+public:
+    ProfileScope(Profiler& profiler, const char* name, bool gpu = true) : _profiler(profiler) {
+        _profiler.beginScope(name, gpu);
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+    ~ProfileScope() {
+        _profiler.endScope();
+    }
+
+private:
+    Profiler& _profiler;
+};
\ No newline at end of file
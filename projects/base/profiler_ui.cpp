@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <functional>
+#include <string>
+
+#include <imgui.h>
+
+#include "profiler.h"
+
+// kept apart from profiler.cpp so that the projects without ImGui can link the profiler
+void Profiler::renderUI() const {
+    const auto flags = ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings;
+    if (!ImGui::Begin("Profiler", nullptr, flags)) {
+        ImGui::End();
+        return;
+    }
+
+    // a copy so that the frames go on while the ui is drawn
+    ProfileFrameRecord lastFrame;
+    std::string captureFilePath;
+    {
+        std::lock_guard<std::mutex> lock(_uiMutex);
+        lastFrame = _lastFrame;
+        if (_captureEnd > _captureBegin) {
+            captureFilePath = _captureFilePath;
+        }
+    }
+
+    if (lastFrame.scopes.empty()) {
+        ImGui::Text("waiting for the first frame ...");
+        ImGui::End();
+        return;
+    }
+
+    if (!captureFilePath.empty()) {
+        ImGui::Text("capturing trace to %s ...", captureFilePath.c_str());
+    }
+
+    const bool showGpu = _showGpuTimeline && _gpuTimingSupported;
+    if (_gpuTimingSupported) {
+        ImGui::Checkbox("gpu timeline", &_showGpuTimeline);
+    }
+
+    // flame view of the frame, one row per nesting level
+    const ProfileScopeRecord& frame = lastFrame.scopes[0];
+    const double frameBegin = showGpu ? frame.gpuBeginMs : frame.cpuBeginMs;
+    const double frameMs = std::max(
+        1e-3, showGpu ? frame.gpuEndMs - frame.gpuBeginMs : frame.cpuEndMs - frame.cpuBeginMs);
+
+    int maxDepth = 0;
+    for (const auto& scope : lastFrame.scopes) {
+        maxDepth = std::max(maxDepth, scope.depth);
+    }
+
+    const float width = 480.0f;
+    const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImGui::InvisibleButton("##flame", ImVec2(width, rowHeight * (maxDepth + 1)));
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    for (const auto& scope : lastFrame.scopes) {
+        const double begin = showGpu ? scope.gpuBeginMs : scope.cpuBeginMs;
+        const double end = showGpu ? scope.gpuEndMs : scope.cpuEndMs;
+        if (begin < 0.0 || end < begin) {
+            continue;
+        }
+
+        const ImVec2 min(
+            origin.x + static_cast<float>((begin - frameBegin) / frameMs) * width,
+            origin.y + scope.depth * rowHeight);
+        const float right = origin.x + static_cast<float>((end - frameBegin) / frameMs) * width;
+        const ImVec2 max(std::max(min.x + 1.0f, right), min.y + rowHeight - 1.0f);
+
+        // the color only depends on the name so that a pass keeps its color across frames
+        const size_t hash = std::hash<std::string>()(scope.name);
+        const ImU32 color =
+            IM_COL32(96 + hash % 128, 96 + (hash >> 8) % 128, 96 + (hash >> 16) % 128, 255);
+        drawList->AddRectFilled(min, max, color);
+
+        const ImVec2 textSize = ImGui::CalcTextSize(scope.name);
+        if (textSize.x + 4.0f < max.x - min.x) {
+            drawList->AddText(ImVec2(min.x + 2.0f, min.y), IM_COL32(0, 0, 0, 255), scope.name);
+        }
+
+        if (ImGui::IsMouseHoveringRect(min, max)) {
+            ImGui::SetTooltip("%s: %.3f ms", scope.name, end - begin);
+        }
+    }
+
+    // the table of all scopes
+    ImGui::Columns(3, "##scopes");
+    ImGui::Text("scope");
+    ImGui::NextColumn();
+    ImGui::Text("cpu (ms)");
+    ImGui::NextColumn();
+    ImGui::Text("gpu (ms)");
+    ImGui::NextColumn();
+    ImGui::Separator();
+
+    for (const auto& scope : lastFrame.scopes) {
+        ImGui::Text("%*s%s", 2 * scope.depth, "", scope.name);
+        ImGui::NextColumn();
+        ImGui::Text("%.3f", scope.cpuEndMs - scope.cpuBeginMs);
+        ImGui::NextColumn();
+        if (scope.gpuBeginMs >= 0.0) {
+            ImGui::Text("%.3f", scope.gpuEndMs - scope.gpuBeginMs);
+        } else {
+            ImGui::Text("-");
+        }
+        ImGui::NextColumn();
+    }
+
+    ImGui::Columns(1);
+
+    for (const auto& counter : lastFrame.counters) {
+        ImGui::Text("%s: %.0f", counter.first, counter.second);
+    }
+
+    ImGui::End();
+}
\ No newline at end of file
@@ -15,7 +15,7 @@ public:
 
     ~Sampler() {
         if (_handle != 0) {
-            glDeleteSamplers(1, &_handle);
+            GLStateCache::deleteSamplers(1, &_handle);
         }
     }
 
@@ -36,11 +36,11 @@ public:
     }
 
     void bind(GLuint texUnit) const {
-        glBindSampler(texUnit, _handle);
+        GLStateCache::bindSampler(texUnit, _handle);
     }
 
     void unbind(GLuint texUnit) const {
-        glBindSampler(texUnit, 0);
+        GLStateCache::bindSampler(texUnit, 0);
     }
 
 private:
@@ -0,0 +1,219 @@
+#include <limits>
+
+#include "simd_bounds.h"
+
+// SSE2 is part of x86-64, msvc does not define __SSE2__ for it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BOUNDS_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(BOUNDS_USE_SSE2) && defined(__AVX__)
+#define BOUNDS_USE_AVX
+#include <immintrin.h>
+#endif
+
+namespace {
+#ifdef BOUNDS_USE_SSE2
+// load x, y, z of a point without reading past its last component
+inline __m128 loadPoint3(const float* p) {
+    return _mm_setr_ps(p[0], p[1], p[2], 0.0f);
+}
+
+// load x, y, z and one float behind, only valid when another float follows the point
+inline __m128 loadPoint4(const float* p) {
+    return _mm_loadu_ps(p);
+}
+
+inline void storePoint3(__m128 v, glm::vec3& p) {
+    float values[4];
+    _mm_storeu_ps(values, v);
+    p = glm::vec3(values[0], values[1], values[2]);
+}
+
+inline __m128 abs(__m128 v) {
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+}
+
+void transformBox(const BoundingBox& box, const float* m, BoundingBox& result) {
+    const __m128 c0 = _mm_loadu_ps(m + 0);
+    const __m128 c1 = _mm_loadu_ps(m + 4);
+    const __m128 c2 = _mm_loadu_ps(m + 8);
+    const __m128 c3 = _mm_loadu_ps(m + 12);
+
+    const glm::vec3 center = 0.5f * (box.max + box.min);
+    const glm::vec3 extent = 0.5f * (box.max - box.min);
+
+    // the new center is the transformed center, the new extent is the extent
+    // transformed by the absolute values of the linear part
+    const __m128 c = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(center.x)), _mm_mul_ps(c1, _mm_set1_ps(center.y))),
+        _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(center.z)), c3));
+    const __m128 e = _mm_add_ps(
+        _mm_add_ps(
+            _mm_mul_ps(abs(c0), _mm_set1_ps(extent.x)), _mm_mul_ps(abs(c1), _mm_set1_ps(extent.y))),
+        _mm_mul_ps(abs(c2), _mm_set1_ps(extent.z)));
+
+    storePoint3(_mm_sub_ps(c, e), result.min);
+    storePoint3(_mm_add_ps(c, e), result.max);
+}
+#endif
+
+#ifdef BOUNDS_USE_AVX
+inline __m256 combine(__m128 lo, __m128 hi) {
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+}
+
+inline __m256 abs(__m256 v) {
+    return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v);
+}
+
+// transform two boxes at once with one box in each 128-bit lane
+void transformBoxPair(const BoundingBox* boxes, const glm::mat4* matrices, BoundingBox* results) {
+    const float* m0 = &matrices[0][0][0];
+    const float* m1 = &matrices[1][0][0];
+    const __m256 c0 = combine(_mm_loadu_ps(m0 + 0), _mm_loadu_ps(m1 + 0));
+    const __m256 c1 = combine(_mm_loadu_ps(m0 + 4), _mm_loadu_ps(m1 + 4));
+    const __m256 c2 = combine(_mm_loadu_ps(m0 + 8), _mm_loadu_ps(m1 + 8));
+    const __m256 c3 = combine(_mm_loadu_ps(m0 + 12), _mm_loadu_ps(m1 + 12));
+
+    const glm::vec3 center0 = 0.5f * (boxes[0].max + boxes[0].min);
+    const glm::vec3 center1 = 0.5f * (boxes[1].max + boxes[1].min);
+    const glm::vec3 extent0 = 0.5f * (boxes[0].max - boxes[0].min);
+    const glm::vec3 extent1 = 0.5f * (boxes[1].max - boxes[1].min);
+
+    __m256 c = c3;
+    __m256 e = _mm256_setzero_ps();
+    const __m256 columns[3] = {c0, c1, c2};
+    for (int j = 0; j < 3; ++j) {
+        const __m256 center = combine(_mm_set1_ps(center0[j]), _mm_set1_ps(center1[j]));
+        const __m256 extent = combine(_mm_set1_ps(extent0[j]), _mm_set1_ps(extent1[j]));
+        c = _mm256_add_ps(c, _mm256_mul_ps(columns[j], center));
+        e = _mm256_add_ps(e, _mm256_mul_ps(abs(columns[j]), extent));
+    }
+
+    const __m256 minValue = _mm256_sub_ps(c, e);
+    const __m256 maxValue = _mm256_add_ps(c, e);
+    storePoint3(_mm256_castps256_ps128(minValue), results[0].min);
+    storePoint3(_mm256_castps256_ps128(maxValue), results[0].max);
+    storePoint3(_mm256_extractf128_ps(minValue, 1), results[1].min);
+    storePoint3(_mm256_extractf128_ps(maxValue, 1), results[1].max);
+}
+#endif
+
+inline const float* advance(const float* p, size_t stride) {
+    return reinterpret_cast<const float*>(reinterpret_cast<const char*>(p) + stride);
+}
+} // namespace
+
+BoundingBox computeBounds(const float* positions, size_t count, size_t stride) {
+    BoundingBox box;
+    if (count == 0) {
+        return box;
+    }
+
+#ifdef BOUNDS_USE_SSE2
+    __m128 minValue = _mm_set1_ps(std::numeric_limits<float>::max());
+    __m128 maxValue = _mm_set1_ps(-std::numeric_limits<float>::max());
+
+    // every point but the last one is followed by at least one float when stride >= 16,
+    // the 4th lane is ignored in the result
+    const size_t wideCount = stride >= 4 * sizeof(float) ? count - 1 : 0;
+    const float* p = positions;
+    size_t i = 0;
+
+#ifdef BOUNDS_USE_AVX
+    __m256 minValue2 = _mm256_set1_ps(std::numeric_limits<float>::max());
+    __m256 maxValue2 = _mm256_set1_ps(-std::numeric_limits<float>::max());
+    for (; i + 2 <= wideCount; i += 2) {
+        const float* q = advance(p, stride);
+        const __m256 v = combine(loadPoint4(p), loadPoint4(q));
+        minValue2 = _mm256_min_ps(minValue2, v);
+        maxValue2 = _mm256_max_ps(maxValue2, v);
+        p = advance(q, stride);
+    }
+
+    minValue = _mm_min_ps(_mm256_castps256_ps128(minValue2), _mm256_extractf128_ps(minValue2, 1));
+    maxValue = _mm_max_ps(_mm256_castps256_ps128(maxValue2), _mm256_extractf128_ps(maxValue2, 1));
+#endif
+
+    // unroll by 4 to hide the latency of min and max
+    for (; i + 4 <= wideCount; i += 4) {
+        const float* p1 = advance(p, stride);
+        const float* p2 = advance(p1, stride);
+        const float* p3 = advance(p2, stride);
+        const __m128 v0 = loadPoint4(p);
+        const __m128 v1 = loadPoint4(p1);
+        const __m128 v2 = loadPoint4(p2);
+        const __m128 v3 = loadPoint4(p3);
+        minValue = _mm_min_ps(minValue, _mm_min_ps(_mm_min_ps(v0, v1), _mm_min_ps(v2, v3)));
+        maxValue = _mm_max_ps(maxValue, _mm_max_ps(_mm_max_ps(v0, v1), _mm_max_ps(v2, v3)));
+        p = advance(p3, stride);
+    }
+
+    for (; i < wideCount; ++i) {
+        const __m128 v = loadPoint4(p);
+        minValue = _mm_min_ps(minValue, v);
+        maxValue = _mm_max_ps(maxValue, v);
+        p = advance(p, stride);
+    }
+
+    for (; i < count; ++i) {
+        const __m128 v = loadPoint3(p);
+        minValue = _mm_min_ps(minValue, v);
+        maxValue = _mm_max_ps(maxValue, v);
+        p = advance(p, stride);
+    }
+
+    storePoint3(minValue, box.min);
+    storePoint3(maxValue, box.max);
+#else
+    const float* p = positions;
+    for (size_t i = 0; i < count; ++i) {
+        box.min = glm::min(box.min, glm::vec3(p[0], p[1], p[2]));
+        box.max = glm::max(box.max, glm::vec3(p[0], p[1], p[2]));
+        p = advance(p, stride);
+    }
+#endif
+
+    return box;
+}
+
+void transformBounds(
+    const BoundingBox* boxes, const glm::mat4* matrices, size_t count, BoundingBox* results) {
+    size_t i = 0;
+
+#ifdef BOUNDS_USE_AVX
+    for (; i + 2 <= count; i += 2) {
+        transformBoxPair(boxes + i, matrices + i, results + i);
+    }
+#endif
+
+#ifdef BOUNDS_USE_SSE2
+    for (; i < count; ++i) {
+        transformBox(boxes[i], &matrices[i][0][0], results[i]);
+    }
+#else
+    for (; i < count; ++i) {
+        const glm::mat4& m = matrices[i];
+        const glm::vec3 center = 0.5f * (boxes[i].max + boxes[i].min);
+        const glm::vec3 extent = 0.5f * (boxes[i].max - boxes[i].min);
+
+        glm::vec3 c = glm::vec3(m[3]);
+        glm::vec3 e = glm::vec3(0.0f);
+        for (int j = 0; j < 3; ++j) {
+            c += glm::vec3(m[j]) * center[j];
+            e += glm::abs(glm::vec3(m[j])) * extent[j];
+        }
+
+        results[i].min = c - e;
+        results[i].max = c + e;
+    }
+#endif
+}
+
+BoundingBox transformBounds(const BoundingBox& box, const glm::mat4& matrix) {
+    BoundingBox result;
+    transformBounds(&box, &matrix, 1, &result);
+    return result;
+}
\ No newline at end of file
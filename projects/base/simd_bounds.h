@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "bounding_box.h"
+
+// bounding box of count points, each point is 3 floats and the points are stride bytes apart,
+// so positions can be read directly from an interleaved vertex array
+BoundingBox computeBounds(const float* positions, size_t count, size_t stride);
+
+// transform count boxes by their matrices into axis aligned boxes in the target space.
+// the boxes are transformed as center and extent (Arvo 1990), which is 2 matrix-vector
+// products per box instead of 8 corners
+void transformBounds(
+    const BoundingBox* boxes, const glm::mat4* matrices, size_t count, BoundingBox* results);
+
+BoundingBox transformBounds(const BoundingBox& box, const glm::mat4& matrix);
\ No newline at end of file
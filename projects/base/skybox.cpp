@@ -23,14 +23,14 @@ SkyBox::SkyBox(const std::vector<std::string>& textureFilenames) {
     glGenVertexArrays(1, &_vao);
     glGenBuffers(1, &_vbo);
 
-    glBindVertexArray(_vao);
+    GLStateCache::bindVertexArray(_vao);
     glBindBuffer(GL_ARRAY_BUFFER, _vbo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_STATIC_DRAW);
 
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), 0);
 
-    glBindVertexArray(0);
+    GLStateCache::bindVertexArray(0);
 
     try {
         // init texture
@@ -100,7 +100,7 @@ void SkyBox::cleanup() {
     }
 
     if (_vao != 0) {
-        glDeleteVertexArrays(1, &_vao);
+        GLStateCache::deleteVertexArrays(1, &_vao);
         _vao = 0;
     }
 }
\ No newline at end of file
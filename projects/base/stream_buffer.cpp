@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "stream_buffer.h"
+
+StreamBuffer::StreamBuffer(size_t frameCapacity, uint32_t frameCount)
+    : _frameCapacity(frameCapacity), _fences(frameCount, nullptr) {
+    if (frameCount == 0) {
+        throw std::runtime_error("stream buffer needs at least one frame");
+    }
+
+    // the first beginFrame() moves to region 0
+    _frameIndex = frameCount - 1;
+
+    // the regions start at multiples of the capacity, round it up so that an allocation
+    // aligned in its region stays aligned for glBindBufferRange in the whole buffer
+    GLint uniformAlignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+    const size_t regionAlignment = std::max<size_t>(uniformAlignment, 256);
+    _frameCapacity = (frameCapacity + regionAlignment - 1) / regionAlignment * regionAlignment;
+
+    if (glBufferStorage != nullptr) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        const size_t size = _frameCapacity * frameCount;
+
+        glGenBuffers(1, &_handle);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, _handle);
+        glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags);
+        _mapped = static_cast<unsigned char*>(
+            glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags));
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        if (_mapped == nullptr) {
+            // the storage is immutable, start over with a mutable buffer
+            glDeleteBuffers(1, &_handle);
+            _handle = 0;
+        }
+    }
+
+    if (_mapped == nullptr) {
+        createOrphaningBuffer();
+    }
+
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        throw std::runtime_error("create stream buffer failure: " + std::to_string(error));
+    }
+}
+
+StreamBuffer::~StreamBuffer() {
+    for (auto& fence : _fences) {
+        if (fence != nullptr) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    if (_handle != 0) {
+        if (_mapped != nullptr) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, _handle);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            _mapped = nullptr;
+        }
+
+        glDeleteBuffers(1, &_handle);
+        _handle = 0;
+    }
+}
+
+void StreamBuffer::beginFrame() {
+    _frameIndex = (_frameIndex + 1) % static_cast<uint32_t>(_fences.size());
+    _frameOffset = 0;
+    _flushedOffset = 0;
+
+    waitFence(_fences[_frameIndex]);
+}
+
+void StreamBuffer::endFrame() {
+    // the orphaned storage is tracked by the driver
+    if (_mapped == nullptr) {
+        return;
+    }
+
+    if (_fences[_frameIndex] != nullptr) {
+        glDeleteSync(_fences[_frameIndex]);
+    }
+
+    _fences[_frameIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+StreamAllocation StreamBuffer::allocate(size_t size, size_t alignment) {
+    // 0 asks for no alignment
+    alignment = std::max<size_t>(alignment, 1);
+    const size_t offset = (_frameOffset + alignment - 1) / alignment * alignment;
+    if (offset + size > _frameCapacity) {
+        throw std::runtime_error(
+            "stream buffer allocation of " + std::to_string(size) + " bytes exceeds the "
+            + std::to_string(_frameCapacity) + " bytes per frame");
+    }
+
+    _frameOffset = offset + size;
+
+    StreamAllocation allocation;
+    if (_mapped != nullptr) {
+        allocation.offset = _frameIndex * _frameCapacity + offset;
+        allocation.data = _mapped + allocation.offset;
+    } else {
+        allocation.offset = offset;
+        allocation.data = _staging.data() + offset;
+    }
+
+    return allocation;
+}
+
+void StreamBuffer::flush() {
+    if (_mapped != nullptr || _flushedOffset == _frameOffset) {
+        return;
+    }
+
+    // orphan the storage read by the earlier draws instead of waiting for them,
+    // the allocations of this frame so far are uploaded again to the new storage
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _handle);
+    glBufferData(GL_COPY_WRITE_BUFFER, _frameCapacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, 0, _frameOffset, _staging.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    _flushedOffset = _frameOffset;
+}
+
+void StreamBuffer::bind(GLenum target) const {
+    glBindBuffer(target, _handle);
+}
+
+void StreamBuffer::unbind(GLenum target) const {
+    glBindBuffer(target, 0);
+}
+
+GLuint StreamBuffer::getHandle() const {
+    return _handle;
+}
+
+bool StreamBuffer::isPersistentlyMapped() const {
+    return _mapped != nullptr;
+}
+
+void StreamBuffer::createOrphaningBuffer() {
+    glGenBuffers(1, &_handle);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _handle);
+    glBufferData(GL_COPY_WRITE_BUFFER, _frameCapacity, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    _staging.resize(_frameCapacity);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+
+#include "gl_utility.h"
+
+// region of the stream buffer written by the cpu, offset is the byte offset in the buffer
+// to pass to the draw or bind call
+struct StreamAllocation {
+    size_t offset = 0;
+    void* data = nullptr;
+};
+
+// ring buffer for the data written once per frame, e.g. uniforms, instance attributes and
+// indirect draw commands. the buffer is split into one region per frame in flight and
+// persistently mapped when glBufferStorage is available (OpenGL 4.4), a fence per region
+// tells when the gpu is done with it, so writes never wait for draws still in flight.
+// otherwise the allocations are staged in memory and uploaded to an orphaned buffer.
+class StreamBuffer {
+public:
+    StreamBuffer(size_t frameCapacity, uint32_t frameCount = 3);
+
+    StreamBuffer(const StreamBuffer&) = delete;
+
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    ~StreamBuffer();
+
+    // move to the region of the next frame, blocks if the gpu still reads it
+    void beginFrame();
+
+    // fence the region of the current frame after its last draw has been submitted
+    void endFrame();
+
+    // bump allocate from the region of the current frame,
+    // throws when the allocations of a frame exceed the frame capacity
+    StreamAllocation allocate(size_t size, size_t alignment = 16);
+
+    // make the writes to the allocations visible to the gpu, call before the draws
+    // reading them. it is a no-op for the mapped buffer
+    void flush();
+
+    void bind(GLenum target) const;
+
+    void unbind(GLenum target) const;
+
+    GLuint getHandle() const;
+
+    bool isPersistentlyMapped() const;
+
+private:
+    GLuint _handle = 0;
+
+    size_t _frameCapacity = 0;
+    size_t _frameOffset = 0;
+    uint32_t _frameIndex = 0;
+    std::vector<GLsync> _fences;
+
+    // base pointer of the persistently mapped buffer
+    unsigned char* _mapped = nullptr;
+
+    // the fallback writes here and orphans the buffer on flush
+    std::vector<unsigned char> _staging;
+    size_t _flushedOffset = 0;
+
+    void createOrphaningBuffer();
+};
\ No newline at end of file
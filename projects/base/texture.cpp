@@ -14,7 +14,7 @@ Texture::Texture(Texture&& rhs) noexcept : _handle(rhs._handle) {
 Texture::~Texture() {
     // destroy texture object
     if (_handle != 0) {
-        glDeleteTextures(1, &_handle);
+        GLStateCache::deleteTextures(1, &_handle);
         _handle = 0;
     }
 }
@@ -35,7 +35,7 @@ void Texture::check() {
 
 void Texture::cleanup() {
     if (_handle != 0) {
-        glDeleteTextures(1, &_handle);
+        GLStateCache::deleteTextures(1, &_handle);
         _handle = 0;
     }
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <cassert>
+#include <cstring>
 #include <sstream>
 #include <stb_image.h>
 
@@ -6,21 +7,21 @@
 
 Texture2D::Texture2D(
     GLint internalFormat, int width, int height, GLenum format, GLenum dataType, void* data) {
-    glBindTexture(GL_TEXTURE_2D, _handle);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, _handle);
     setDefaultParameters();
     glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, dataType, data);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, 0);
 }
 
 Texture2D::Texture2D(Texture2D&& rhs) noexcept : Texture(std::move(rhs)) {}
 
 void Texture2D::bind(int slot) const {
-    glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture(GL_TEXTURE_2D, _handle);
+    GLStateCache::activeTexture(GL_TEXTURE0 + slot);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, _handle);
 }
 
 void Texture2D::unbind() const {
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, 0);
 }
 
 void Texture2D::generateMipmap() const {
@@ -42,41 +43,30 @@ void Texture2D::setDefaultParameters() {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 }
 
-ImageTexture2D::ImageTexture2D(const std::string& path) : _uri(path) {
-    // load image to the memory
-    stbi_set_flip_vertically_on_load(true);
-    int width = 0, height = 0, channels = 0;
-    unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 0);
-    if (data == nullptr) {
-        cleanup();
-        throw std::runtime_error("load " + path + " failure");
-    }
+ImageTexture2D::ImageTexture2D(const std::string& path) : ImageTexture2D(decode(path), path) {}
 
+ImageTexture2D::ImageTexture2D(const ImageData& image, const std::string& uri) : _uri(uri) {
     // choose image format
     GLenum format = GL_RGB;
-    switch (channels) {
+    switch (image.channels) {
     case 1: format = GL_RED; break;
     case 3: format = GL_RGB; break;
     case 4: format = GL_RGBA; break;
-    default:
-        cleanup();
-        stbi_image_free(data);
-        throw std::runtime_error("unsupported format");
+    default: cleanup(); throw std::runtime_error("unsupported format");
     }
     GLint internalFormat = static_cast<GLint>(format);
 
-    glBindTexture(GL_TEXTURE_2D, _handle);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, _handle);
 
     // set texture parameters
     setDefaultParameters();
 
     // transfer the image data to GPU
-    upload(data, width, height, channels, internalFormat, format, GL_UNSIGNED_BYTE);
+    upload(
+        image.pixels.get(), image.width, image.height, image.channels, internalFormat, format,
+        GL_UNSIGNED_BYTE);
 
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    // free data
-    stbi_image_free(data);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, 0);
 
     // check error
     check();
@@ -86,7 +76,7 @@ ImageTexture2D::ImageTexture2D(
     const void* data, int width, int height, int channels, GLint internalformat, GLenum format,
     GLenum type, const std::string& uri)
     : _uri(uri) {
-    glBindTexture(GL_TEXTURE_2D, _handle);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, _handle);
 
     // set texture parameters
     setDefaultParameters();
@@ -94,7 +84,7 @@ ImageTexture2D::ImageTexture2D(
     // transfer the image data to GPU
     upload(data, width, height, channels, internalformat, format, type);
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, 0);
 
     // check error
     check();
@@ -109,6 +99,30 @@ const std::string& ImageTexture2D::getUri() const {
     return _uri;
 }
 
+ImageTexture2D::ImageData ImageTexture2D::decode(const std::string& path) {
+    ImageData image;
+    unsigned char* data = stbi_load(path.c_str(), &image.width, &image.height, &image.channels, 0);
+    if (data == nullptr) {
+        throw std::runtime_error("load " + path + " failure");
+    }
+
+    image.pixels = std::shared_ptr<unsigned char>(data, stbi_image_free);
+
+    // flip the rows here instead of with the global stb flag,
+    // which would race with decoders on other threads
+    const size_t pitch = static_cast<size_t>(image.width) * image.channels;
+    std::vector<unsigned char> row(pitch);
+    for (int y = 0; y < image.height / 2; ++y) {
+        unsigned char* top = data + y * pitch;
+        unsigned char* bottom = data + (image.height - 1 - y) * pitch;
+        std::memcpy(row.data(), top, pitch);
+        std::memcpy(top, bottom, pitch);
+        std::memcpy(bottom, row.data(), pitch);
+    }
+
+    return image;
+}
+
 void ImageTexture2D::setDefaultParameters() {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -142,23 +156,23 @@ void ImageTexture2D::upload(
 
 Texture2DArray::Texture2DArray(
     GLint internalFormat, int width, int height, int layers, GLenum format, GLenum dataType) {
-    glBindTexture(GL_TEXTURE_2D_ARRAY, _handle);
+    GLStateCache::bindTexture(GL_TEXTURE_2D_ARRAY, _handle);
     glTexImage3D(
         GL_TEXTURE_2D_ARRAY, 0, internalFormat, width, height, layers, 0, format, dataType,
         nullptr);
     setDefaultParameters();
-    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    GLStateCache::bindTexture(GL_TEXTURE_2D_ARRAY, 0);
 }
 
 Texture2DArray::Texture2DArray(Texture2DArray&& rhs) noexcept : Texture(std::move(rhs)) {}
 
 void Texture2DArray::bind(int slot) const {
-    glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture(GL_TEXTURE_2D_ARRAY, _handle);
+    GLStateCache::activeTexture(GL_TEXTURE0 + slot);
+    GLStateCache::bindTexture(GL_TEXTURE_2D_ARRAY, _handle);
 }
 
 void Texture2DArray::unbind() const {
-    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    GLStateCache::bindTexture(GL_TEXTURE_2D_ARRAY, 0);
 }
 
 void Texture2DArray::generateMipmap() const {
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <memory>
 #include <string>
 
+#include "asset_loader.h"
 #include "texture.h"
 
 class Texture2D : public Texture {
@@ -32,8 +34,18 @@ private:
 
 class ImageTexture2D : public Texture2D {
 public:
+    // pixels of a decoded image file, flipped vertically for opengl
+    struct ImageData {
+        std::shared_ptr<unsigned char> pixels;
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+    };
+
     ImageTexture2D(const std::string& path);
 
+    ImageTexture2D(const ImageData& image, const std::string& uri);
+
     ImageTexture2D(
         const void* data, int width, int height, int channels, GLint internalformat, GLenum format,
         GLenum type, const std::string& uri);
@@ -44,6 +56,19 @@ public:
 
     const std::string& getUri() const;
 
+    // decode an image file without touching opengl, it can run on any thread
+    static ImageData decode(const std::string& path);
+
+    // decode the image on a loader thread, the texture is created
+    // when the loader processes the uploads
+    static AssetHandle<ImageTexture2D> loadAsync(AssetLoader& loader, const std::string& path) {
+        return loader.load<ImageTexture2D>(
+            [path]() { return decode(path); },
+            [path](ImageData& image) {
+                return std::unique_ptr<ImageTexture2D>(new ImageTexture2D(image, path));
+            });
+    }
+
 private:
     std::string _uri;
 
@@ -5,7 +5,7 @@
 
 TextureCubemap::TextureCubemap(
     GLint internalFormat, int width, int height, GLenum format, GLenum dataType) {
-    glBindTexture(GL_TEXTURE_CUBE_MAP, _handle);
+    GLStateCache::bindTexture(GL_TEXTURE_CUBE_MAP, _handle);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
@@ -18,18 +18,18 @@ TextureCubemap::TextureCubemap(
             dataType, nullptr);
     }
 
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    GLStateCache::bindTexture(GL_TEXTURE_CUBE_MAP, 0);
 }
 
 TextureCubemap::TextureCubemap(TextureCubemap&& rhs) noexcept : Texture(std::move(rhs)) {}
 
 void TextureCubemap::bind(int slot) const {
-    glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, _handle);
+    GLStateCache::activeTexture(GL_TEXTURE0 + slot);
+    GLStateCache::bindTexture(GL_TEXTURE_CUBE_MAP, _handle);
 }
 
 void TextureCubemap::unbind() const {
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    GLStateCache::bindTexture(GL_TEXTURE_CUBE_MAP, 0);
 }
 
 void TextureCubemap::generateMipmap() const {
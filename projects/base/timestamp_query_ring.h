@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "gl_utility.h"
+
+// GL_TIMESTAMP queries of the latest latency frames, one growing pool of queries per frame.
+// the frame issued latency frames ago reuses the slot of the current one, its results are
+// read first and are almost always available by then, so reading them never stalls
+class TimestampQueryRing {
+public:
+    TimestampQueryRing(uint32_t latency = 4) : _slots(std::max<uint32_t>(1, latency)) {}
+
+    TimestampQueryRing(const TimestampQueryRing&) = delete;
+
+    TimestampQueryRing& operator=(const TimestampQueryRing&) = delete;
+
+    ~TimestampQueryRing() {
+        for (auto& slot : _slots) {
+            if (!slot.queries.empty()) {
+                glDeleteQueries(static_cast<GLsizei>(slot.queries.size()), slot.queries.data());
+            }
+        }
+    }
+
+    uint32_t getSlotCount() const {
+        return static_cast<uint32_t>(_slots.size());
+    }
+
+    // the slot the current frame records to
+    uint32_t getSlotIndex() const {
+        return _slotIndex;
+    }
+
+    // whether the slot holds the queries of a frame not read yet
+    bool isPending(uint32_t slotIndex) const {
+        return _slots[slotIndex].pending;
+    }
+
+    // start the frame in the current slot, read it before when it is pending
+    void beginFrame() {
+        _slots[_slotIndex].usedCount = 0;
+        _slots[_slotIndex].pending = false;
+    }
+
+    // issue a timestamp in the current slot, returns its index in the slot
+    int record() {
+        Slot& slot = _slots[_slotIndex];
+        if (slot.usedCount == slot.queries.size()) {
+            slot.queries.push_back(0);
+            glGenQueries(1, &slot.queries.back());
+        }
+
+        glQueryCounter(slot.queries[slot.usedCount], GL_TIMESTAMP);
+
+        return static_cast<int>(slot.usedCount++);
+    }
+
+    // close the frame and move to the next slot
+    void endFrame() {
+        _slots[_slotIndex].pending = true;
+        _slotIndex = (_slotIndex + 1) % static_cast<uint32_t>(_slots.size());
+    }
+
+    // the timestamps in nanoseconds in the order they were recorded,
+    // waits for the gpu when they are not available yet
+    std::vector<GLuint64> read(uint32_t slotIndex) {
+        Slot& slot = _slots[slotIndex];
+        slot.pending = false;
+
+        std::vector<GLuint64> timestamps(slot.usedCount);
+        for (size_t i = 0; i < slot.usedCount; ++i) {
+            glGetQueryObjectui64v(slot.queries[i], GL_QUERY_RESULT, &timestamps[i]);
+        }
+
+        return timestamps;
+    }
+
+private:
+    struct Slot {
+        std::vector<GLuint> queries;
+        size_t usedCount = 0;
+        bool pending = false;
+    };
+
+    std::vector<Slot> _slots;
+    uint32_t _slotIndex = 0;
+};
\ No newline at end of file
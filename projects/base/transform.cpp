@@ -29,4 +29,12 @@ glm::vec3 Transform::getRight() const {
 glm::mat4 Transform::getLocalMatrix() const {
     return glm::translate(glm::mat4(1.0f), position) * glm::mat4_cast(rotation)
            * glm::scale(glm::mat4(1.0f), scale);
+}
+
+Transform Transform::interpolate(const Transform& from, const Transform& to, float t) {
+    Transform transform;
+    transform.position = glm::mix(from.position, to.position, t);
+    transform.rotation = glm::slerp(from.rotation, to.rotation, t);
+    transform.scale = glm::mix(from.scale, to.scale, t);
+    return transform;
 }
\ No newline at end of file
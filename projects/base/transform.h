@@ -24,6 +24,9 @@ public:
 
     glm::mat4 getLocalMatrix() const;
 
+    // blend of two transforms for t in [0, 1], the rotation is slerped
+    static Transform interpolate(const Transform& from, const Transform& to, float t);
+
     static constexpr glm::vec3 getDefaultFront() {
         return {0.0f, 0.0f, -1.0f};
     }
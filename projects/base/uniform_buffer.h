@@ -1,21 +1,43 @@
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <limits>
 #include <map>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 #include "gl_utility.h"
 
+// offset of a variable of type T in a uniform block, resolved once by name
+template <typename T>
+struct UniformBufferHandle {
+    size_t offset = std::numeric_limits<size_t>::max();
+
+    bool valid() const {
+        return offset != std::numeric_limits<size_t>::max();
+    }
+};
+
+// the buffer keeps a cpu copy of the block, set() only writes the copy and extends the
+// dirty range when the value changes, flush() uploads the dirty range in one call
 class UniformBuffer {
 public:
-    UniformBuffer(size_t bufferSize, GLenum usage) {
+    UniformBuffer(size_t bufferSize, GLenum usage) : _data(bufferSize, 0) {
         glGenBuffers(1, &_handle);
         glBindBuffer(GL_UNIFORM_BUFFER, _handle);
         glBufferData(GL_UNIFORM_BUFFER, bufferSize, nullptr, usage);
         glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        // the storage is uninitialized, the first flush uploads the whole block
+        markDirty(0, bufferSize);
     }
 
     UniformBuffer(UniformBuffer&& rhs) noexcept
-        : _handle(rhs._handle), _offsetMap(std::move(rhs._offsetMap)) {
+        : _handle(rhs._handle), _offsetMap(std::move(rhs._offsetMap)),
+          _data(std::move(rhs._data)), _dirtyBegin(rhs._dirtyBegin), _dirtyEnd(rhs._dirtyEnd) {
         rhs._handle = 0;
     }
 
@@ -35,33 +57,70 @@ public:
     }
 
     template <typename T>
-    void update(const std::string& name, const T& value) const {
+    UniformBufferHandle<T> getHandle(const std::string& name) const {
+        UniformBufferHandle<T> handle;
         const auto iter = _offsetMap.find(name);
         if (iter == _offsetMap.end()) {
             std::cerr << "cannot find " + name + " in the ubo" << std::endl;
+        } else if (iter->second + sizeof(Stored<T>) > _data.size()) {
+            std::cerr << name + " exceeds the ubo" << std::endl;
+        } else {
+            handle.offset = iter->second;
+        }
+
+        return handle;
+    }
+
+    template <typename T>
+    void set(UniformBufferHandle<T> handle, const T& value) {
+        if (!handle.valid()) {
+            return;
+        }
+
+        // bool is 4 bytes in std140
+        const Stored<T> stored = static_cast<Stored<T>>(value);
+        unsigned char* dst = _data.data() + handle.offset;
+        if (std::memcmp(dst, &stored, sizeof(stored)) != 0) {
+            std::memcpy(dst, &stored, sizeof(stored));
+            markDirty(handle.offset, handle.offset + sizeof(stored));
+        }
+    }
+
+    // stages the value like set(), nothing reaches the gpu before flush(). looks the name up
+    // on every call, prefer the handle version for per frame updates
+    template <typename T>
+    void update(const std::string& name, const T& value) {
+        set(getHandle<T>(name), value);
+    }
+
+    // upload the merged range of the values changed since the last flush
+    void flush() {
+        if (_dirtyBegin >= _dirtyEnd) {
             return;
         }
 
         glBindBuffer(GL_UNIFORM_BUFFER, _handle);
-        glBufferSubData(GL_UNIFORM_BUFFER, iter->second, sizeof(T), &value);
+        glBufferSubData(
+            GL_UNIFORM_BUFFER, _dirtyBegin, _dirtyEnd - _dirtyBegin, _data.data() + _dirtyBegin);
         glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        _dirtyBegin = _data.size();
+        _dirtyEnd = 0;
     }
 
 private:
+    template <typename T>
+    using Stored = typename std::conditional<std::is_same<T, bool>::value, int, T>::type;
+
     GLuint _handle{};
     std::map<std::string, size_t> _offsetMap;
-};
 
-template <>
-inline void UniformBuffer::update<bool>(const std::string& name, const bool& value) const {
-    const auto iter = _offsetMap.find(name);
-    if (iter == _offsetMap.end()) {
-        std::cerr << "cannot find " + name + " in the ubo" << std::endl;
-        return;
-    }
+    std::vector<unsigned char> _data;
+    size_t _dirtyBegin = 0;
+    size_t _dirtyEnd = 0;
 
-    int intVal = static_cast<int>(value);
-    glBindBuffer(GL_UNIFORM_BUFFER, _handle);
-    glBufferSubData(GL_UNIFORM_BUFFER, iter->second, sizeof(int), &intVal);
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
-}
\ No newline at end of file
+    void markDirty(size_t begin, size_t end) {
+        _dirtyBegin = std::min(_dirtyBegin, begin);
+        _dirtyEnd = std::max(_dirtyEnd, end);
+    }
+};
\ No newline at end of file
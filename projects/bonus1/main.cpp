@@ -2,6 +2,8 @@
 #include <cstdlib>
 #include <iostream>
 
+#include "../base/command_line.h"
+
 Options getOptions(int argc, char* argv[]) {
     Options options;
     options.windowTitle = "Transparency";
@@ -14,6 +16,8 @@ Options getOptions(int argc, char* argv[]) {
     options.backgroundColor = glm::vec4(0.051f, 0.142f, 0.191f, 1.0f);
     options.assetRootDir = "../../media/";
 
+    parseCommonOptions(CommandLine(argc, argv), options);
+
     return options;
 }
 
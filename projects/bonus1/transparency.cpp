@@ -1,3 +1,5 @@
+#include <stdexcept>
+
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
@@ -25,10 +27,28 @@ const std::string oitBlendFsRelPath = "shader/bonus1/oit_blend.frag";
 const std::string oitFinalVsRelPath = "shader/bonus1/quad.vert";
 const std::string oitFinalFsRelPath = "shader/bonus1/oit_final.frag";
 
+static RenderMode parseRenderMode(const std::string& name) {
+    if (name == "alpha-testing") {
+        return RenderMode::AlphaTesting;
+    } else if (name == "alpha-blending") {
+        return RenderMode::AlphaBlending;
+    } else if (name == "depth-peeling") {
+        return RenderMode::DepthPeeling;
+    }
+
+    throw std::runtime_error(
+        "unknown render mode " + name + ", expect alpha-testing, alpha-blending or depth-peeling");
+}
+
 Transparency::Transparency(const Options& options) : Application(options) {
+    if (!options.renderMode.empty()) {
+        _renderMode = parseRenderMode(options.renderMode);
+    }
+
     // init models
     _knot.reset(new Model(getAssetFullPath(knotRelPath)));
     _knot->transform.scale = glm::vec3(0.8f, 0.8f, 0.8f);
+    _previousKnotTransform = _knot->transform;
 
     // init light
     _light.reset(new DirectionalLight());
@@ -168,20 +188,29 @@ void Transparency::handleInput() {
         glfwSetWindowShouldClose(_window, true);
         return;
     }
+}
+
+void Transparency::updateSimulation(float dt) {
+    _previousKnotTransform = _knot->transform;
 
     const float angluarVelocity = 0.1f;
-    const float angle = angluarVelocity * static_cast<float>(_deltaTime);
+    const float angle = angluarVelocity * dt;
     const glm::vec3 axis = glm::vec3(0.0f, 1.0f, 0.0f);
     _knot->transform.rotation = glm::angleAxis(angle, axis) * _knot->transform.rotation;
 }
 
+glm::mat4 Transparency::getKnotModelMatrix() const {
+    return Transform::interpolate(_previousKnotTransform, _knot->transform, _interpolationAlpha)
+        .getLocalMatrix();
+}
+
 void Transparency::renderFrame() {
     // trivial things
     showFpsInWindowTitle();
 
     glClearColor(_clearColor.r, _clearColor.g, _clearColor.b, _clearColor.a);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glEnable(GL_DEPTH_TEST);
+    GLStateCache::enable(GL_DEPTH_TEST);
 
     switch (_renderMode) {
     case RenderMode::AlphaTesting: renderWithAlphaTesting(); break;
@@ -198,7 +227,7 @@ void Transparency::renderWithAlphaTesting() {
     // 1 set transformation matrices
     _alphaTestingShader->setUniformMat4("projection", _camera->getProjectionMatrix());
     _alphaTestingShader->setUniformMat4("view", _camera->getViewMatrix());
-    _alphaTestingShader->setUniformMat4("model", _knot->transform.getLocalMatrix());
+    _alphaTestingShader->setUniformMat4("model", getKnotModelMatrix());
     // 2 set light
     _alphaTestingShader->setUniformVec3("directionalLight.direction", _light->transform.getFront());
     _alphaTestingShader->setUniformFloat("directionalLight.intensity", _light->intensity);
@@ -220,7 +249,7 @@ void Transparency::renderWithAlphaBlending() {
     // 1 set transformation matrices
     _alphaBlendingShader->setUniformMat4("projection", _camera->getProjectionMatrix());
     _alphaBlendingShader->setUniformMat4("view", _camera->getViewMatrix());
-    _alphaBlendingShader->setUniformMat4("model", _knot->transform.getLocalMatrix());
+    _alphaBlendingShader->setUniformMat4("model", getKnotModelMatrix());
     // 2 set light
     _alphaBlendingShader->setUniformVec3(
         "directionalLight.direction", _light->transform.getFront());
@@ -269,13 +298,13 @@ void Transparency::renderWithDepthPeeling() {
 
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glEnable(GL_DEPTH_TEST);
+    GLStateCache::enable(GL_DEPTH_TEST);
 
     _depthPeelingInitShader->use();
     // 1.1 set transformation matrices
     _depthPeelingInitShader->setUniformMat4("projection", projection);
     _depthPeelingInitShader->setUniformMat4("view", view);
-    _depthPeelingInitShader->setUniformMat4("model", _knot->transform.getLocalMatrix());
+    _depthPeelingInitShader->setUniformMat4("model", getKnotModelMatrix());
     // 1.2 set light
     _depthPeelingInitShader->setUniformVec3(
         "directionalLight.direction", _light->transform.getFront());
@@ -306,8 +335,8 @@ void Transparency::renderWithDepthPeeling() {
     // ------------------------------------------------------------------------
 
     // 3. final pass: blend the peeling result with the background color
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glDisable(GL_DEPTH_TEST);
+    GLStateCache::bindFramebuffer(GL_FRAMEBUFFER, getDefaultFramebuffer());
+    GLStateCache::disable(GL_DEPTH_TEST);
     _depthPeelingFinalShader->use();
     // 3.1 set the window extent
     _depthPeelingFinalShader->setUniformInt("windowExtent.width", _windowWidth);
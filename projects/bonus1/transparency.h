@@ -33,6 +33,8 @@ private:
     enum RenderMode _renderMode = RenderMode::AlphaTesting;
 
     std::unique_ptr<Model> _knot;
+    // the knot before the last simulation step, for the interpolation
+    Transform _previousKnotTransform;
 
     std::unique_ptr<TransparentMaterial> _knotMaterial;
 
@@ -66,8 +68,12 @@ private:
 
     void handleInput() override;
 
+    void updateSimulation(float dt) override;
+
     void renderFrame() override;
 
+    glm::mat4 getKnotModelMatrix() const;
+
     void renderWithAlphaTesting();
 
     void renderWithAlphaBlending();
@@ -1,14 +1,20 @@
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
+#include <cstring>
 
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 
 #include "frustum_culling.h"
+#include "../base/frame_rate_panel.h"
 
 const std::string planetRelPath = "obj/sphere.obj";
 const std::string planetTextureRelPath = "texture/miscellaneous/planet_Quom1200.png";
 
+const std::string lucyRelPath = "obj/lucy.obj";
+
 const std::string asternoldRelPath = "obj/rock.obj";
 const std::string asternoldTextureRelPath = "texture/miscellaneous/Rock-Texture-Surface.jpg";
 
@@ -20,6 +26,9 @@ const std::string lambertVsRelPath = "shader/bonus2/lambert.vert";
 const std::string lambertInstancedVsRelPath = "shader/bonus2/lambert_instanced.vert";
 const std::string lambertFsRelPath = "shader/bonus2/lambert.frag";
 
+// relative errors of the asternoid lod chain
+const std::vector<float> lodErrorTargets = {0.01f, 0.03f, 0.08f};
+
 const std::string frustumCullingVsRelPath = "shader/bonus2/frustum_culling.vert";
 
 FrustumCulling::FrustumCulling(const Options& options) : Application(options) {
@@ -29,11 +38,24 @@ FrustumCulling::FrustumCulling(const Options& options) : Application(options) {
     // init model
     _planet.reset(new Model(getAssetFullPath(planetRelPath)));
     _planet->transform.scale = glm::vec3(10.0f, 10.0f, 10.0f);
+    _planet->buildMeshlets();
+
+    // lucy stands on the top of the planet
+    _lucy.reset(new Model(getAssetFullPath(lucyRelPath)));
+    const BoundingBox lucyBox = _lucy->getBoundingBox();
+    const float lucyScale = 8.0f / std::max(lucyBox.max.y - lucyBox.min.y, 1e-3f);
+    _lucy->transform.scale = glm::vec3(lucyScale);
+    _lucy->transform.position = glm::vec3(0.0f, 10.0f - lucyBox.min.y * lucyScale, 0.0f);
+    _lucy->buildMeshlets();
 
     _asternoid.reset(new Model(getAssetFullPath(asternoldRelPath)));
     _instancedAsternoids.reset(
         new InstancedModel(getAssetFullPath(asternoldRelPath), _modelMatrices));
 
+    // both models draw the same mesh, the chain is simplified once
+    _asternoid->generateLods(lodErrorTargets);
+    _instancedAsternoids->copyLods(*_asternoid);
+
     // init textures
     auto planetTexture = std::make_shared<ImageTexture2D>(getAssetFullPath(planetTextureRelPath));
     auto asternoidTexture =
@@ -48,6 +70,10 @@ FrustumCulling::FrustumCulling(const Options& options) : Application(options) {
     _planetMaterial->kd = glm::vec3(1.0f, 1.0f, 1.0f);
     _planetMaterial->mapKd = planetTexture;
 
+    _lucyMaterial.reset(new LambertMaterial);
+    _lucyMaterial->kd = glm::vec3(0.8f, 0.8f, 0.8f);
+    _lucyMaterial->mapKd = asternoidTexture;
+
     _asternoidMaterial.reset(new LambertMaterial);
     _asternoidMaterial->kd = glm::vec3(1.0f, 1.0f, 1.0f);
     _asternoidMaterial->mapKd = asternoidTexture;
@@ -70,13 +96,17 @@ FrustumCulling::FrustumCulling(const Options& options) : Application(options) {
 
     // init visible array
     _visibles.resize(_amount, 1);
+    _lodLevels.resize(_amount, 0);
 
     // init gpu frustum culling resources
     initGPUCullingResources();
 
     // init indirect draw resources
     _indirectDrawCmds.reserve(_amount);
-    glGenBuffers(1, &_indirectBuffer);
+    // at most one command per meshlet and two per asternoid with the bounding boxes
+    const size_t maxIndirectCmds =
+        _planet->getMeshlets().size() + _lucy->getMeshlets().size() + 2 * _amount;
+    _indirectStream.reset(new StreamBuffer(maxIndirectCmds * sizeof(DrawElementsIndirectCommand)));
 
     // init imGUI
     IMGUI_CHECKVERSION();
@@ -101,12 +131,6 @@ FrustumCulling::~FrustumCulling() {
         _transformFeedbackResultBuffer = 0;
     }
 
-    // destroy indirect draw resources
-    if (_indirectBuffer) {
-        glDeleteBuffers(1, &_indirectBuffer);
-        _indirectBuffer = 0;
-    }
-
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -215,40 +239,32 @@ void FrustumCulling::handleInput() {
 }
 
 void FrustumCulling::renderFrame() {
+    _indirectStream->beginFrame();
+
     glClearColor(_clearColor.r, _clearColor.g, _clearColor.b, _clearColor.a);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glEnable(GL_DEPTH_TEST);
+    GLStateCache::enable(GL_DEPTH_TEST);
 
     const Frustum frustum = _camera->getFrustum();
     const glm::mat4 projection = _camera->getProjectionMatrix();
     const glm::mat4 view = _camera->getViewMatrix();
 
-    // draw planet
-    if (frustum.intersect(_planet->getBoundingBox(), _planet->transform.getLocalMatrix())) {
-        _lambertShader->use();
-        _lambertShader->setUniformMat4("projection", projection);
-        _lambertShader->setUniformMat4("view", view);
-        _lambertShader->setUniformMat4("model", _planet->transform.getLocalMatrix());
-        _lambertShader->setUniformVec3("light.direction", _light->transform.getFront());
-        _lambertShader->setUniformVec3("light.color", _light->color);
-        _lambertShader->setUniformFloat("light.intensity", _light->intensity);
-        _lambertShader->setUniformVec3("material.kd", _planetMaterial->kd);
-        glActiveTexture(GL_TEXTURE0);
-        _planetMaterial->mapKd->bind();
-
-        _planet->draw();
-    }
+    // draw planet and lucy
+    _drawPlanetTriangleCount = renderLambertModel(*_planet, *_planetMaterial, frustum);
+    _drawLucyTriangleCount = renderLambertModel(*_lucy, *_lucyMaterial, frustum);
 
-    // draw planet aabb
+    // draw planet and lucy aabb
     if (_showBoundingBox) {
         _lineShader->use();
         _lineShader->setUniformMat4("projection", projection);
         _lineShader->setUniformMat4("view", view);
-        _lineShader->setUniformMat4("model", _planet->transform.getLocalMatrix());
         _lineShader->setUniformVec3("material.color", _lineMaterial->color);
         glLineWidth(_lineMaterial->width);
 
+        _lineShader->setUniformMat4("model", _planet->transform.getLocalMatrix());
         _planet->drawBoundingBox();
+        _lineShader->setUniformMat4("model", _lucy->transform.getLocalMatrix());
+        _lucy->drawBoundingBox();
     }
 
     // test visiblity
@@ -270,6 +286,8 @@ void FrustumCulling::renderFrame() {
         break;
     }
 
+    selectAsternoidLods();
+
     if (_indirectDrawEnabled) {
         renderAsternoidsIndirect();
     } else {
@@ -293,6 +311,9 @@ void FrustumCulling::renderFrame() {
 
         ImGui::Checkbox("draw indirect", (bool*)&_indirectDrawEnabled);
         ImGui::Checkbox("show bounding box", (bool*)&_showBoundingBox);
+        ImGui::Checkbox("meshlet culling", &_meshletCullingEnabled);
+        ImGui::Checkbox("level of detail", &_lodEnabled);
+        ImGui::SliderFloat("lod error (px)", &_lodErrorThreshold, 0.5f, 8.0f);
         ImGui::NewLine();
 
         float fraction = 1.0f * _drawAsternoidCount / _amount;
@@ -301,17 +322,122 @@ void FrustumCulling::renderFrame() {
         ImGui::ProgressBar(fraction, ImVec2(0.0f, 0.0f), fracInfo.c_str());
         ImGui::NewLine();
 
-        std::string fpsInfo = "avg fps: " + std::to_string(_fpsIndicator.getAverageFrameRate());
-        ImGui::Text("%s", fpsInfo.c_str());
-        ImGui::PlotLines(
-            "", _fpsIndicator.getDataPtr(), _fpsIndicator.getSize(), 0, nullptr, 0.0f,
-            std::numeric_limits<float>::max(), ImVec2(240.0f, 50.0f));
+        const size_t planetFaceCount = _planet->getFaceCount();
+        fraction = 1.0f * _drawPlanetTriangleCount / planetFaceCount;
+        fracInfo = std::to_string(_drawPlanetTriangleCount) + "/" + std::to_string(planetFaceCount);
+        ImGui::Text("planet triangles");
+        ImGui::ProgressBar(fraction, ImVec2(0.0f, 0.0f), fracInfo.c_str());
+        ImGui::NewLine();
+
+        const size_t lucyFaceCount = _lucy->getFaceCount();
+        fraction = 1.0f * _drawLucyTriangleCount / lucyFaceCount;
+        fracInfo = std::to_string(_drawLucyTriangleCount) + "/" + std::to_string(lucyFaceCount);
+        ImGui::Text("lucy triangles");
+        ImGui::ProgressBar(fraction, ImVec2(0.0f, 0.0f), fracInfo.c_str());
+        ImGui::NewLine();
+
+        drawFrameRatePanel(_fpsIndicator);
 
         ImGui::End();
     }
 
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+    _indirectStream->endFrame();
+}
+
+size_t FrustumCulling::renderLambertModel(
+    const Model& model, const LambertMaterial& material, const Frustum& frustum) {
+    const glm::mat4 modelMatrix = model.transform.getLocalMatrix();
+    if (!frustum.intersect(model.getBoundingBox(), modelMatrix)) {
+        return 0;
+    }
+
+    const glm::mat4 projection = _camera->getProjectionMatrix();
+    const glm::mat4 view = _camera->getViewMatrix();
+
+    _lambertShader->use();
+    _lambertShader->setUniformMat4("projection", projection);
+    _lambertShader->setUniformMat4("view", view);
+    _lambertShader->setUniformMat4("model", modelMatrix);
+    _lambertShader->setUniformVec3("light.direction", _light->transform.getFront());
+    _lambertShader->setUniformVec3("light.color", _light->color);
+    _lambertShader->setUniformFloat("light.intensity", _light->intensity);
+    _lambertShader->setUniformVec3("material.kd", material.kd);
+    GLStateCache::activeTexture(GL_TEXTURE0);
+    material.mapKd->bind();
+
+    if (_meshletCullingEnabled) {
+        return drawMeshlets(model, projection * view);
+    }
+
+    model.draw();
+    return model.getFaceCount();
+}
+
+size_t FrustumCulling::drawMeshlets(const Model& model, const glm::mat4& viewProjection) {
+    _meshletCmds.clear();
+    cullMeshlets(
+        model.getMeshlets(), model.transform.getLocalMatrix(), viewProjection,
+        _camera->transform.position, _meshletCmds);
+
+    size_t triangleCount = 0;
+    for (const auto& cmd : _meshletCmds) {
+        triangleCount += cmd.count / 3;
+    }
+
+    if (_meshletCmds.empty()) {
+        return 0;
+    }
+
+    const GLenum indexType = model.getIndexType();
+    GLStateCache::bindVertexArray(model.getVao());
+
+    if (glMultiDrawElementsIndirect != nullptr) {
+        const size_t offset = streamIndirectCommands(_meshletCmds);
+        _indirectStream->bind(GL_DRAW_INDIRECT_BUFFER);
+
+        glMultiDrawElementsIndirect(
+            GL_TRIANGLES, indexType, reinterpret_cast<const void*>(offset),
+            static_cast<GLsizei>(_meshletCmds.size()), 0);
+
+        _indirectStream->unbind(GL_DRAW_INDIRECT_BUFFER);
+    } else {
+        // the indirect draw is not available before OpenGL 4.3
+        _meshletIndexCounts.clear();
+        _meshletIndexOffsets.clear();
+        for (const auto& cmd : _meshletCmds) {
+            _meshletIndexCounts.push_back(static_cast<GLsizei>(cmd.count));
+            _meshletIndexOffsets.push_back(
+                reinterpret_cast<const void*>(cmd.firstIndex * getIndexTypeSize(indexType)));
+        }
+
+        glMultiDrawElements(
+            GL_TRIANGLES, _meshletIndexCounts.data(), indexType, _meshletIndexOffsets.data(),
+            static_cast<GLsizei>(_meshletIndexCounts.size()));
+    }
+
+    GLStateCache::bindVertexArray(0);
+
+    return triangleCount;
+}
+
+void FrustumCulling::selectAsternoidLods() {
+    if (!_lodEnabled) {
+        std::fill(_lodLevels.begin(), _lodLevels.end(), 0);
+        return;
+    }
+
+    // pixels covered by a unit length at unit distance
+    const float projectionScale = 0.5f * _windowHeight / std::tan(0.5f * _camera->fovy);
+    const glm::vec3 viewPosition = _camera->transform.position;
+    for (int i = 0; i < _amount; ++i) {
+        if (_visibles[i]) {
+            _lodLevels[i] = _asternoid->selectLod(
+                _modelMatrices[i], viewPosition, projectionScale, _lodErrorThreshold);
+        }
+    }
 }
 
 void FrustumCulling::renderAsternoids() {
@@ -327,13 +453,13 @@ void FrustumCulling::renderAsternoids() {
     _lambertShader->setUniformVec3("light.color", _light->color);
     _lambertShader->setUniformFloat("light.intensity", _light->intensity);
     _lambertShader->setUniformVec3("material.kd", _asternoidMaterial->kd);
-    glActiveTexture(GL_TEXTURE0);
+    GLStateCache::activeTexture(GL_TEXTURE0);
     _asternoidMaterial->mapKd->bind();
 
     for (int i = 0; i < _amount; ++i) {
         if (_visibles[i]) {
             _lambertShader->setUniformMat4("model", _modelMatrices[i]);
-            _asternoid->draw();
+            _asternoid->drawLod(_lodLevels[i]);
             ++_drawAsternoidCount;
         }
     }
@@ -359,23 +485,35 @@ void FrustumCulling::renderAsternoidsIndirect() {
 
     const glm::mat4 projection = _camera->getProjectionMatrix();
     const glm::mat4 view = _camera->getViewMatrix();
-    const uint32_t count = static_cast<uint32_t>(_asternoid->getFaceCount() * 3);
+    // merge the consecutive visible instances with the same lod into one command
     uint32_t instanceCount = 0;
+    int lodLevel = 0;
+    auto flushCommand = [&](int end) {
+        if (instanceCount > 0) {
+            const Model::Lod& lod = _instancedAsternoids->getLod(lodLevel);
+            _indirectDrawCmds.push_back(
+                {lod.indexCount, instanceCount, lod.firstIndex, 0, end - instanceCount});
+            instanceCount = 0;
+        }
+    };
 
     for (int i = 0; i < _amount; ++i) {
-        if (_visibles[i]) {
-            ++instanceCount;
-            ++_drawAsternoidCount;
-        } else {
-            _indirectDrawCmds.push_back({count, instanceCount, 0, 0, i - instanceCount});
-            instanceCount = 0;
+        if (!_visibles[i]) {
+            flushCommand(i);
+            continue;
         }
-    }
 
-    if (instanceCount > 0) {
-        _indirectDrawCmds.push_back({count, instanceCount, 0, 0, _amount - instanceCount});
+        if (instanceCount > 0 && _lodLevels[i] != lodLevel) {
+            flushCommand(i);
+        }
+
+        lodLevel = _lodLevels[i];
+        ++instanceCount;
+        ++_drawAsternoidCount;
     }
 
+    flushCommand(_amount);
+
     _lambertInstancedShader->use();
     _lambertInstancedShader->setUniformMat4("projection", projection);
     _lambertInstancedShader->setUniformMat4("view", view);
@@ -383,25 +521,25 @@ void FrustumCulling::renderAsternoidsIndirect() {
     _lambertInstancedShader->setUniformVec3("light.color", _light->color);
     _lambertInstancedShader->setUniformFloat("light.intensity", _light->intensity);
     _lambertInstancedShader->setUniformVec3("material.kd", _asternoidMaterial->kd);
-    glActiveTexture(GL_TEXTURE0);
+    GLStateCache::activeTexture(GL_TEXTURE0);
     _asternoidMaterial->mapKd->bind();
 
-    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _indirectBuffer);
-    glBufferData(
-        GL_DRAW_INDIRECT_BUFFER, _indirectDrawCmds.size() * sizeof(DrawElementsIndirectCommand),
-        _indirectDrawCmds.data(), GL_STREAM_DRAW);
+    size_t offset = streamIndirectCommands(_indirectDrawCmds);
+    _indirectStream->bind(GL_DRAW_INDIRECT_BUFFER);
 
-    glBindVertexArray(_instancedAsternoids->getVao());
+    GLStateCache::bindVertexArray(_instancedAsternoids->getVao());
 
     glMultiDrawElementsIndirect(
-        GL_TRIANGLES, GL_UNSIGNED_INT, 0, static_cast<GLsizei>(_indirectDrawCmds.size()), 0);
+        GL_TRIANGLES, _instancedAsternoids->getIndexType(), reinterpret_cast<const void*>(offset),
+        static_cast<GLsizei>(_indirectDrawCmds.size()), 0);
 
-    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
-    glBindVertexArray(0);
+    _indirectStream->unbind(GL_DRAW_INDIRECT_BUFFER);
+    GLStateCache::bindVertexArray(0);
 
     if (_showBoundingBox) {
         for (auto& cmd : _indirectDrawCmds) {
             cmd.count = 24;
+            cmd.firstIndex = 0;
         }
 
         _lineInstancedShader->use();
@@ -410,19 +548,30 @@ void FrustumCulling::renderAsternoidsIndirect() {
         glLineWidth(_lineMaterial->width);
         _lineInstancedShader->setUniformVec3("material.color", _lineMaterial->color);
 
-        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _indirectBuffer);
-        glBufferSubData(
-            GL_DRAW_INDIRECT_BUFFER, 0,
-            _indirectDrawCmds.size() * sizeof(DrawElementsIndirectCommand),
-            _indirectDrawCmds.data());
+        // the commands of the asternoids may still be read by the gpu, stream a new copy
+        offset = streamIndirectCommands(_indirectDrawCmds);
+        _indirectStream->bind(GL_DRAW_INDIRECT_BUFFER);
 
-        glBindVertexArray(_instancedAsternoids->getBoundingBoxVao());
+        GLStateCache::bindVertexArray(_instancedAsternoids->getBoundingBoxVao());
 
         glMultiDrawElementsIndirect(
-            GL_LINES, GL_UNSIGNED_INT, 0, static_cast<GLsizei>(_indirectDrawCmds.size()), 0);
+            GL_LINES, GL_UNSIGNED_INT, reinterpret_cast<const void*>(offset),
+            static_cast<GLsizei>(_indirectDrawCmds.size()), 0);
 
-        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        _indirectStream->unbind(GL_DRAW_INDIRECT_BUFFER);
 
-        glBindVertexArray(0);
+        GLStateCache::bindVertexArray(0);
     }
+}
+
+size_t FrustumCulling::streamIndirectCommands(
+    const std::vector<DrawElementsIndirectCommand>& cmds) {
+    const size_t size = cmds.size() * sizeof(DrawElementsIndirectCommand);
+    const StreamAllocation allocation = _indirectStream->allocate(size, 4);
+    if (size > 0) {
+        std::memcpy(allocation.data, cmds.data(), size);
+        _indirectStream->flush();
+    }
+
+    return allocation.offset;
 }
\ No newline at end of file
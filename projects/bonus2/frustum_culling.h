@@ -9,16 +9,9 @@
 #include "../base/instanced_model.h"
 #include "../base/light.h"
 #include "../base/model.h"
+#include "../base/stream_buffer.h"
 #include "../base/texture2d.h"
 
-struct DrawElementsIndirectCommand {
-    unsigned int count;
-    unsigned int instanceCount;
-    unsigned int firstIndex;
-    int baseVertex;
-    unsigned int baseInstance;
-};
-
 enum class Method {
     CPU,
     GPU
@@ -42,6 +35,18 @@ public:
 
 private:
     std::unique_ptr<Model> _planet;
+    size_t _drawPlanetTriangleCount = 0;
+
+    // a dense mesh standing on the planet, most of its clusters are hidden or back facing
+    std::unique_ptr<Model> _lucy;
+    size_t _drawLucyTriangleCount = 0;
+
+    // meshlet culling resources of the planet and lucy, the count and offset arrays of
+    // the fallback without indirect draws are kept between the frames
+    bool _meshletCullingEnabled = false;
+    std::vector<DrawElementsIndirectCommand> _meshletCmds;
+    std::vector<GLsizei> _meshletIndexCounts;
+    std::vector<const void*> _meshletIndexOffsets;
 
     std::unique_ptr<Model> _asternoid;
     std::vector<glm::mat4> _modelMatrices;
@@ -52,6 +57,7 @@ private:
 
     std::unique_ptr<LineMaterial> _lineMaterial;
     std::unique_ptr<LambertMaterial> _planetMaterial;
+    std::unique_ptr<LambertMaterial> _lucyMaterial;
     std::unique_ptr<LambertMaterial> _asternoidMaterial;
 
     std::unique_ptr<GLSLProgram> _lineShader;
@@ -67,6 +73,11 @@ private:
 
     std::vector<int> _visibles;
 
+    // level of detail of the visible asternoids
+    bool _lodEnabled = false;
+    float _lodErrorThreshold = 1.0f;
+    std::vector<int> _lodLevels;
+
     bool _showBoundingBox = false;
 
     enum Method _method = Method::CPU;
@@ -79,7 +90,9 @@ private:
     // indirect draw resources
     bool _indirectDrawEnabled = false;
     std::vector<DrawElementsIndirectCommand> _indirectDrawCmds;
-    GLuint _indirectBuffer = {};
+
+    // the indirect commands of the planet meshlets and the asternoids are streamed per frame
+    std::unique_ptr<StreamBuffer> _indirectStream;
 
     void initModelMatrices();
 
@@ -87,10 +100,20 @@ private:
 
     void initGPUCullingResources();
 
+    // draw the model when it is in the frustum and return the number of triangles drawn
+    size_t renderLambertModel(
+        const Model& model, const LambertMaterial& material, const Frustum& frustum);
+
+    size_t drawMeshlets(const Model& model, const glm::mat4& viewProjection);
+
+    void selectAsternoidLods();
+
     void renderAsternoids();
 
     void renderAsternoidsIndirect();
 
+    size_t streamIndirectCommands(const std::vector<DrawElementsIndirectCommand>& cmds);
+
     void handleInput() override;
 
     void renderFrame() override;
@@ -1,6 +1,8 @@
 #include <cstdlib>
 #include <iostream>
 
+#include "../base/command_line.h"
+
 #include "frustum_culling.h"
 
 Options getOptions(int argc, char* argv[]) {
@@ -19,6 +21,8 @@ Options getOptions(int argc, char* argv[]) {
     options.backgroundColor = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
     options.assetRootDir = "../../media/";
 
+    parseCommonOptions(CommandLine(argc, argv), options);
+
     return options;
 }
 
@@ -1,4 +1,5 @@
 #include <random>
+#include <stdexcept>
 
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
@@ -28,6 +29,19 @@ const std::string quadVsRelPath = "shader/bonus3/quad.vert";
 const std::string quadFsRelPath = "shader/bonus3/quad.frag";
 
 PostProcessing::PostProcessing(const Options& options) : Application(options) {
+    // the passes enabled at startup
+    if (options.renderMode == "ssao") {
+        _enableSSAO = true;
+    } else if (options.renderMode == "bloom") {
+        _enableBloom = true;
+    } else if (options.renderMode == "ssao-bloom") {
+        _enableSSAO = true;
+        _enableBloom = true;
+    } else if (!options.renderMode.empty()) {
+        throw std::runtime_error(
+            "unknown render mode " + options.renderMode + ", expect ssao, bloom or ssao-bloom");
+    }
+
     _bunny.reset(new Model(getAssetFullPath(bunnyRelPath)));
     _bunny->transform.position = glm::vec3(0.0f, 2.5f, 0.0f);
 
@@ -87,7 +101,15 @@ void PostProcessing::handleInput() {
 
 void PostProcessing::renderFrame() {
     renderScene();
-    renderUI();
+
+    {
+        ProfileScope scope(_profiler, "ui");
+        renderUI();
+    }
+}
+
+Profiler* PostProcessing::getProfiler() {
+    return &_profiler;
 }
 
 void PostProcessing::initGeometryPassResources() {
@@ -290,8 +312,9 @@ void PostProcessing::renderScene() {
     glClearColor(_clearColor.r, _clearColor.g, _clearColor.b, _clearColor.a);
 
     // deferred rendering: geometry pass
+    _profiler.beginScope("geometry");
     _gBufferFBO->bind();
-    glEnable(GL_DEPTH_TEST);
+    GLStateCache::enable(GL_DEPTH_TEST);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     _gBufferShader->use();
@@ -305,11 +328,13 @@ void PostProcessing::renderScene() {
     _cube->draw();
 
     _gBufferFBO->unbind();
+    _profiler.endScope();
 
     // deferred rendering: lighting passes
     // + SSAO pass
+    _profiler.beginScope("ssao");
     if (_enableSSAO) {
-        glDisable(GL_DEPTH_TEST);
+        GLStateCache::disable(GL_DEPTH_TEST);
 
         _ssaoFBO->bind();
 
@@ -356,10 +381,12 @@ void PostProcessing::renderScene() {
             ones.data());
         _ssaoResult[0]->unbind();
     }
+    _profiler.endScope();
 
     // + bloom pass
+    _profiler.beginScope("lighting");
     _bloomFBO->bind();
-    glDisable(GL_DEPTH_TEST);
+    GLStateCache::disable(GL_DEPTH_TEST);
     glClear(GL_COLOR_BUFFER_BIT);
 
     _ssaoLightingShader->use();
@@ -382,7 +409,7 @@ void PostProcessing::renderScene() {
 
     _screenQuad->draw();
 
-    glEnable(GL_DEPTH_TEST);
+    GLStateCache::enable(GL_DEPTH_TEST);
     _lightShader->use();
 
     _lightShader->setUniformMat4("projection", _camera->getProjectionMatrix());
@@ -394,18 +421,21 @@ void PostProcessing::renderScene() {
     _sphere->draw();
 
     _bloomFBO->unbind();
+    _profiler.endScope();
 
+    _profiler.beginScope("bloom");
     if (_enableBloom) {
         extractBrightColor(*_bloomMap);
         blurBrightColor();
         combineSceneMapAndBloomBlur(*_bloomMap);
     } else {
-        glDisable(GL_DEPTH_TEST);
+        GLStateCache::disable(GL_DEPTH_TEST);
         _drawScreenShader->use();
         _drawScreenShader->setUniformInt("frame", 0);
         _bloomMap->bind(0);
         _screenQuad->draw();
     }
+    _profiler.endScope();
 }
 
 void PostProcessing::renderUI() {
@@ -425,6 +455,8 @@ void PostProcessing::renderUI() {
         ImGui::End();
     }
 
+    _profiler.renderUI();
+
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
@@ -462,7 +494,7 @@ void PostProcessing::blurBrightColor() {
 }
 
 void PostProcessing::combineSceneMapAndBloomBlur(const Texture2D& sceneMap) {
-    glDisable(GL_DEPTH_TEST);
+    GLStateCache::disable(GL_DEPTH_TEST);
     _blendShader->use();
 
     _blendShader->setUniformInt("scene", 0);
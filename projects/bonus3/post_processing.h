@@ -9,6 +9,7 @@
 #include "../base/glsl_program.h"
 #include "../base/light.h"
 #include "../base/model.h"
+#include "../base/profiler.h"
 #include "../base/texture2d.h"
 
 class PostProcessing : public Application {
@@ -68,10 +69,14 @@ private:
     bool _enableBloom = false;
     bool _enableSSAO = false;
 
+    Profiler _profiler;
+
     void handleInput() override;
 
     void renderFrame() override;
 
+    Profiler* getProfiler() override;
+
     void initGeometryPassResources();
 
     void initSSAOPassResources();
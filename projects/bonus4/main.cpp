@@ -2,6 +2,8 @@
 #include <cstdlib>
 #include <iostream>
 
+#include "../base/command_line.h"
+
 Options getOptions(int argc, char* argv[]) {
     Options options;
     options.windowTitle = "Shadow Mapping";
@@ -13,6 +15,9 @@ Options getOptions(int argc, char* argv[]) {
     options.glVersion = {3, 3};
     options.backgroundColor = glm::vec4(0.8f, 0.8f, 0.8f, 1.0f);
     options.assetRootDir = "../../media/";
+    options.shaderCacheDir = getDefaultShaderCacheDir();
+
+    parseCommonOptions(CommandLine(argc, argv), options);
 
     return options;
 }
@@ -58,6 +58,9 @@ ShadowMapping::ShadowMapping(const Options& options) : Application(options) {
     // init ground
     initGround();
 
+    // pack the scene geometry into one buffer
+    initScenePool();
+
     // init camera
     _camera.reset(new PerspectiveCamera(
         glm::radians(50.0f), 1.0f * _windowWidth / _windowHeight, 0.1f, 500.0f));
@@ -186,15 +189,31 @@ void ShadowMapping::handleInput() {
 void ShadowMapping::renderFrame() {
     showFpsInWindowTitle();
 
-    glEnable(GL_DEPTH_TEST);
+    GLStateCache::enable(GL_DEPTH_TEST);
 
-    renderShadowMaps();
+    {
+        ProfileScope scope(_profiler, "shadow maps");
+        renderShadowMaps();
+    }
 
-    renderScene();
+    {
+        ProfileScope scope(_profiler, "scene");
+        renderScene();
+    }
+
+    {
+        ProfileScope scope(_profiler, "debug view");
+        renderDebugView();
+    }
 
-    renderDebugView();
+    {
+        ProfileScope scope(_profiler, "ui");
+        renderUI();
+    }
+}
 
-    renderUI();
+Profiler* ShadowMapping::getProfiler() {
+    return &_profiler;
 }
 
 void ShadowMapping::initGround() {
@@ -217,6 +236,16 @@ void ShadowMapping::initGround() {
     _groundMaterial->kd = glm::vec3(0.8f);
 }
 
+void ShadowMapping::initScenePool() {
+    const Model& bunny = *_bunnies[0];
+    _scenePool.reset(new GeometryPool(
+        bunny.getVertices().size() + _ground->getVertices().size(),
+        sizeof(uint32_t) * (bunny.getIndices().size() + _ground->getIndices().size())));
+
+    _bunnyRange = _scenePool->add(bunny);
+    _groundRange = _scenePool->add(*_ground);
+}
+
 void ShadowMapping::initShaders() {
     // depth shader for directional light
     _directionalDepthShader.reset(new GLSLProgram);
@@ -374,7 +403,7 @@ void ShadowMapping::renderShadowMaps() {
 }
 
 void ShadowMapping::renderDirectionalLightShadowMap() {
-    glViewport(0, 0, shadowMapResolution, shadowMapResolution);
+    GLStateCache::viewport(0, 0, shadowMapResolution, shadowMapResolution);
 
     _directionalDepthShader->use();
     _directionalDepthShader->setUniformMat4("lightSpaceMatrix", _directionalLightSpaceMatrix);
@@ -385,11 +414,11 @@ void ShadowMapping::renderDirectionalLightShadowMap() {
     renderSceneFromLight(*_directionalDepthShader);
     _depthFbo->unbind();
 
-    glViewport(0, 0, _windowWidth, _windowHeight);
+    GLStateCache::viewport(0, 0, _windowWidth, _windowHeight);
 }
 
 void ShadowMapping::renderPointLightShadowMap() {
-    glViewport(0, 0, shadowMapResolution, shadowMapResolution);
+    GLStateCache::viewport(0, 0, shadowMapResolution, shadowMapResolution);
 
     _omnidirectionalDepthShader->use();
     _omnidirectionalDepthShader->setUniformFloat("zFar", _pointLightZfar);
@@ -408,11 +437,11 @@ void ShadowMapping::renderPointLightShadowMap() {
         _depthCubeFbos[i]->unbind();
     }
 
-    glViewport(0, 0, _windowWidth, _windowHeight);
+    GLStateCache::viewport(0, 0, _windowWidth, _windowHeight);
 }
 
 void ShadowMapping::renderDirectionalLightCascadeShadowMap() {
-    glViewport(0, 0, shadowMapResolution, shadowMapResolution);
+    GLStateCache::viewport(0, 0, shadowMapResolution, shadowMapResolution);
 
     _directionalDepthShader->use();
 
@@ -429,27 +458,31 @@ void ShadowMapping::renderDirectionalLightCascadeShadowMap() {
         _depthCascadeFbos[i]->unbind();
     }
 
-    glViewport(0, 0, _windowWidth, _windowHeight);
+    GLStateCache::viewport(0, 0, _windowWidth, _windowHeight);
 }
 
 void ShadowMapping::renderSceneFromLight(const GLSLProgram& shader) {
+    _scenePool->bind();
+
     // 1. draw bunnies
     for (size_t i = 0; i < _bunnies.size(); ++i) {
         shader.setUniformMat4("model", _bunnies[i]->transform.getLocalMatrix());
-        _bunnies[i]->draw();
+        _scenePool->draw(_bunnyRange);
     }
 
     // 2. draw ground
     shader.setUniformMat4("model", _ground->transform.getLocalMatrix());
-    _ground->draw();
+    _scenePool->draw(_groundRange);
+
+    _scenePool->unbind();
 }
 
 void ShadowMapping::renderScene() {
     glClearColor(_clearColor.r, _clearColor.g, _clearColor.b, _clearColor.a);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    glViewport(0, 0, _windowWidth, _windowHeight);
-    glCullFace(GL_BACK);
+    GLStateCache::viewport(0, 0, _windowWidth, _windowHeight);
+    GLStateCache::cullFace(GL_BACK);
 
     _lambertShader->use();
 
@@ -512,12 +545,14 @@ void ShadowMapping::renderScene() {
     _lambertShader->setUniformInt("depthCubeTexture", 1);
     _depthCubeTexture->bind(1);
 
+    _scenePool->bind();
+
     // 1. draw bunnies
     _lambertShader->setUniformVec3("material.ka", _bunnyMaterial->ka);
     _lambertShader->setUniformVec3("material.kd", _bunnyMaterial->kd);
     for (size_t i = 0; i < _bunnies.size(); ++i) {
         _lambertShader->setUniformMat4("model", _bunnies[i]->transform.getLocalMatrix());
-        _bunnies[i]->draw();
+        _scenePool->draw(_bunnyRange);
     }
 
     // 2. draw ground
@@ -525,7 +560,9 @@ void ShadowMapping::renderScene() {
     _lambertShader->setUniformVec3("material.ka", _groundMaterial->ka);
     _lambertShader->setUniformVec3("material.kd", _groundMaterial->kd);
 
-    _ground->draw();
+    _scenePool->draw(_groundRange);
+
+    _scenePool->unbind();
 
     // 3. draw lights
     _lightShader->use();
@@ -619,6 +656,8 @@ void ShadowMapping::renderUI() {
         ImGui::End();
     }
 
+    _profiler.renderUI();
+
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
@@ -662,35 +701,23 @@ void ShadowMapping::updatePointLightSpaceMatrices() {
 }
 
 BoundingBox ShadowMapping::getSceneBoundingBox() const {
-    auto getModelBoundingBox = [](const Model& model) {
-        BoundingBox result;
-
-        BoundingBox box = model.getBoundingBox();
-        const glm::mat3 modelMatrix = model.transform.getLocalMatrix();
-
-        glm::vec3 point;
-        for (size_t i = 0; i < 2; ++i) {
-            point.x = i ? box.max.x : box.min.x;
-            for (int j = 0; j < 2; ++j) {
-                point.y = j ? box.max.y : box.min.y;
-                for (int k = 0; k < 2; ++k) {
-                    point.z = k ? box.max.z : box.min.z;
-                    // change the point from model space to world space
-                    point = modelMatrix * point;
-                    result.min = glm::min(point, result.min);
-                    result.max = glm::max(point, result.max);
-                }
-            }
-        }
+    // transform the model space boxes to the world space in one batch
+    std::vector<BoundingBox> boxes;
+    std::vector<glm::mat4> modelMatrices;
+    for (size_t i = 0; i < _bunnies.size(); ++i) {
+        boxes.push_back(_bunnies[i]->getBoundingBox());
+        modelMatrices.push_back(_bunnies[i]->transform.getLocalMatrix());
+    }
+    boxes.push_back(_ground->getBoundingBox());
+    modelMatrices.push_back(_ground->transform.getLocalMatrix());
 
-        return result;
-    };
+    std::vector<BoundingBox> worldBoxes(boxes.size());
+    transformBounds(boxes.data(), modelMatrices.data(), boxes.size(), worldBoxes.data());
 
     BoundingBox result;
-    for (size_t i = 0; i < _bunnies.size(); ++i) {
-        result += getModelBoundingBox(*_bunnies[i]);
+    for (const auto& box : worldBoxes) {
+        result += box;
     }
-    result += getModelBoundingBox(*_ground);
 
     return result;
 }
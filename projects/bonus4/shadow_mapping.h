@@ -9,9 +9,12 @@
 #include "../base/camera.h"
 #include "../base/framebuffer.h"
 #include "../base/fullscreen_quad.h"
+#include "../base/geometry_pool.h"
 #include "../base/glsl_program.h"
 #include "../base/light.h"
 #include "../base/model.h"
+#include "../base/profiler.h"
+#include "../base/simd_bounds.h"
 #include "../base/texture2d.h"
 #include "../base/texture_cubemap.h"
 
@@ -48,6 +51,11 @@ private:
     std::unique_ptr<Model> _ground;
     std::unique_ptr<LambertMaterial> _groundMaterial;
 
+    // the bunny mesh is shared by all the bunnies, so it is stored only once in the pool
+    std::unique_ptr<GeometryPool> _scenePool;
+    GeometryPool::Range _bunnyRange;
+    GeometryPool::Range _groundRange;
+
     std::unique_ptr<GLSLProgram> _lambertShader;
 
     std::unique_ptr<AmbientLight> _ambientLight;
@@ -81,6 +89,8 @@ private:
 
     DebugView _debugView = DebugView::None;
 
+    Profiler _profiler;
+
     std::unique_ptr<FullscreenQuad> _quad;
     std::unique_ptr<GLSLProgram> _quadShader;
     std::unique_ptr<GLSLProgram> _quadCascadeShader;
@@ -95,8 +105,12 @@ private:
 
     void renderFrame() override;
 
+    Profiler* getProfiler() override;
+
     void initGround();
 
+    void initScenePool();
+
     void initShaders();
 
     void initDepthResources();
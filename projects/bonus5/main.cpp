@@ -1,6 +1,8 @@
 #include <cstdlib>
 #include <iostream>
 
+#include "../base/command_line.h"
+
 #include "raytracing.h"
 
 Options getOptions(int argc, char* argv[]) {
@@ -16,6 +18,8 @@ Options getOptions(int argc, char* argv[]) {
     options.backgroundColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
     options.assetRootDir = "../../media/";
 
+    parseCommonOptions(CommandLine(argc, argv), options);
+
     return options;
 }
 
@@ -15,6 +15,9 @@
 
 static constexpr int BufferWidth = 2048;
 
+// time spent on creating the opengl resources of loaded assets per frame
+static constexpr double assetUploadBudgetMs = 4.0;
+
 const std::string lucyRelPath = "obj/lucy.obj";
 
 const std::string quadVsRelPath = "shader/bonus5/quad.vert";
@@ -29,7 +32,8 @@ const std::vector<std::string> skyboxTextureRelPaths = {
 };
 
 RayTracing::RayTracing(const Options& options) : Application(options) {
-    _lucy.reset(new Model(getAssetFullPath(lucyRelPath)));
+    _assetLoader.reset(new AssetLoader(getJobSystem()));
+    _lucy = Model::loadAsync(*_assetLoader, getAssetFullPath(lucyRelPath));
 
     std::vector<std::string> skyBoxTexturePaths;
     for (size_t i = 0; i < skyboxTextureRelPaths.size(); ++i) {
@@ -112,8 +116,13 @@ void RayTracing::handleInput() {
         return;
     }
 
+    if (_lucy.failed()) {
+        throw std::runtime_error(_lucy.getError());
+    }
+
     static int lastSceneIndex = _renderSceneIndex;
-    if (lastSceneIndex != _renderSceneIndex) {
+    const bool lucyArrived = _renderSceneIndex == 2 && !_lucyInScene && _lucy.ready();
+    if (lastSceneIndex != _renderSceneIndex || lucyArrived) {
         createRenderScene(_renderSceneIndex);
         lastSceneIndex = _renderSceneIndex;
         _sampleCount = 0;
@@ -123,7 +132,9 @@ void RayTracing::handleInput() {
 void RayTracing::renderFrame() {
     showFpsInWindowTitle();
 
-    glDisable(GL_DEPTH_TEST);
+    _assetLoader->processUploads(assetUploadBudgetMs);
+
+    GLStateCache::disable(GL_DEPTH_TEST);
 
     glm::mat4 cameraToWorld = glm::inverse(_camera->getViewMatrix());
     glm::mat4 cameraToScreen = _camera->getProjectionMatrix();
@@ -200,6 +211,9 @@ void RayTracing::renderFrame() {
         static const char* scenes[] = {"scene 1", "scene 2", "scene 3"};
 
         ImGui::Combo("##1", &_renderSceneIndex, scenes, IM_ARRAYSIZE(scenes));
+        if (_renderSceneIndex == 2 && !_lucy.ready()) {
+            ImGui::Text("loading lucy ...");
+        }
 
         ImGui::NewLine();
 
@@ -566,6 +580,12 @@ void RayTracing::createScene3() {
 
     _useBVH = true;
 
+    _lucyInScene = _lucy.ready();
+    if (!_lucyInScene) {
+        createPrimitiveBuffer(_balls, {}, {}, _ballMaterials, {});
+        return;
+    }
+
     std::vector<glm::mat4> transformations = {
         rotateT * scaleT,
         glm::translate(glm::mat4(1.0f), glm::vec3(-4.0f, 0.0f, 2.0f)) * rotateT * scaleT,
@@ -4,10 +4,12 @@
 #include <vector>
 
 #include "../base/application.h"
+#include "../base/asset_loader.h"
 #include "../base/camera.h"
 #include "../base/framebuffer.h"
 #include "../base/fullscreen_quad.h"
 #include "../base/glsl_program.h"
+#include "../base/job_system.h"
 #include "../base/model.h"
 #include "../base/skybox.h"
 #include "../base/texture2d.h"
@@ -22,7 +24,13 @@ public:
     ~RayTracing();
 
 private:
-    std::unique_ptr<Model> _lucy;
+    // runs on the jobs of the application
+    std::unique_ptr<AssetLoader> _assetLoader;
+
+    AssetHandle<Model> _lucy;
+
+    // scene 3 shows only the balls until lucy is loaded
+    bool _lucyInScene = false;
 
     std::vector<Sphere> _balls;
     std::vector<Material> _ballMaterials;
@@ -7,7 +7,7 @@ HelloTriangle::HelloTriangle(const Options& options) : Application(options) {
     // create a vertex buffer object
     glGenBuffers(1, &_vbo);
 
-    glBindVertexArray(_vao);
+    GLStateCache::bindVertexArray(_vao);
     glBindBuffer(GL_ARRAY_BUFFER, _vbo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(_vertices), _vertices, GL_STATIC_DRAW);
 
@@ -19,7 +19,7 @@ HelloTriangle::HelloTriangle(const Options& options) : Application(options) {
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
     glEnableVertexAttribArray(1);
 
-    glBindVertexArray(0);
+    GLStateCache::bindVertexArray(0);
 
     // create shader
     const char* vsCode =
@@ -54,7 +54,7 @@ HelloTriangle::~HelloTriangle() {
     }
 
     if (_vao != 0) {
-        glDeleteVertexArrays(1, &_vao);
+        GLStateCache::deleteVertexArrays(1, &_vao);
         _vao = 0;
     }
 }
@@ -73,6 +73,6 @@ void HelloTriangle::renderFrame() {
     glClear(GL_COLOR_BUFFER_BIT);
 
     _shader->use();
-    glBindVertexArray(_vao);
+    GLStateCache::bindVertexArray(_vao);
     glDrawArrays(GL_TRIANGLES, 0, 3);
 }
\ No newline at end of file
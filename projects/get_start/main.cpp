@@ -1,6 +1,8 @@
 #include "hello_triangle.h"
 #include <iostream>
 
+#include "../base/command_line.h"
+
 Options getOptions(int argc, char* argv[]) {
     Options options;
     options.windowTitle = "Hello Triangle";
@@ -11,6 +13,8 @@ Options getOptions(int argc, char* argv[]) {
     options.glVersion = {3, 3};
     options.backgroundColor = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
 
+    parseCommonOptions(CommandLine(argc, argv), options);
+
     return options;
 }
 
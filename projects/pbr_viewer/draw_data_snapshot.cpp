@@ -0,0 +1,37 @@
+#include "draw_data_snapshot.h"
+
+DrawDataSnapshot::~DrawDataSnapshot() {
+    for (ImDrawList* drawList : _drawLists) {
+        IM_DELETE(drawList);
+    }
+}
+
+void DrawDataSnapshot::capture(const ImDrawData* drawData) {
+    if (drawData == nullptr || !drawData->Valid) {
+        _drawData.Clear();
+        _captured = false;
+        return;
+    }
+
+    for (int i = static_cast<int>(_drawLists.size()); i < drawData->CmdListsCount; ++i) {
+        _drawLists.push_back(IM_NEW(ImDrawList)(drawData->CmdLists[i]->_Data));
+    }
+
+    // the same copy as ImDrawList::CloneOutput, into the buffers of the previous frames
+    for (int i = 0; i < drawData->CmdListsCount; ++i) {
+        const ImDrawList* src = drawData->CmdLists[i];
+        ImDrawList* dst = _drawLists[i];
+        dst->CmdBuffer = src->CmdBuffer;
+        dst->IdxBuffer = src->IdxBuffer;
+        dst->VtxBuffer = src->VtxBuffer;
+        dst->Flags = src->Flags;
+    }
+
+    _drawData = *drawData;
+    _drawData.CmdLists = _drawLists.data();
+    _captured = true;
+}
+
+ImDrawData* DrawDataSnapshot::get() {
+    return _captured ? &_drawData : nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+
+#include <imgui.h>
+
+// copy of the draw lists of an imgui frame, so that the frame can be rendered on another
+// thread while the next one is built. the lists are kept across frames to reuse their memory
+class DrawDataSnapshot {
+public:
+    DrawDataSnapshot() = default;
+
+    DrawDataSnapshot(const DrawDataSnapshot&) = delete;
+
+    DrawDataSnapshot& operator=(const DrawDataSnapshot&) = delete;
+
+    ~DrawDataSnapshot();
+
+    // copy the draw data of the last ImGui::Render()
+    void capture(const ImDrawData* drawData);
+
+    // the copy to pass to the renderer backend, nullptr before the first capture
+    ImDrawData* get();
+
+private:
+    std::vector<ImDrawList*> _drawLists;
+    ImDrawData _drawData;
+    bool _captured = false;
+};
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include <cstdlib>
 #include <iostream>
 
+#include "../base/command_line.h"
+
 #include "pbr_viewer.h"
 
 Options getOptions(int argc, char* argv[]) {
@@ -14,6 +16,9 @@ Options getOptions(int argc, char* argv[]) {
     options.glVersion = {3, 3};
     options.backgroundColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
     options.assetRootDir = "../../media/";
+    options.shaderCacheDir = getDefaultShaderCacheDir();
+
+    parseCommonOptions(CommandLine(argc, argv), options);
 
     return options;
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <memory>
 
@@ -21,6 +22,8 @@ struct Material {
 
 struct PbrMaterial : public Material {
     std::string name;
+    // position in the materials of the model
+    uint32_t index = 0;
 
     float roughnessFactor = 1.0f;
     float metallicFactor = 1.0f;
@@ -50,4 +53,23 @@ struct PbrMaterial : public Material {
         int occlusion = -1;
         int emissive = -1;
     } texCoordSets;
-};
\ No newline at end of file
+};
+
+// std140 layout of an element of the material table of pbr.frag
+struct PbrMaterialBlock {
+    glm::vec4 albedoFactor;
+    glm::vec4 emissiveFactor;
+    float metallicFactor;
+    float roughnessFactor;
+    float occlusionStrength;
+    int32_t albedoTexCoordSet;
+    int32_t metallicTexCoordSet;
+    int32_t roughnessTexCoordSet;
+    int32_t normalTexCoordSet;
+    int32_t emissiveTexCoordSet;
+    int32_t occlusionTexCoordSet;
+    float alphaMaskCutoff;
+    float padding[2];
+};
+
+static_assert(sizeof(PbrMaterialBlock) == 80, "the material block must match std140");
\ No newline at end of file
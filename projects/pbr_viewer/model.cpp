@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <limits>
 #include <stdexcept>
@@ -13,6 +14,10 @@ Model::Model(const std::string& filepath) {
     load(filepath);
 }
 
+Model::Model(const tinygltf::Model& gltfModel) {
+    load(gltfModel);
+}
+
 Model::~Model() {
     cleanup();
 }
@@ -26,8 +31,17 @@ std::vector<Node*> Model::getRootNodes() {
     return _rootNodes;
 }
 
-void Model::load(const std::string& filepath) {
-    tinygltf::Model gltfModel;
+const std::vector<Meshlet>& Model::getMeshlets() const {
+    return _meshlets;
+}
+
+void Model::bindMaterialBlock(uint32_t bindingPoint, uint32_t block) const {
+    glBindBufferRange(
+        GL_UNIFORM_BUFFER, bindingPoint, _materialUbo, block * _materialBlockStride,
+        materialsPerBlock * sizeof(PbrMaterialBlock));
+}
+
+void Model::parse(const std::string& filepath, tinygltf::Model& gltfModel) {
     tinygltf::TinyGLTF gltfContext;
 
     size_t index = filepath.find_last_of('.');
@@ -58,7 +72,15 @@ void Model::load(const std::string& filepath) {
     } else {
         std::cout << "load " << filepath << " success" << std::endl;
     }
+}
+
+void Model::load(const std::string& filepath) {
+    tinygltf::Model gltfModel;
+    parse(filepath, gltfModel);
+    load(gltfModel);
+}
 
+void Model::load(const tinygltf::Model& gltfModel) {
     /* load the default scene if it exists, or scene index 0 */
     const int sceneIndex = gltfModel.defaultScene > -1 ? gltfModel.defaultScene : 0;
     const tinygltf::Scene& scene = gltfModel.scenes[sceneIndex];
@@ -79,6 +101,10 @@ void Model::load(const std::string& filepath) {
     _vertices.reserve(vertexCount);
     _indices.reserve(indexCount);
 
+    // the indices are absolute in the shared vertex buffer, so the total vertex count
+    // decides whether 16-bit indices are enough for the whole model
+    _indexType = getIndexType(vertexCount);
+
     createGraphicResources(vertexCount, indexCount);
 
     loadSamplers(gltfModel);
@@ -88,6 +114,7 @@ void Model::load(const std::string& filepath) {
 
     loadMaterials(gltfModel);
     printMaterials();
+    createMaterialBuffer();
 
     for (size_t i = 0; i < scene.nodes.size(); ++i) {
         loadNode(nullptr, gltfModel.nodes[scene.nodes[i]], scene.nodes[i], gltfModel);
@@ -307,6 +334,7 @@ void Model::loadMaterials(const tinygltf::Model& gltfModel) {
             }
         }
 
+        material->index = static_cast<uint32_t>(_materials.size());
         _materials.push_back(std::move(material));
     }
 }
@@ -465,12 +493,21 @@ void Model::loadNode(
                 }
             }
 
+            const uint32_t firstMeshlet = static_cast<uint32_t>(_meshlets.size());
+            const uint32_t meshletCount =
+                indexCount > 0
+                    ? buildMeshlets(vertexStart, static_cast<uint32_t>(vertexCount), indexStart)
+                    : 0;
+
             Primitive primitive = {
                 _vao,
                 vertexStart,
                 static_cast<uint32_t>(vertexCount),
                 indexStart,
                 static_cast<uint32_t>(indexCount),
+                _indexType,
+                firstMeshlet,
+                meshletCount,
                 gltfPrimitive.material >= 0 ? _materials[gltfPrimitive.material + 1].get()
                                             : _materials[0].get()};
             node->primitives.push_back(primitive);
@@ -491,6 +528,31 @@ void Model::loadNode(
     _nodes.push_back(std::move(node));
 }
 
+uint32_t Model::buildMeshlets(uint32_t vertexStart, uint32_t vertexCount, uint32_t indexStart) {
+    // the meshlets are built on the indices local to the primitive
+    std::vector<glm::vec3> positions(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; ++i) {
+        positions[i] = _vertices[vertexStart + i].position;
+    }
+
+    std::vector<uint32_t> indices(_indices.begin() + indexStart, _indices.end());
+    for (auto& index : indices) {
+        index -= vertexStart;
+    }
+
+    std::vector<Meshlet> meshlets = ::buildMeshlets(positions, indices);
+    for (size_t i = 0; i < indices.size(); ++i) {
+        _indices[indexStart + i] = indices[i] + vertexStart;
+    }
+
+    for (auto& meshlet : meshlets) {
+        meshlet.firstIndex += indexStart;
+        _meshlets.push_back(meshlet);
+    }
+
+    return static_cast<uint32_t>(meshlets.size());
+}
+
 void Model::createGraphicResources(size_t vertexCount, size_t indexCount) {
     // create a vertex array object
     glGenVertexArrays(1, &_vao);
@@ -499,13 +561,15 @@ void Model::createGraphicResources(size_t vertexCount, size_t indexCount) {
     // create a element array buffer
     glGenBuffers(1, &_ibo);
 
-    glBindVertexArray(_vao);
+    GLStateCache::bindVertexArray(_vao);
     glBindBuffer(GL_ARRAY_BUFFER, _vbo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * vertexCount, NULL, GL_STATIC_DRAW);
 
     if (indexCount > 0) {
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(uint32_t), NULL, GL_STATIC_DRAW);
+        glBufferData(
+            GL_ELEMENT_ARRAY_BUFFER, indexCount * getIndexTypeSize(_indexType), NULL,
+            GL_STATIC_DRAW);
     }
 
     // specify layout, size of a vertex, data type, normalize, sizeof vertex array, offset of the
@@ -523,18 +587,19 @@ void Model::createGraphicResources(size_t vertexCount, size_t indexCount) {
         3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord1));
     glEnableVertexAttribArray(3);
 
-    glBindVertexArray(0);
+    GLStateCache::bindVertexArray(0);
 }
 
 void Model::updateGraphicResources() {
-    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Vertex) * _vertices.size(), _vertices.data());
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo);
+    // a draw may have left any vao bound, the copy target keeps its element buffer intact
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _vbo);
     glBufferSubData(
-        GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(uint32_t) * _indices.size(), _indices.data());
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        GL_COPY_WRITE_BUFFER, 0, sizeof(Vertex) * _vertices.size(), _vertices.data());
+
+    const std::vector<uint8_t> indexData = packIndices(_indices, _indexType);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _ibo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, 0, indexData.size(), indexData.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
 }
 
 void Model::cleanup() {
@@ -547,9 +612,10 @@ void Model::cleanup() {
 
     _vertices.clear();
     _indices.clear();
+    _meshlets.clear();
 
     if (_vao != 0) {
-        glDeleteVertexArrays(1, &_vao);
+        GLStateCache::deleteVertexArrays(1, &_vao);
         _vao = 0;
     }
 
@@ -562,6 +628,11 @@ void Model::cleanup() {
         glDeleteBuffers(1, &_ibo);
         _ibo = 0;
     }
+
+    if (_materialUbo != 0) {
+        glDeleteBuffers(1, &_materialUbo);
+        _materialUbo = 0;
+    }
 }
 
 std::pair<size_t, size_t> Model::getNodeProps(
@@ -622,6 +693,43 @@ Node* Model::getNodeByIndex(int index) const {
     return nullptr;
 }
 
+void Model::createMaterialBuffer() {
+    // the blocks start at the offsets the uniform buffer bindings accept
+    GLint offsetAlignment = 1;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+    const size_t alignment = static_cast<size_t>(std::max(offsetAlignment, 1));
+    const size_t blockSize = materialsPerBlock * sizeof(PbrMaterialBlock);
+    _materialBlockStride = (blockSize + alignment - 1) / alignment * alignment;
+
+    const size_t blockCount = (_materials.size() + materialsPerBlock - 1) / materialsPerBlock;
+    // the last block is bound in full as well
+    std::vector<unsigned char> data((blockCount - 1) * _materialBlockStride + blockSize, 0);
+    for (const auto& material : _materials) {
+        PbrMaterialBlock block = {};
+        block.albedoFactor = material->albedoFactor;
+        block.emissiveFactor = material->emissiveFactor;
+        block.metallicFactor = material->metallicFactor;
+        block.roughnessFactor = material->roughnessFactor;
+        block.occlusionStrength = material->occlusionStrength;
+        block.albedoTexCoordSet = material->texCoordSets.albedo;
+        block.metallicTexCoordSet = material->texCoordSets.metallic;
+        block.roughnessTexCoordSet = material->texCoordSets.roughness;
+        block.normalTexCoordSet = material->texCoordSets.normal;
+        block.emissiveTexCoordSet = material->texCoordSets.emissive;
+        block.occlusionTexCoordSet = material->texCoordSets.occlusion;
+        block.alphaMaskCutoff = material->alphaCutoff;
+
+        const size_t offset = material->index / materialsPerBlock * _materialBlockStride
+                              + material->index % materialsPerBlock * sizeof(PbrMaterialBlock);
+        std::memcpy(data.data() + offset, &block, sizeof(block));
+    }
+
+    glGenBuffers(1, &_materialUbo);
+    glBindBuffer(GL_UNIFORM_BUFFER, _materialUbo);
+    glBufferData(GL_UNIFORM_BUFFER, data.size(), data.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
 int Model::getSamplerIndex(const Sampler* sampler) const {
     for (size_t i = 0; i < _samplers.size(); ++i) {
         if (sampler == _samplers[i].get()) {
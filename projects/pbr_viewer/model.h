@@ -6,8 +6,10 @@
 
 #include <tiny_gltf.h>
 
+#include "../base/asset_loader.h"
 #include "../base/gl_utility.h"
 #include "../base/glsl_program.h"
+#include "../base/meshlet.h"
 #include "../base/sampler.h"
 #include "../base/texture2d.h"
 
@@ -20,10 +22,41 @@ struct Model {
 public:
     Model(const std::string& filepath);
 
+    // create the opengl resources of a parsed gltf model
+    Model(const tinygltf::Model& gltfModel);
+
     ~Model();
 
+    // read a gltf or glb file with its buffers and images, it does not touch opengl
+    // and can run on any thread
+    static void parse(const std::string& filepath, tinygltf::Model& gltfModel);
+
+    // parse the file on a loader thread, the opengl resources are created
+    // when the loader processes the uploads
+    static AssetHandle<Model> loadAsync(AssetLoader& loader, const std::string& filepath) {
+        return loader.load<Model>(
+            [filepath]() {
+                tinygltf::Model gltfModel;
+                parse(filepath, gltfModel);
+                return gltfModel;
+            },
+            [](const tinygltf::Model& gltfModel) {
+                return std::unique_ptr<Model>(new Model(gltfModel));
+            });
+    }
+
     std::vector<Node*> getRootNodes();
 
+    // the size of the material table in pbr.frag, a larger model has its table split into
+    // blocks of this many materials
+    static constexpr uint32_t materialsPerBlock = 128;
+
+    // bind the block of the material table to the uniform block binding point
+    void bindMaterialBlock(uint32_t bindingPoint, uint32_t block) const;
+
+    // the meshlets of all the primitives, their bounds are in the space of their node
+    const std::vector<Meshlet>& getMeshlets() const;
+
     void reload(const std::string& filepath);
 
 private:
@@ -36,19 +69,29 @@ private:
 
     std::vector<Vertex> _vertices;
     std::vector<uint32_t> _indices;
+    std::vector<Meshlet> _meshlets;
 
     GLuint _vao = 0;
     GLuint _vbo = 0;
     GLuint _ibo = 0;
+    GLenum _indexType = GL_UNSIGNED_INT;
+
+    // the parameters of all the materials, uploaded once after they are loaded
+    GLuint _materialUbo = 0;
+    size_t _materialBlockStride = 0;
 
     void load(const std::string& filepath);
 
+    void load(const tinygltf::Model& gltfModel);
+
     void loadSamplers(const tinygltf::Model& gltfModel);
 
     void loadTextures(const tinygltf::Model& gltfModel);
 
     void loadMaterials(const tinygltf::Model& gltfModel);
 
+    void createMaterialBuffer();
+
     void loadAnimations(const tinygltf::Model& gltfModel);
 
     void loadSkins(const tinygltf::Model& gltfModel);
@@ -56,6 +99,10 @@ private:
     void loadNode(
         Node* parent, const tinygltf::Node& node, uint32_t nodeIndex, const tinygltf::Model& model);
 
+    // split the triangles of the primitive into meshlets, which reorders its indices,
+    // and return the number of meshlets appended
+    uint32_t buildMeshlets(uint32_t vertexStart, uint32_t vertexCount, uint32_t indexStart);
+
     void cleanup();
 
     std::pair<size_t, size_t> getNodeProps(
@@ -6,6 +6,9 @@
 #define MAX_POINT_LIGHTS 8
 #define MAX_SPOT_LIGHTS 8
 
+// Model::materialsPerBlock
+#define MAX_MATERIALS 128
+
 #define DEBUG_NONE      0
 #define DEBUG_ALBEDO    1
 #define DEBUG_ROUGHNESS 2
@@ -48,11 +51,7 @@ struct SpotLight {
     float angle;
 };
 
-layout(std140) uniform uboCamera {
-    mat4 projection;
-    mat4 view;
-    vec3 viewPosition;
-};
+#include "ubo_camera.glsl"
 
 layout(std140) uniform uboLights {
     DirectionalLight directionalLights[MAX_DIRECTIONAL_LIGHTS];
@@ -84,14 +83,23 @@ struct Material {
     int emissiveTexCoordSet;
     int occlusionTexCoordSet;
 
-    bool doubleSided;
-
-    bool alphaMask;
     float alphaMaskCutoff;
 };
 
+// the material table of the model, indexed by the material of the draw
+layout(std140) uniform uboMaterials {
+    Material materials[MAX_MATERIALS];
+};
+#ifdef INSTANCED
+flat in int fMaterialIndex;
+#else
+uniform int materialIndex;
+#endif
+
+// copied from the table at the start of main
+Material material;
+
 // material related textures
-uniform Material material;
 uniform sampler2D albedoMap;
 uniform sampler2D normalMap;
 uniform sampler2D metallicMap;
@@ -104,8 +112,9 @@ uniform samplerCube irradianceMap;
 uniform samplerCube prefilterMap;
 uniform sampler2D brdfLutMap;
 
-// for debug usage
+#ifdef DEBUG_VIEW
 uniform int debugInput;
+#endif
 
 struct PBRInfo {
     float NdotL;
@@ -229,16 +238,23 @@ vec3 getIBLTerm(PBRInfo info, vec3 N, vec3 R) {
 }
 
 void main() {
+#ifdef INSTANCED
+    material = materials[fMaterialIndex];
+#else
+    material = materials[materialIndex];
+#endif
+
     // albedo
     vec4 albedo = material.albedoFactor;
     if (material.albedoTexCoordSet >= 0) {
         albedo *= sRGBToLinear(texture(albedoMap, getTexCoord(material.albedoTexCoordSet)));
     }
 
-    // alpha mask
-    if (material.alphaMask == true && albedo.a < material.alphaMaskCutoff) {
+#ifdef ALPHA_MASK
+    if (albedo.a < material.alphaMaskCutoff) {
         discard;
     }
+#endif
 
     // roughness: sample texture in g channel
     float perceptualRoughness = material.roughnessFactor;
@@ -263,9 +279,11 @@ void main() {
     vec3 reflectance90 = vec3(clamp(reflectance * 25.0f, 0.0f, 1.0f));
 
     vec3 N = material.normalTexCoordSet >= 0 ? getNormal() : normalize(fNormal);
-    if (material.doubleSided && gl_FrontFacing == false) {
+#ifdef DOUBLE_SIDED
+    if (gl_FrontFacing == false) {
         N = -N;
     }
+#endif
 
     vec3 V = normalize(viewPosition - fWorldPos);
     float NdotV = clamp(abs(dot(N, V)), 0.001f, 1.0f);
@@ -360,6 +378,7 @@ void main() {
     accumColor = pow(accumColor, vec3(1.0f / 2.2f));
     outColor = vec4(accumColor, albedo.a);
 
+#ifdef DEBUG_VIEW
     switch (debugInput) {
         case DEBUG_ALBEDO:
             outColor = material.albedoFactor;
@@ -405,5 +424,6 @@ void main() {
         default:
             break;
     }
+#endif
 
 }
\ No newline at end of file
@@ -5,20 +5,29 @@ layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aTexCoord0;
 layout(location = 3) in vec2 aTexCoord1;
 
-layout(std140) uniform uboCamera {
-    mat4 projection;
-    mat4 view;
-    vec3 viewPosition;
-};
+#include "ubo_camera.glsl"
 
 out vec3 fWorldPos;
 out vec3 fNormal;
 out vec2 fTexCoord0;
 out vec2 fTexCoord1;
 
+#ifdef INSTANCED
+// streamed per object by the batched draws, see PbrViewer::bindInstanceAttributes
+layout(location = 4) in mat4 aModel;
+layout(location = 8) in int aMaterialIndex;
+
+flat out int fMaterialIndex;
+#else
 uniform mat4 model;
+#endif
 
 void main() {
+#ifdef INSTANCED
+    mat4 model = aModel;
+    fMaterialIndex = aMaterialIndex;
+#endif
+
     fWorldPos = vec3(model * vec4(aPosition, 1.0f));
     fNormal = mat3(transpose(inverse(model))) * aNormal;
     fTexCoord0 = aTexCoord0;
@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
@@ -32,8 +36,85 @@ const std::string quadFragShaderRelPath = "shader/pbr_viewer/quad.frag";
 
 const std::string skyboxTextureRelPaths = "texture/hdr/newport_loft.hdr";
 
+// time spent on creating the opengl resources of loaded assets per frame
+static constexpr double assetUploadBudgetMs = 4.0;
+
+// uniform block binding point of the material table of the model
+static constexpr uint32_t materialBindingPoint = 3;
+
+// the first of the instance attributes of pbr.vert, the model matrix takes four locations
+static constexpr GLuint instanceAttributeLocation = 4;
+
+// the texture and the sampler bindPbrMaterial binds to a texture unit, the sampler
+// is left alone when the texture is
+static bool isSameTextureBinding(
+    const Texture* lhsMap, const Sampler* lhsSampler, int lhsTexCoordSet, const Texture* rhsMap,
+    const Sampler* rhsSampler, int rhsTexCoordSet) {
+    const Texture* lhsBound = lhsTexCoordSet >= 0 ? lhsMap : nullptr;
+    const Texture* rhsBound = rhsTexCoordSet >= 0 ? rhsMap : nullptr;
+    return lhsBound == rhsBound && (lhsBound == nullptr || lhsSampler == rhsSampler);
+}
+
+// whether the materials only differ in the parameters read from the material table,
+// i.e. they share the shader features, the culling, the table block and the textures
+static bool isSameMaterialState(const PbrMaterial& lhs, const PbrMaterial& rhs) {
+    if (&lhs == &rhs) {
+        return true;
+    }
+
+    const auto& lhsSets = lhs.texCoordSets;
+    const auto& rhsSets = rhs.texCoordSets;
+    return (lhs.alphaMode == Material::AlphaMode::Opaque)
+               == (rhs.alphaMode == Material::AlphaMode::Opaque)
+           && lhs.doubleSided == rhs.doubleSided
+           && lhs.index / Model::materialsPerBlock == rhs.index / Model::materialsPerBlock
+           && isSameTextureBinding(
+               lhs.albedoMap, lhs.albeodoSampler, lhsSets.albedo, rhs.albedoMap,
+               rhs.albeodoSampler, rhsSets.albedo)
+           && isSameTextureBinding(
+               lhs.roughnessMap, lhs.roughnessSampler, lhsSets.roughness, rhs.roughnessMap,
+               rhs.roughnessSampler, rhsSets.roughness)
+           && isSameTextureBinding(
+               lhs.metallicMap, lhs.metallicSampler, lhsSets.metallic, rhs.metallicMap,
+               rhs.metallicSampler, rhsSets.metallic)
+           && isSameTextureBinding(
+               lhs.normalMap, lhs.normalSampler, lhsSets.normal, rhs.normalMap,
+               rhs.normalSampler, rhsSets.normal)
+           && isSameTextureBinding(
+               lhs.occlusionMap, lhs.occlusionSampler, lhsSets.occlusion, rhs.occlusionMap,
+               rhs.occlusionSampler, rhsSets.occlusion)
+           && isSameTextureBinding(
+               lhs.emissiveMap, lhs.emissiveSampler, lhsSets.emissive, rhs.emissiveMap,
+               rhs.emissiveSampler, rhsSets.emissive);
+}
+
+// whether the primitives can be drawn by one multi draw indirect call, the instances
+// pick their material parameters from the table
+static bool isSameBatch(const Primitive& lhs, const Primitive& rhs) {
+    return lhs.indexCount > 0 && rhs.indexCount > 0 && lhs.vertexArray == rhs.vertexArray
+           && lhs.indexType == rhs.indexType && isSameMaterialState(*lhs.material, *rhs.material);
+}
+
+// the cone test would drop the back faces a double sided material shows
+static bool canCullMeshlets(const Primitive& primitive) {
+    return primitive.meshletCount > 0 && !primitive.material->doubleSided;
+}
+
 PbrViewer::PbrViewer(const Options& options) : Application(options) {
-    _model.reset(new Model(getAssetFullPath(modelRelPath)));
+    // the model is parsed in the background while the environment is prepared
+    // the jobs report to the profiler
+    getJobSystem().setScopeHooks(
+        [this](const char* name) { _profiler.beginScope(name, false); },
+        [this]() { _profiler.endScope(); });
+    _assetLoader.reset(new AssetLoader(getJobSystem()));
+    _model = Model::loadAsync(*_assetLoader, getAssetFullPath(modelRelPath));
+
+    // multi draw indirect is core since opengl 4.3
+    _batchedDrawsSupported = GLAD_GL_VERSION_4_3;
+
+    // the driver compiles the shaders while the assets are loaded
+    initShaders();
+    _pendingShaderCount = _shaderBatch.getPendingCount();
 
     // camera
     _camera.reset(new PerspectiveCamera(
@@ -53,32 +134,11 @@ PbrViewer::PbrViewer(const Options& options) : Application(options) {
 
     // skybox
     glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
-
-    _skybox.reset(new Skybox(
-        getAssetFullPath(skyboxTextureRelPaths), getAssetFullPath(equirectVertShaderRelPath),
-        getAssetFullPath(equirectFragShaderRelPath), 512));
-
-    _skybox->generateIrradianceMap(
-        getAssetFullPath(irradianceVertShaderRelPath),
-        getAssetFullPath(irradianceFragShaderRelPath), 32, glm::radians(1.0f), glm::radians(1.0f));
-
-    _skybox->generatePrefilterMap(
-        getAssetFullPath(prefilterVertShaderRelPath), getAssetFullPath(prefilterFragShaderRelPath),
-        128, 4096);
-
-    _skybox->generateBrdfLutMap(
-        getAssetFullPath(brdfLutVertShaderRelPath), getAssetFullPath(brdfLutFragShaderRelPath), 512,
-        4096);
+    loadSkybox();
 
     // fullscreen quad
     _quad.reset(new FullscreenQuad);
 
-    initShaders();
-
-    setupUniformBufferObjects();
-
-    confirmBindingPoints();
-
     // init imGUI
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -88,9 +148,15 @@ PbrViewer::PbrViewer(const Options& options) : Application(options) {
     ImGui::StyleColorsDark();
     ImGui_ImplGlfw_InitForOpenGL(_window, true);
     ImGui_ImplOpenGL3_Init();
+    // the font texture is created here since the ui is built without the context
+    ImGui_ImplOpenGL3_NewFrame();
 }
 
 PbrViewer::~PbrViewer() {
+    // the job system outlives the profiler its hooks report to
+    _assetLoader.reset();
+    getJobSystem().setScopeHooks(nullptr, nullptr);
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -108,188 +174,527 @@ void PbrViewer::handleInput() {
 
     _input.forwardState();
 
-    updateUniforms();
-    enqueueRenderables();
+    if (_model.failed()) {
+        throw std::runtime_error(_model.getError());
+    }
+
+    if (_skybox.failed()) {
+        throw std::runtime_error(_skybox.getError());
+    }
+
+    showFpsInWindowTitle();
+
+    FramePacket& packet = _framePackets[getFramePacketIndex(false)];
+    prepareFramePacket(packet);
+    renderUI(packet);
+
+    // printRenderQueue("Opaque Queue", packet.opaqueQueue);
+    // printRenderQueue("Alpha Queue", packet.alphaQueue);
+    // printRenderQueue("Transparent Queue", packet.transparentQueue);
+}
+
+void PbrViewer::prepareFramePacket(FramePacket& packet) {
+    packet.projection = _camera->getProjectionMatrix();
+    packet.view = _camera->getViewMatrix();
+    packet.viewPosition = _camera->transform.position;
+    packet.lightDirection = _directionalLight->transform.getFront();
+    packet.lightColor = _directionalLight->color;
+    packet.lightIntensity = _directionalLight->intensity;
+    if (_skybox.ready()) {
+        packet.exposure = _skybox->exposure;
+        packet.gamma = _skybox->gamma;
+        packet.scaleIBLAmbient = _skybox->scaleIBLAmbient;
+        packet.backgroundLod = _skybox->backgroundLod;
+    }
+    packet.debugInput = _debugInput;
+    packet.skyboxRenderMode = _skyboxRenderMode;
+    packet.batchedDraws = _batchedDrawsSupported && _batchedDraws;
+    packet.meshletCulling = packet.batchedDraws && _meshletCulling;
 
-    // printRenderQueue("Opaque Queue", _opaqueQueue);
-    // printRenderQueue("Alpha Queue", _alphaQueue);
-    // printRenderQueue("Transparent Queue", _transparentQueue);
+    enqueueRenderables(packet);
 }
 
-void PbrViewer::enqueueRenderables() {
-    _opaqueQueue.clear();
-    _alphaQueue.clear();
-    _transparentQueue.clear();
+void PbrViewer::enqueueRenderables(FramePacket& packet) {
+    packet.opaqueQueue.clear();
+    packet.alphaQueue.clear();
+    packet.transparentQueue.clear();
+
+    // only the skybox is drawn until the model is uploaded
+    if (!_model.ready()) {
+        return;
+    }
 
     static glm::mat4 globalMatrix = glm::mat4(1.0f);
     // globalMatrix = glm::rotate(globalMatrix, _deltaTime * 1.0f, glm::vec3(0.0f, 1.0f, 0.0f));
     for (const Node* node : _model->getRootNodes()) {
-        enqueueRenderable(*node, globalMatrix);
+        enqueueRenderable(packet, *node, globalMatrix);
+    }
+
+    // sorted here so that the render thread only submits
+    for (auto* queue : {&packet.opaqueQueue, &packet.alphaQueue, &packet.transparentQueue}) {
+        sortRenderQueue(*queue, packet.sortScratch);
     }
 }
 
-void PbrViewer::enqueueRenderable(const Node& node, glm::mat4 parentGlobalMatrix) {
+void PbrViewer::enqueueRenderable(
+    FramePacket& packet, const Node& node, glm::mat4 parentGlobalMatrix) {
     glm::mat4 nodeGlobalMatrix = parentGlobalMatrix * node.transform.getLocalMatrix();
+    const float depth = -(packet.view * nodeGlobalMatrix[3]).z;
 
     for (const auto& primitive : node.primitives) {
-        RenderObject object = {nodeGlobalMatrix, &primitive};
-        switch (primitive.material->alphaMode) {
-        case Material::AlphaMode::Opaque: _opaqueQueue.emplace_back(object); break;
-        case Material::AlphaMode::Mask: _alphaQueue.emplace_back(object); break;
-        case Material::AlphaMode::Blend: _transparentQueue.emplace_back(object); break;
+        const PbrMaterial& material = *primitive.material;
+        const uint32_t features = getPbrShaderFeatures(material, packet.debugInput);
+        RenderObject object = {nodeGlobalMatrix, &primitive, 0};
+        switch (material.alphaMode) {
+        case Material::AlphaMode::Opaque:
+            object.sortKey = makeSortKey(
+                RenderPass::Opaque, features, material.index, primitive.vertexArray, depth);
+            packet.opaqueQueue.emplace_back(object);
+            break;
+        case Material::AlphaMode::Mask:
+            object.sortKey = makeSortKey(
+                RenderPass::AlphaMask, features, material.index, primitive.vertexArray, depth);
+            packet.alphaQueue.emplace_back(object);
+            break;
+        case Material::AlphaMode::Blend:
+            object.sortKey = makeSortKey(
+                RenderPass::Transparent, features, material.index, primitive.vertexArray, depth);
+            packet.transparentQueue.emplace_back(object);
+            break;
         }
     }
 
     for (const Node* childNode : node.children) {
-        enqueueRenderable(*childNode, nodeGlobalMatrix);
+        enqueueRenderable(packet, *childNode, nodeGlobalMatrix);
     }
 }
 
 void PbrViewer::drawPrimitive(const Primitive& primitive) const {
-    // double sided
-    bool doubleSided = primitive.material->doubleSided;
-    if (!doubleSided) {
-        glEnable(GL_CULL_FACE);
-        glCullFace(GL_BACK);
-    }
+    setFaceCulling(*primitive.material);
 
     // draw call
-    glBindVertexArray(primitive.vertexArray);
+    GLStateCache::bindVertexArray(primitive.vertexArray);
     if (primitive.indexCount > 0) {
         glDrawElements(
-            GL_TRIANGLES, primitive.indexCount, GL_UNSIGNED_INT,
-            (GLvoid*)(sizeof(uint32_t) * primitive.firstIndex));
+            GL_TRIANGLES, primitive.indexCount, primitive.indexType,
+            (GLvoid*)(getIndexTypeSize(primitive.indexType) * primitive.firstIndex));
     } else {
         glDrawArrays(GL_TRIANGLES, primitive.firstVertex, primitive.vertexCount);
     }
-    glBindVertexArray(0);
+}
 
-    // restore opengl state
-    if (!doubleSided) {
-        glDisable(GL_CULL_FACE);
+void PbrViewer::setFaceCulling(const PbrMaterial& material) const {
+    // the state is left for the next primitive, the state cache drops the repeated calls
+    if (material.doubleSided) {
+        GLStateCache::disable(GL_CULL_FACE);
+    } else {
+        GLStateCache::enable(GL_CULL_FACE);
+        GLStateCache::cullFace(GL_BACK);
     }
 }
 
 void PbrViewer::renderFrame() {
-    showFpsInWindowTitle();
+    FramePacket& packet = _framePackets[getFramePacketIndex(true)];
+
+    {
+        ProfileScope scope(_profiler, "asset uploads", false);
+        _assetLoader->processUploads(assetUploadBudgetMs);
+    }
+
+    // frames without the scene are presented until the shaders are linked
+    if (!_shadersReady) {
+        const bool linked = _shaderBatch.poll();
+        _pendingShaderCount = _shaderBatch.getPendingCount();
+        if (linked) {
+            setupUniformBufferObjects();
+            confirmBindingPoints();
+            _shadersReady = true;
+        }
+    }
+
     clearScreen();
 
-    renderOpaqueQueue();
+    if (_shadersReady && _skybox.ready()) {
+        updateUniforms(packet);
+        setProfilerCounters(packet);
+        if (packet.batchedDraws) {
+            reserveBatchStreams(packet);
+        }
+
+        _culledTriangleCount = 0;
+
+        {
+            ProfileScope scope(_profiler, "opaque");
+            renderOpaqueQueue(packet);
+        }
+
+        {
+            ProfileScope scope(_profiler, "alpha mask");
+            renderAlphaQueue(packet);
+        }
+
+        _profiler.setCounter("culled triangles", static_cast<double>(_culledTriangleCount));
+
+        if (packet.batchedDraws) {
+            _instanceStream->endFrame();
+            _indirectStream->endFrame();
+        }
+
+        {
+            ProfileScope scope(_profiler, "skybox");
+            renderSkybox(packet);
+        }
+
+        {
+            ProfileScope scope(_profiler, "transparent");
+            renderTransparentQueue(packet);
+        }
+    }
+
+    {
+        ProfileScope scope(_profiler, "ui");
+        if (ImDrawData* drawData = packet.ui.get()) {
+            ImGui_ImplOpenGL3_RenderDrawData(drawData);
+        }
+    }
+}
+
+void PbrViewer::beginRenderThread() {
+    // the gpu queries of the frames are issued on the render thread
+    _profiler.setOwnerThread(std::this_thread::get_id());
+}
 
-    renderAlphaQueue();
+Profiler* PbrViewer::getProfiler() {
+    return &_profiler;
+}
 
-    renderSkybox();
+bool PbrViewer::isPipelineSupported() const {
+    return true;
+}
 
-    renderTransparentQueue();
+void PbrViewer::setProfilerCounters(const FramePacket& packet) {
+    size_t drawCount = 0;
+    size_t triangleCount = 0;
+    size_t materialSwitchCount = 0;
+    for (const auto* queue : {&packet.opaqueQueue, &packet.alphaQueue, &packet.transparentQueue}) {
+        const bool batched = packet.batchedDraws && queue != &packet.transparentQueue;
+        const Primitive* previous = nullptr;
+        for (const auto& object : *queue) {
+            const Primitive& primitive = *object.primitive;
+            if (previous == nullptr || primitive.material != previous->material) {
+                ++materialSwitchCount;
+            }
+
+            // a batch is submitted by a single call
+            if (!batched || previous == nullptr || !isSameBatch(*previous, primitive)) {
+                ++drawCount;
+            }
+
+            previous = &primitive;
+            triangleCount +=
+                (primitive.indexCount > 0 ? primitive.indexCount : primitive.vertexCount) / 3;
+        }
+    }
 
-    renderUI();
+    _profiler.setCounter("draw calls", static_cast<double>(drawCount));
+    _profiler.setCounter("triangles", static_cast<double>(triangleCount));
+    _profiler.setCounter("material switches", static_cast<double>(materialSwitchCount));
 }
 
 void PbrViewer::clearScreen() {
     glClearColor(_clearColor.r, _clearColor.g, _clearColor.b, _clearColor.a);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glEnable(GL_DEPTH_TEST);
+    GLStateCache::enable(GL_DEPTH_TEST);
 }
 
-void PbrViewer::updateUniforms() {
+void PbrViewer::updateUniforms(const FramePacket& packet) {
+    // the values are written to the cpu copies, only the changed ranges are uploaded
     // camera
-    _uboCamera->update("projection", _camera->getProjectionMatrix());
-    _uboCamera->update("view", _camera->getViewMatrix());
-    _uboCamera->update("viewPosition", _camera->transform.position);
+    _uboCamera->set(_uboHandles.projection, packet.projection);
+    _uboCamera->set(_uboHandles.view, packet.view);
+    _uboCamera->set(_uboHandles.viewPosition, packet.viewPosition);
+    _uboCamera->flush();
 
     // lights
-    _uboLights->update("directionalLightCount", 1);
-    _uboLights->update("directionalLights[0].direction", _directionalLight->transform.getFront());
-    _uboLights->update("directionalLights[0].color", _directionalLight->color);
-    _uboLights->update("directionalLights[0].intensity", _directionalLight->intensity);
-    _uboLights->update("pointLightCount", 0);
-    _uboLights->update("spotLightCount", 0);
+    _uboLights->set(_uboHandles.directionalLightCount, 1);
+    _uboLights->set(_uboHandles.directionalLightDirection, packet.lightDirection);
+    _uboLights->set(_uboHandles.directionalLightColor, packet.lightColor);
+    _uboLights->set(_uboHandles.directionalLightIntensity, packet.lightIntensity);
+    _uboLights->set(_uboHandles.pointLightCount, 0);
+    _uboLights->set(_uboHandles.spotLightCount, 0);
+    _uboLights->flush();
 
     // IBL
-    _uboEnvironment->update("exposure", _skybox->exposure);
-    _uboEnvironment->update("gamma", _skybox->gamma);
-    _uboEnvironment->update("maxPrefilterMipLevel", _skybox->getMaxPrefilterMipLevel());
-    _uboEnvironment->update("scaleIBLAmbient", _skybox->scaleIBLAmbient);
+    _uboEnvironment->set(_uboHandles.exposure, packet.exposure);
+    _uboEnvironment->set(_uboHandles.gamma, packet.gamma);
+    _uboEnvironment->set(_uboHandles.maxPrefilterMipLevel, _skybox->getMaxPrefilterMipLevel());
+    _uboEnvironment->set(_uboHandles.scaleIBLAmbient, packet.scaleIBLAmbient);
+    _uboEnvironment->flush();
 }
 
-void PbrViewer::renderOpaqueQueue() const {
-    for (const auto& object : _opaqueQueue) {
-        _pbrShader->use();
-        setPbrShaderUniforms(object);
-        drawPrimitive(*object.primitive);
+void PbrViewer::renderOpaqueQueue(const FramePacket& packet) {
+    if (packet.batchedDraws) {
+        renderPbrQueueBatched(packet, packet.opaqueQueue);
+    } else {
+        renderPbrQueue(packet, packet.opaqueQueue);
     }
 }
 
-void PbrViewer::renderAlphaQueue() const {
-    for (const auto& object : _alphaQueue) {
-        _pbrShader->use();
-        setPbrShaderUniforms(object);
-        drawPrimitive(*object.primitive);
+void PbrViewer::renderAlphaQueue(const FramePacket& packet) {
+    if (packet.batchedDraws) {
+        renderPbrQueueBatched(packet, packet.alphaQueue);
+    } else {
+        renderPbrQueue(packet, packet.alphaQueue);
     }
 }
 
-void PbrViewer::renderTransparentQueue() const {
-    // TODO: sort the object from near to far
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    for (const auto& object : _transparentQueue) {
-        _pbrShader->use();
-        setPbrShaderUniforms(object);
+void PbrViewer::renderTransparentQueue(const FramePacket& packet) const {
+    GLStateCache::enable(GL_BLEND);
+    GLStateCache::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    renderPbrQueue(packet, packet.transparentQueue);
+    GLStateCache::disable(GL_BLEND);
+}
+
+void PbrViewer::renderPbrQueue(
+    const FramePacket& packet, const std::vector<RenderObject>& queue) const {
+    const PbrShader* boundShader = nullptr;
+    const PbrMaterial* boundMaterial = nullptr;
+    uint32_t boundMaterialBlock = std::numeric_limits<uint32_t>::max();
+    for (const auto& object : queue) {
+        const PbrMaterial* material = object.primitive->material;
+        const PbrShader& shader = getPbrShader(getPbrShaderFeatures(*material, packet.debugInput));
+        if (&shader != boundShader) {
+            shader.program->use();
+            setPbrFrameUniforms(shader, packet);
+            boundShader = &shader;
+            boundMaterial = nullptr;
+        }
+
+        // the material parameters are read from the table of the model by index
+        if (material != boundMaterial) {
+            bindPbrMaterial(*material, boundMaterialBlock);
+            shader.program->setUniform(
+                shader.uniforms.materialIndex,
+                static_cast<int>(material->index % Model::materialsPerBlock));
+            boundMaterial = material;
+        }
+
+        shader.program->setUniform(shader.uniforms.model, object.globalMatrix);
         drawPrimitive(*object.primitive);
     }
-    glDisable(GL_BLEND);
 }
 
-void PbrViewer::renderSkybox() const {
-    switch (_skyboxRenderMode) {
+void PbrViewer::renderPbrQueueBatched(
+    const FramePacket& packet, const std::vector<RenderObject>& queue) {
+    if (queue.empty()) {
+        return;
+    }
+
+    // one instance per object and one command per object or per run of its visible
+    // meshlets, the base instance of the commands of object i is i. the commands of the
+    // non indexed primitives are left unused
+    const StreamAllocation instances =
+        _instanceStream->allocate(queue.size() * sizeof(PbrInstance), sizeof(glm::vec4));
+    PbrInstance* instanceData = static_cast<PbrInstance*>(instances.data);
+    const glm::mat4 viewProjection = packet.projection * packet.view;
+    _drawCommands.clear();
+    _drawCommandOffsets.clear();
+    for (size_t i = 0; i < queue.size(); ++i) {
+        const Primitive& primitive = *queue[i].primitive;
+        instanceData[i].model = queue[i].globalMatrix;
+        instanceData[i].materialIndex =
+            static_cast<int32_t>(primitive.material->index % Model::materialsPerBlock);
+        _drawCommandOffsets.push_back(_drawCommands.size());
+        if (!packet.meshletCulling || !canCullMeshlets(primitive)) {
+            _drawCommands.push_back(
+                {primitive.indexCount, 1, primitive.firstIndex, 0, static_cast<unsigned int>(i)});
+            continue;
+        }
+
+        const size_t first = _drawCommands.size();
+        cullMeshlets(
+            _model->getMeshlets().data() + primitive.firstMeshlet, primitive.meshletCount,
+            queue[i].globalMatrix, viewProjection, packet.viewPosition, _drawCommands);
+
+        size_t drawnIndexCount = 0;
+        for (size_t c = first; c < _drawCommands.size(); ++c) {
+            _drawCommands[c].baseInstance = static_cast<unsigned int>(i);
+            drawnIndexCount += _drawCommands[c].count;
+        }
+
+        _culledTriangleCount += (primitive.indexCount - drawnIndexCount) / 3;
+    }
+
+    _drawCommandOffsets.push_back(_drawCommands.size());
+    _instanceStream->flush();
+
+    const size_t commandSize = _drawCommands.size() * sizeof(DrawElementsIndirectCommand);
+    const StreamAllocation commands = _indirectStream->allocate(commandSize, 4);
+    if (commandSize > 0) {
+        std::memcpy(commands.data, _drawCommands.data(), commandSize);
+        _indirectStream->flush();
+    }
+    _indirectStream->bind(GL_DRAW_INDIRECT_BUFFER);
+
+    const PbrShader* boundShader = nullptr;
+    const PbrMaterial* boundMaterial = nullptr;
+    uint32_t boundMaterialBlock = std::numeric_limits<uint32_t>::max();
+    GLuint boundVertexArray = 0;
+    for (size_t begin = 0; begin < queue.size();) {
+        const Primitive& primitive = *queue[begin].primitive;
+        size_t end = begin + 1;
+        while (end < queue.size() && isSameBatch(primitive, *queue[end].primitive)) {
+            ++end;
+        }
+
+        const PbrMaterial* material = primitive.material;
+        const PbrShader& shader = getPbrShader(
+            getPbrShaderFeatures(*material, packet.debugInput) | PbrShaderFeature::Instanced);
+        if (&shader != boundShader) {
+            shader.program->use();
+            setPbrFrameUniforms(shader, packet);
+            boundShader = &shader;
+        }
+
+        if (material != boundMaterial) {
+            bindPbrMaterial(*material, boundMaterialBlock);
+            boundMaterial = material;
+        }
+
+        if (primitive.vertexArray != boundVertexArray) {
+            bindInstanceAttributes(primitive.vertexArray, instances.offset);
+            boundVertexArray = primitive.vertexArray;
+        }
+
+        setFaceCulling(*material);
+        if (primitive.indexCount > 0) {
+            const size_t firstCommand = _drawCommandOffsets[begin];
+            const size_t commandCount = _drawCommandOffsets[end] - firstCommand;
+            if (commandCount > 0) {
+                glMultiDrawElementsIndirect(
+                    GL_TRIANGLES, primitive.indexType,
+                    reinterpret_cast<const void*>(
+                        commands.offset + firstCommand * sizeof(DrawElementsIndirectCommand)),
+                    static_cast<GLsizei>(commandCount), 0);
+            }
+        } else {
+            glDrawArraysInstancedBaseInstance(
+                GL_TRIANGLES, primitive.firstVertex, primitive.vertexCount, 1,
+                static_cast<GLuint>(begin));
+        }
+
+        begin = end;
+    }
+
+    _indirectStream->unbind(GL_DRAW_INDIRECT_BUFFER);
+}
+
+void PbrViewer::reserveBatchStreams(const FramePacket& packet) {
+    const size_t objectCount = packet.opaqueQueue.size() + packet.alphaQueue.size();
+    // an object culled by meshlets takes at most one command per meshlet
+    size_t commandCount = 0;
+    for (const auto* queue : {&packet.opaqueQueue, &packet.alphaQueue}) {
+        for (const auto& object : *queue) {
+            const Primitive& primitive = *object.primitive;
+            const bool culled = packet.meshletCulling && canCullMeshlets(primitive);
+            commandCount += culled ? primitive.meshletCount : 1;
+        }
+    }
+
+    // the buffers still read by the gpu are released by the driver when it is done.
+    // there is room for the alignment of the allocations of the two queues
+    if (_instanceStream == nullptr || objectCount > _batchCapacity) {
+        _batchCapacity = std::max<size_t>({objectCount, 2 * _batchCapacity, 256});
+        _instanceStream.reset(
+            new StreamBuffer(_batchCapacity * sizeof(PbrInstance) + 2 * sizeof(glm::vec4)));
+    }
+
+    if (_indirectStream == nullptr || commandCount > _commandCapacity) {
+        _commandCapacity = std::max<size_t>({commandCount, 2 * _commandCapacity, 256});
+        _indirectStream.reset(
+            new StreamBuffer(_commandCapacity * sizeof(DrawElementsIndirectCommand) + 2 * 4));
+    }
+
+    _instanceStream->beginFrame();
+    _indirectStream->beginFrame();
+}
+
+void PbrViewer::bindInstanceAttributes(GLuint vertexArray, size_t offset) const {
+    GLStateCache::bindVertexArray(vertexArray);
+    _instanceStream->bind(GL_ARRAY_BUFFER);
+
+    for (GLuint column = 0; column < 4; ++column) {
+        const GLuint location = instanceAttributeLocation + column;
+        glVertexAttribPointer(
+            location, 4, GL_FLOAT, GL_FALSE, sizeof(PbrInstance),
+            reinterpret_cast<void*>(
+                offset + offsetof(PbrInstance, model) + column * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+
+    const GLuint materialLocation = instanceAttributeLocation + 4;
+    glVertexAttribIPointer(
+        materialLocation, 1, GL_INT, sizeof(PbrInstance),
+        reinterpret_cast<void*>(offset + offsetof(PbrInstance, materialIndex)));
+    glEnableVertexAttribArray(materialLocation);
+    glVertexAttribDivisor(materialLocation, 1);
+
+    _instanceStream->unbind(GL_ARRAY_BUFFER);
+}
+
+void PbrViewer::renderSkybox(const FramePacket& packet) const {
+    // the pbr passes leave the culling of their last primitive
+    GLStateCache::disable(GL_CULL_FACE);
+
+    switch (packet.skyboxRenderMode) {
     case SkyboxRenderMode::Irradiance: renderIrradianceMap(); break;
-    case SkyboxRenderMode::Prefilter: renderPrefilterMap(); break;
+    case SkyboxRenderMode::Prefilter: renderPrefilterMap(packet); break;
     case SkyboxRenderMode::BrdfLut: renderBrdfLutMap(); break;
     default:
-        glDepthFunc(GL_LEQUAL);
+        GLStateCache::depthFunc(GL_LEQUAL);
         _skyboxShader->use();
         _skyboxShader->setUniformInt("environmentMap", 0);
-        _skyboxShader->setUniformFloat("lod", _skybox->backgroundLod);
+        _skyboxShader->setUniformFloat("lod", packet.backgroundLod);
         _skybox->bindEnvironmentMap(0);
-        glBindSampler(0, 0);
+        GLStateCache::bindSampler(0, 0);
         _skybox->draw();
-        glDepthFunc(GL_LESS);
+        GLStateCache::depthFunc(GL_LESS);
         break;
     }
 }
 
 void PbrViewer::renderIrradianceMap() const {
-    glDepthFunc(GL_LEQUAL);
+    GLStateCache::depthFunc(GL_LEQUAL);
     _skyboxShader->use();
     _skyboxShader->setUniformInt("environmentMap", 0);
     _skyboxShader->setUniformFloat("lod", 0.0f);
     _skybox->irradianceMap->bind(0);
-    glBindSampler(0, 0);
+    GLStateCache::bindSampler(0, 0);
     _skybox->draw();
-    glDepthFunc(GL_LESS);
+    GLStateCache::depthFunc(GL_LESS);
 }
 
-void PbrViewer::renderPrefilterMap() const {
-    glDepthFunc(GL_LEQUAL);
+void PbrViewer::renderPrefilterMap(const FramePacket& packet) const {
+    GLStateCache::depthFunc(GL_LEQUAL);
     _skyboxShader->use();
     _skyboxShader->setUniformInt("environmentMap", 0);
-    _skyboxShader->setUniformFloat("environmentMap", _skybox->backgroundLod);
+    _skyboxShader->setUniformFloat("environmentMap", packet.backgroundLod);
     _skybox->prefilterMap->bind(0);
-    glBindSampler(0, 0);
+    GLStateCache::bindSampler(0, 0);
     _skybox->draw();
-    glDepthFunc(GL_LESS);
+    GLStateCache::depthFunc(GL_LESS);
 }
 
 void PbrViewer::renderBrdfLutMap() const {
     _quadShader->use();
     _quadShader->setUniformInt("inputTexture", 0);
     _skybox->brdfLutMap->bind(0);
-    glBindSampler(0, 0);
+    GLStateCache::bindSampler(0, 0);
     _quad->draw();
 }
 
-void PbrViewer::renderUI() const {
-    ImGui_ImplOpenGL3_NewFrame();
+void PbrViewer::renderUI(FramePacket& packet) const {
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
 
@@ -298,6 +703,18 @@ void PbrViewer::renderUI() const {
     if (!ImGui::Begin("Control Panel", nullptr, flags)) {
         ImGui::End();
     } else {
+        if (!_shadersReady) {
+            ImGui::Text("compiling shaders (%d left) ...", (int)_pendingShaderCount.load());
+        }
+
+        if (!_skybox.ready()) {
+            ImGui::Text("generating environment maps ...");
+        }
+
+        if (!_model.ready()) {
+            ImGui::Text("loading model ...");
+        }
+
         if (ImGui::CollapsingHeader("Lighting", ImGuiTreeNodeFlags_DefaultOpen)) {
             ImGui::Text("directional light");
             ImGui::Separator();
@@ -305,10 +722,12 @@ void PbrViewer::renderUI() const {
             ImGui::ColorEdit3("color", (float*)&_directionalLight->color);
             ImGui::Text("image based lighting");
             ImGui::Separator();
-            ImGui::SliderFloat("blur", &_skybox->backgroundLod, 0.0f, 8.0f);
-            // ImGui::SliderFloat("exposure", &_skybox->exposure, 0.0f, 10.0f);
-            // ImGui::SliderFloat("gamma", &_skybox->gamma, 0.1f, 4.0f);
-            ImGui::SliderFloat("scale", &_skybox->scaleIBLAmbient, 0.0f, 1.5f);
+            if (_skybox.ready()) {
+                ImGui::SliderFloat("blur", &_skybox->backgroundLod, 0.0f, 8.0f);
+                // ImGui::SliderFloat("exposure", &_skybox->exposure, 0.0f, 10.0f);
+                // ImGui::SliderFloat("gamma", &_skybox->gamma, 0.1f, 4.0f);
+                ImGui::SliderFloat("scale", &_skybox->scaleIBLAmbient, 0.0f, 1.5f);
+            }
         }
 
         if (ImGui::CollapsingHeader("Debug View", ImGuiTreeNodeFlags_DefaultOpen)) {
@@ -323,130 +742,221 @@ void PbrViewer::renderUI() const {
             ImGui::Combo(
                 "skybox texture", (int*)(&_skyboxRenderMode), skyboxTextureItems,
                 IM_ARRAYSIZE(skyboxTextureItems));
+
+            if (_batchedDrawsSupported) {
+                ImGui::Checkbox("batched draws", &_batchedDraws);
+                if (_batchedDraws) {
+                    ImGui::Checkbox("meshlet culling", &_meshletCulling);
+                }
+            }
         }
 
         ImGui::End();
     }
 
+    _profiler.renderUI();
+
     ImGui::Render();
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    packet.ui.capture(ImGui::GetDrawData());
 }
 
 void PbrViewer::initShaders() {
-    _pbrShader.reset(new GLSLProgram);
-    _pbrShader->attachVertexShaderFromFile(getAssetFullPath(pbrVertShaderRelPath));
-    _pbrShader->attachFragmentShaderFromFile(getAssetFullPath(pbrFragShaderRelPath));
-    _pbrShader->link();
+    _pbrShaders.reset(new GLSLProgramVariants(
+        getAssetFullPath(pbrVertShaderRelPath), getAssetFullPath(pbrFragShaderRelPath),
+        {"ALPHA_MASK", "DOUBLE_SIDED", "DEBUG_VIEW", "INSTANCED"}));
+    // the common variants are compiled ahead, the others on their first use
+    const uint32_t instanced = _batchedDrawsSupported ? PbrShaderFeature::Instanced : 0;
+    _pbrShaders->prepare(instanced, _shaderBatch);
+    _pbrShaders->prepare(PbrShaderFeature::AlphaMask | instanced, _shaderBatch);
 
     _skyboxShader.reset(new GLSLProgram);
     _skyboxShader->attachVertexShaderFromFile(getAssetFullPath(skyboxVertShaderRelPath));
     _skyboxShader->attachFragmentShaderFromFile(getAssetFullPath(skyboxFragShaderRelPath));
-    _skyboxShader->link();
+    _shaderBatch.add(*_skyboxShader);
 
     _quadShader.reset(new GLSLProgram);
     _quadShader->attachVertexShaderFromFile(getAssetFullPath(quadVertShaderRelPath));
     _quadShader->attachFragmentShaderFromFile(getAssetFullPath(quadFragShaderRelPath));
-    _quadShader->link();
-}
-
-void PbrViewer::setPbrShaderUniforms(const RenderObject& object) const {
-    const PbrMaterial* material = object.primitive->material;
-    _pbrShader->setUniformMat4("model", object.globalMatrix);
-    _pbrShader->setUniformVec4("material.albedoFactor", material->albedoFactor);
-    _pbrShader->setUniformVec4("material.emissiveFactor", material->emissiveFactor);
-    _pbrShader->setUniformFloat("material.metallicFactor", material->metallicFactor);
-    _pbrShader->setUniformFloat("material.roughnessFactor", material->roughnessFactor);
-    _pbrShader->setUniformFloat("material.occlusionStrength", material->occlusionStrength);
-    _pbrShader->setUniformInt("material.albedoTexCoordSet", material->texCoordSets.albedo);
-    _pbrShader->setUniformInt("material.metallicTexCoordSet", material->texCoordSets.metallic);
-    _pbrShader->setUniformInt("material.roughnessTexCoordSet", material->texCoordSets.roughness);
-    _pbrShader->setUniformInt("material.normalTexCoordSet", material->texCoordSets.normal);
-    _pbrShader->setUniformInt("material.emissiveTexCoordSet", material->texCoordSets.emissive);
-    _pbrShader->setUniformInt("material.occlusionTexCoordSet", material->texCoordSets.occlusion);
-
-    _pbrShader->setUniformBool("material.doubleSided", material->doubleSided);
-
-    switch (material->alphaMode) {
-    case Material::AlphaMode::Opaque:
-        _pbrShader->setUniformBool("material.alphaMask", false);
-        break;
-    case Material::AlphaMode::Mask: _pbrShader->setUniformBool("material.alphaMask", true); break;
+    _shaderBatch.add(*_quadShader);
+}
+
+void PbrViewer::loadSkybox() {
+    const std::string imagePath = getAssetFullPath(skyboxTextureRelPaths);
+    const std::string equirectVsPath = getAssetFullPath(equirectVertShaderRelPath);
+    const std::string equirectFsPath = getAssetFullPath(equirectFragShaderRelPath);
+    const std::string irradianceVsPath = getAssetFullPath(irradianceVertShaderRelPath);
+    const std::string irradianceFsPath = getAssetFullPath(irradianceFragShaderRelPath);
+    const std::string prefilterVsPath = getAssetFullPath(prefilterVertShaderRelPath);
+    const std::string prefilterFsPath = getAssetFullPath(prefilterFragShaderRelPath);
+    const std::string brdfLutVsPath = getAssetFullPath(brdfLutVertShaderRelPath);
+    const std::string brdfLutFsPath = getAssetFullPath(brdfLutFragShaderRelPath);
+
+    _skybox = _assetLoader->load<Skybox>(
+        [imagePath]() { return Skybox::loadEquirectImage(imagePath); },
+        [equirectVsPath, equirectFsPath](const Skybox::EquirectImage& image) {
+            return std::unique_ptr<Skybox>(
+                new Skybox(image, equirectVsPath, equirectFsPath, 512));
+        },
+        {[irradianceVsPath, irradianceFsPath](Skybox& skybox) {
+             skybox.generateIrradianceMap(
+                 irradianceVsPath, irradianceFsPath, 32, glm::radians(1.0f), glm::radians(1.0f));
+         },
+         [prefilterVsPath, prefilterFsPath](Skybox& skybox) {
+             skybox.generatePrefilterMap(prefilterVsPath, prefilterFsPath, 128, 4096);
+         },
+         [brdfLutVsPath, brdfLutFsPath](Skybox& skybox) {
+             skybox.generateBrdfLutMap(brdfLutVsPath, brdfLutFsPath, 512, 4096);
+         }});
+}
+
+uint32_t PbrViewer::getPbrShaderFeatures(
+    const PbrMaterial& material, DebugInput debugInput) const {
+    uint32_t features = 0;
+    switch (material.alphaMode) {
+    case Material::AlphaMode::Opaque: break;
+    case Material::AlphaMode::Mask: features |= PbrShaderFeature::AlphaMask; break;
     case Material::AlphaMode::Blend:
         // try to discard to opacity that is near zero:
         // when occur the blend matrial, the data parser has set alphaMask false,
         // but the alphaCutoff 0.05, which should have been ignored when alpha mode is blend
         // we can use the thick to discard the unwanted opacity texture
-        _pbrShader->setUniformBool("material.alphaMask", true);
+        features |= PbrShaderFeature::AlphaMask;
         break;
     }
-    _pbrShader->setUniformFloat("material.alphaMaskCutoff", material->alphaCutoff);
 
-    // textures
-    if (material->albedoMap && material->texCoordSets.albedo >= 0) {
-        _pbrShader->setUniformInt("albedoMap", 0);
-        material->albedoMap->bind(0);
-        if (material->albeodoSampler) {
-            material->albeodoSampler->bind(0);
-        }
+    if (material.doubleSided) {
+        features |= PbrShaderFeature::DoubleSided;
     }
 
-    if (material->roughnessMap && material->texCoordSets.roughness >= 0) {
-        _pbrShader->setUniformInt("roughnessMap", 1);
-        material->roughnessMap->bind(1);
-        if (material->roughnessSampler) {
-            material->roughnessSampler->bind(1);
-        }
+    if (debugInput != DebugInput::All) {
+        features |= PbrShaderFeature::DebugView;
     }
 
-    if (material->metallicMap && material->texCoordSets.metallic >= 0) {
-        _pbrShader->setUniformInt("metallicMap", 2);
-        material->metallicMap->bind(2);
-        if (material->metallicSampler) {
-            material->metallicSampler->bind(2);
-        }
-    }
+    return features;
+}
 
-    if (material->normalMap && material->texCoordSets.normal >= 0) {
-        _pbrShader->setUniformInt("normalMap", 3);
-        material->normalMap->bind(3);
-        if (material->normalSampler) {
-            material->normalSampler->bind(3);
-        }
+const PbrViewer::PbrShader& PbrViewer::getPbrShader(uint32_t features) const {
+    auto it = _pbrShaderCache.find(features);
+    if (it != _pbrShaderCache.end()) {
+        return it->second;
     }
 
-    if (material->occlusionMap && material->texCoordSets.occlusion >= 0) {
-        _pbrShader->setUniformInt("occlusionMap", 4);
-        material->occlusionMap->bind(4);
-        if (material->occlusionSampler) {
-            material->occlusionSampler->bind(4);
-        }
+    GLSLProgram& program = _pbrShaders->get(features);
+
+    PbrShaderUniforms uniforms;
+    // the instanced variants read them from the instance attributes
+    if (!(features & PbrShaderFeature::Instanced)) {
+        uniforms.model = program.getUniformHandle<glm::mat4>("model");
+        uniforms.materialIndex = program.getUniformHandle<int>("materialIndex");
     }
 
-    if (material->emissiveMap && material->texCoordSets.emissive >= 0) {
-        _pbrShader->setUniformInt("emissiveMap", 5);
-        material->emissiveMap->bind(5);
-        if (material->emissiveSampler) {
-            material->emissiveSampler->bind(5);
-        }
+    uniforms.albedoMap = program.getUniformHandle<int>("albedoMap");
+    uniforms.roughnessMap = program.getUniformHandle<int>("roughnessMap");
+    uniforms.metallicMap = program.getUniformHandle<int>("metallicMap");
+    uniforms.normalMap = program.getUniformHandle<int>("normalMap");
+    uniforms.occlusionMap = program.getUniformHandle<int>("occlusionMap");
+    uniforms.emissiveMap = program.getUniformHandle<int>("emissiveMap");
+    uniforms.irradianceMap = program.getUniformHandle<int>("irradianceMap");
+    uniforms.prefilterMap = program.getUniformHandle<int>("prefilterMap");
+    uniforms.brdfLutMap = program.getUniformHandle<int>("brdfLutMap");
+
+    // the uniform is compiled out of the variants without the feature
+    if (features & PbrShaderFeature::DebugView) {
+        uniforms.debugInput = program.getUniformHandle<int>("debugInput");
     }
 
+    program.setUniformBlockBinding("uboCamera", 0);
+    program.setUniformBlockBinding("uboLights", 1);
+    program.setUniformBlockBinding("uboEnvironment", 2);
+    program.setUniformBlockBinding("uboMaterials", materialBindingPoint);
+
+    return _pbrShaderCache.emplace(features, PbrShader{&program, uniforms}).first->second;
+}
+
+void PbrViewer::setPbrFrameUniforms(const PbrShader& shader, const FramePacket& packet) const {
+    const GLSLProgram& program = *shader.program;
+    const PbrShaderUniforms& uniforms = shader.uniforms;
+
+    // the texture units are fixed, bindPbrMaterial binds the material ones
+    program.setUniform(uniforms.albedoMap, 0);
+    program.setUniform(uniforms.roughnessMap, 1);
+    program.setUniform(uniforms.metallicMap, 2);
+    program.setUniform(uniforms.normalMap, 3);
+    program.setUniform(uniforms.occlusionMap, 4);
+    program.setUniform(uniforms.emissiveMap, 5);
+
     // IBL textures
-    _pbrShader->setUniformInt("irradianceMap", 6);
+    program.setUniform(uniforms.irradianceMap, 6);
     _skybox->irradianceMap->bind(6);
 
-    _pbrShader->setUniformInt("prefilterMap", 7);
+    program.setUniform(uniforms.prefilterMap, 7);
     _skybox->prefilterMap->bind(7);
 
-    _pbrShader->setUniformInt("brdfLutMap", 8);
+    program.setUniform(uniforms.brdfLutMap, 8);
     _skybox->brdfLutMap->bind(8);
 
     // debug
-    _pbrShader->setUniformInt("debugInput", static_cast<int>(_debugInput));
+    if (uniforms.debugInput.valid()) {
+        program.setUniform(uniforms.debugInput, static_cast<int>(packet.debugInput));
+    }
+}
+
+void PbrViewer::bindPbrMaterial(const PbrMaterial& material, uint32_t& boundMaterialBlock) const {
+    const uint32_t materialBlock = material.index / Model::materialsPerBlock;
+    if (materialBlock != boundMaterialBlock) {
+        _model->bindMaterialBlock(materialBindingPoint, materialBlock);
+        boundMaterialBlock = materialBlock;
+    }
+
+    if (material.albedoMap && material.texCoordSets.albedo >= 0) {
+        material.albedoMap->bind(0);
+        if (material.albeodoSampler) {
+            material.albeodoSampler->bind(0);
+        }
+    }
+
+    if (material.roughnessMap && material.texCoordSets.roughness >= 0) {
+        material.roughnessMap->bind(1);
+        if (material.roughnessSampler) {
+            material.roughnessSampler->bind(1);
+        }
+    }
+
+    if (material.metallicMap && material.texCoordSets.metallic >= 0) {
+        material.metallicMap->bind(2);
+        if (material.metallicSampler) {
+            material.metallicSampler->bind(2);
+        }
+    }
+
+    if (material.normalMap && material.texCoordSets.normal >= 0) {
+        material.normalMap->bind(3);
+        if (material.normalSampler) {
+            material.normalSampler->bind(3);
+        }
+    }
+
+    if (material.occlusionMap && material.texCoordSets.occlusion >= 0) {
+        material.occlusionMap->bind(4);
+        if (material.occlusionSampler) {
+            material.occlusionSampler->bind(4);
+        }
+    }
+
+    if (material.emissiveMap && material.texCoordSets.emissive >= 0) {
+        material.emissiveMap->bind(5);
+        if (material.emissiveSampler) {
+            material.emissiveSampler->bind(5);
+        }
+    }
 }
 
 void PbrViewer::setupUniformBufferObjects() {
     // uboCamera
-    int uboCameraSize = _pbrShader->getUniformBlockSize("uboCamera");
+    // the uniform blocks have the same layout in all the variants
+    const GLSLProgram& pbrShader =
+        _pbrShaders->get(_batchedDrawsSupported ? PbrShaderFeature::Instanced : 0);
+    int uboCameraSize = pbrShader.getUniformBlockSize("uboCamera");
     if (uboCameraSize <= 0) {
         throw std::runtime_error("get uboCamera size failure");
     }
@@ -460,7 +970,7 @@ void PbrViewer::setupUniformBufferObjects() {
     };
 
     for (const auto& name : uboCameraVariableNames) {
-        int offset = _pbrShader->getUniformBlockVariableOffset(name);
+        int offset = pbrShader.getUniformBlockVariableOffset(name);
         if (offset <= -1) {
             throw std::runtime_error("get uboCamera." + name + " offset failure");
         } else {
@@ -469,7 +979,7 @@ void PbrViewer::setupUniformBufferObjects() {
     }
 
     // uboLights
-    int uboLightsSize = _pbrShader->getUniformBlockSize("uboLights");
+    int uboLightsSize = pbrShader.getUniformBlockSize("uboLights");
     if (uboLightsSize <= 0) {
         throw std::runtime_error("get uboLights size failure");
     }
@@ -513,7 +1023,7 @@ void PbrViewer::setupUniformBufferObjects() {
     }
 
     for (const auto& name : uboLightsVariableNames) {
-        int offset = _pbrShader->getUniformBlockVariableOffset(name);
+        int offset = pbrShader.getUniformBlockVariableOffset(name);
         if (offset <= -1) {
             throw std::runtime_error("get uboLights." + name + " offset failure");
         } else {
@@ -522,7 +1032,7 @@ void PbrViewer::setupUniformBufferObjects() {
     }
 
     // uboEnvironment
-    int uboEnvironmentSize = _pbrShader->getUniformBlockSize("uboEnvironment");
+    int uboEnvironmentSize = pbrShader.getUniformBlockSize("uboEnvironment");
     if (uboEnvironmentSize <= 0) {
         throw std::runtime_error("get uboEnvironment size failure");
     }
@@ -532,13 +1042,31 @@ void PbrViewer::setupUniformBufferObjects() {
         "exposure", "gamma", "maxPrefilterMipLevel", "scaleIBLAmbient"};
 
     for (const auto& name : uboEnvironmentNames) {
-        int offset = _pbrShader->getUniformBlockVariableOffset(name);
+        int offset = pbrShader.getUniformBlockVariableOffset(name);
         if (offset <= -1) {
             throw std::runtime_error("get uboEnvironment." + name + " offset failure");
         } else {
             _uboEnvironment->setOffset(name, static_cast<size_t>(offset));
         }
     }
+
+    _uboHandles.projection = _uboCamera->getHandle<glm::mat4>("projection");
+    _uboHandles.view = _uboCamera->getHandle<glm::mat4>("view");
+    _uboHandles.viewPosition = _uboCamera->getHandle<glm::vec3>("viewPosition");
+    _uboHandles.directionalLightCount = _uboLights->getHandle<int>("directionalLightCount");
+    _uboHandles.directionalLightDirection =
+        _uboLights->getHandle<glm::vec3>("directionalLights[0].direction");
+    _uboHandles.directionalLightColor =
+        _uboLights->getHandle<glm::vec3>("directionalLights[0].color");
+    _uboHandles.directionalLightIntensity =
+        _uboLights->getHandle<float>("directionalLights[0].intensity");
+    _uboHandles.pointLightCount = _uboLights->getHandle<int>("pointLightCount");
+    _uboHandles.spotLightCount = _uboLights->getHandle<int>("spotLightCount");
+    _uboHandles.exposure = _uboEnvironment->getHandle<float>("exposure");
+    _uboHandles.gamma = _uboEnvironment->getHandle<float>("gamma");
+    _uboHandles.maxPrefilterMipLevel =
+        _uboEnvironment->getHandle<uint32_t>("maxPrefilterMipLevel");
+    _uboHandles.scaleIBLAmbient = _uboEnvironment->getHandle<float>("scaleIBLAmbient");
 }
 
 void PbrViewer::confirmBindingPoints() {
@@ -547,11 +1075,6 @@ void PbrViewer::confirmBindingPoints() {
     _uboLights->setBindingPoint(1);
     _uboEnvironment->setBindingPoint(2);
 
-    // pbr shader binding point
-    _pbrShader->setUniformBlockBinding("uboCamera", 0);
-    _pbrShader->setUniformBlockBinding("uboLights", 1);
-    _pbrShader->setUniformBlockBinding("uboEnvironment", 2);
-
     // skybox shader binding point
     _skyboxShader->setUniformBlockBinding("uboCamera", 0);
 }
@@ -1,18 +1,25 @@
 #pragma once
 
+#include <atomic>
 #include <map>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "../base/application.h"
+#include "../base/asset_loader.h"
 #include "../base/camera.h"
 #include "../base/fullscreen_quad.h"
 #include "../base/glsl_program.h"
+#include "../base/job_system.h"
 #include "../base/light.h"
+#include "../base/profiler.h"
+#include "../base/stream_buffer.h"
 #include "../base/texture.h"
 #include "../base/uniform_buffer.h"
 
 #include "./camera_controller.h"
+#include "./draw_data_snapshot.h"
 #include "./model.h"
 #include "./render_object.h"
 #include "./skybox.h"
@@ -24,15 +31,81 @@ public:
     ~PbrViewer();
 
 private:
-    std::unique_ptr<Model> _model;
-    std::unique_ptr<GLSLProgram> _pbrShader;
+    Profiler _profiler;
+
+    // runs on the jobs of the application
+    std::unique_ptr<AssetLoader> _assetLoader;
+
+    AssetHandle<Model> _model;
+
+    // the pbr shader is specialized by the material features so that the shader of
+    // an object only contains the branches it takes
+    enum PbrShaderFeature : uint32_t {
+        AlphaMask = 1 << 0,
+        DoubleSided = 1 << 1,
+        DebugView = 1 << 2,
+        Instanced = 1 << 3,
+    };
+    std::unique_ptr<GLSLProgramVariants> _pbrShaders;
+
+    // the shaders are linked in the background, the scene is drawn once they are ready.
+    // they are polled by the render thread and shown in the ui of the main thread
+    GLSLProgramBatch _shaderBatch;
+    std::atomic<bool> _shadersReady{false};
+    std::atomic<size_t> _pendingShaderCount{0};
+
+    // uniforms of a pbr shader variant set per object, resolved once after linking
+    struct PbrShaderUniforms {
+        UniformHandle<glm::mat4> model;
+        UniformHandle<int> materialIndex;
+        UniformHandle<int> albedoMap;
+        UniformHandle<int> roughnessMap;
+        UniformHandle<int> metallicMap;
+        UniformHandle<int> normalMap;
+        UniformHandle<int> occlusionMap;
+        UniformHandle<int> emissiveMap;
+        UniformHandle<int> irradianceMap;
+        UniformHandle<int> prefilterMap;
+        UniformHandle<int> brdfLutMap;
+        UniformHandle<int> debugInput;
+    };
+
+    struct PbrShader {
+        GLSLProgram* program;
+        PbrShaderUniforms uniforms;
+    };
+    mutable std::unordered_map<uint32_t, PbrShader> _pbrShaderCache;
+
+    // the opaque and alpha mask queues are drawn with a multi draw indirect call per run of
+    // objects sharing a material when the driver has it (OpenGL 4.3), the transforms and the
+    // material indices are streamed as instance attributes. otherwise they are drawn one by one
+    struct PbrInstance {
+        glm::mat4 model;
+        int32_t materialIndex;
+        int32_t padding[3];
+    };
+    bool _batchedDrawsSupported = false;
+    mutable bool _batchedDraws = true;
+    size_t _batchCapacity = 0;
+    size_t _commandCapacity = 0;
+    std::unique_ptr<StreamBuffer> _instanceStream;
+    std::unique_ptr<StreamBuffer> _indirectStream;
+    std::vector<DrawElementsIndirectCommand> _drawCommands;
+
+    // the batched draws submit the meshlets passing the frustum and cone tests instead of
+    // the whole primitives. the commands of object i start at _drawCommandOffsets[i]
+    mutable bool _meshletCulling = false;
+    std::vector<size_t> _drawCommandOffsets;
+    size_t _culledTriangleCount = 0;
 
     std::unique_ptr<PerspectiveCamera> _camera;
     std::unique_ptr<CameraController> _cameraController;
 
     std::unique_ptr<DirectionalLight> _directionalLight;
 
-    std::unique_ptr<Skybox> _skybox;
+    // the environment image is read in the background, the cubemap and the ibl maps are
+    // generated one per upload. the scene is drawn once they are all ready
+    AssetHandle<Skybox> _skybox;
     std::unique_ptr<GLSLProgram> _skyboxShader;
 
     std::unique_ptr<FullscreenQuad> _quad;
@@ -42,9 +115,22 @@ private:
     std::unique_ptr<UniformBuffer> _uboLights;
     std::unique_ptr<UniformBuffer> _uboEnvironment;
 
-    std::vector<RenderObject> _opaqueQueue;
-    std::vector<RenderObject> _alphaQueue;
-    std::vector<RenderObject> _transparentQueue;
+    // fields of the uniform blocks written per frame
+    struct UniformBufferHandles {
+        UniformBufferHandle<glm::mat4> projection;
+        UniformBufferHandle<glm::mat4> view;
+        UniformBufferHandle<glm::vec3> viewPosition;
+        UniformBufferHandle<int> directionalLightCount;
+        UniformBufferHandle<glm::vec3> directionalLightDirection;
+        UniformBufferHandle<glm::vec3> directionalLightColor;
+        UniformBufferHandle<float> directionalLightIntensity;
+        UniformBufferHandle<int> pointLightCount;
+        UniformBufferHandle<int> spotLightCount;
+        UniformBufferHandle<float> exposure;
+        UniformBufferHandle<float> gamma;
+        UniformBufferHandle<uint32_t> maxPrefilterMipLevel;
+        UniformBufferHandle<float> scaleIBLAmbient;
+    } _uboHandles;
 
     enum class DebugInput : int {
         All = 0,
@@ -65,40 +151,103 @@ private:
     };
     enum SkyboxRenderMode _skyboxRenderMode = {SkyboxRenderMode::Raw};
 
+    // everything renderFrame reads of a frame prepared by handleInput, so that the next
+    // frame can be prepared while the render thread submits this one in the pipelined mode
+    struct FramePacket {
+        glm::mat4 projection = glm::mat4(1.0f);
+        glm::mat4 view = glm::mat4(1.0f);
+        glm::vec3 viewPosition = glm::vec3(0.0f);
+        glm::vec3 lightDirection = glm::vec3(0.0f, 0.0f, -1.0f);
+        glm::vec3 lightColor = glm::vec3(1.0f);
+        float lightIntensity = 0.0f;
+        float exposure = 1.0f;
+        float gamma = 2.2f;
+        float scaleIBLAmbient = 1.0f;
+        float backgroundLod = 0.0f;
+        DebugInput debugInput = DebugInput::All;
+        SkyboxRenderMode skyboxRenderMode = SkyboxRenderMode::Raw;
+        bool batchedDraws = false;
+        bool meshletCulling = false;
+
+        std::vector<RenderObject> opaqueQueue;
+        std::vector<RenderObject> alphaQueue;
+        std::vector<RenderObject> transparentQueue;
+        std::vector<RenderObject> sortScratch;
+
+        DrawDataSnapshot ui;
+    };
+    FramePacket _framePackets[framePacketCount];
+
 private:
     void handleInput() override;
 
     void renderFrame() override;
 
-    void updateUniforms();
+    void beginRenderThread() override;
+
+    Profiler* getProfiler() override;
+
+    bool isPipelineSupported() const override;
 
-    void enqueueRenderables();
+    void prepareFramePacket(FramePacket& packet);
 
-    void enqueueRenderable(const Node& node, glm::mat4 parentGlobalMatrix);
+    void updateUniforms(const FramePacket& packet);
+
+    void enqueueRenderables(FramePacket& packet);
+
+    void enqueueRenderable(FramePacket& packet, const Node& node, glm::mat4 parentGlobalMatrix);
 
     void drawPrimitive(const Primitive& primitive) const;
 
+    void setFaceCulling(const PbrMaterial& material) const;
+
+    void setProfilerCounters(const FramePacket& packet);
+
     void clearScreen();
 
-    void renderOpaqueQueue() const;
+    void renderOpaqueQueue(const FramePacket& packet);
 
-    void renderAlphaQueue() const;
+    void renderAlphaQueue(const FramePacket& packet);
 
-    void renderTransparentQueue() const;
+    void renderTransparentQueue(const FramePacket& packet) const;
 
-    void renderSkybox() const;
+    void renderSkybox(const FramePacket& packet) const;
 
     void renderIrradianceMap() const;
 
-    void renderPrefilterMap() const;
+    void renderPrefilterMap(const FramePacket& packet) const;
 
     void renderBrdfLutMap() const;
 
-    void renderUI() const;
+    // build the ui on the main thread into the packet, it is drawn by renderFrame
+    void renderUI(FramePacket& packet) const;
 
     void initShaders();
 
-    void setPbrShaderUniforms(const RenderObject& object) const;
+    void loadSkybox();
+
+    uint32_t getPbrShaderFeatures(const PbrMaterial& material, DebugInput debugInput) const;
+
+    // the variant is linked on its first use
+    const PbrShader& getPbrShader(uint32_t features) const;
+
+    // draw a sorted queue, setting only the shader and the material state that differs from
+    // the previous object
+    void renderPbrQueue(const FramePacket& packet, const std::vector<RenderObject>& queue) const;
+
+    // one multi draw indirect call per run of objects with the same material
+    void renderPbrQueueBatched(const FramePacket& packet, const std::vector<RenderObject>& queue);
+
+    // grow the stream buffers of the batched draws to the queues and start their frame
+    void reserveBatchStreams(const FramePacket& packet);
+
+    // point the instance attributes of the vertex array to the instances of the queue
+    void bindInstanceAttributes(GLuint vertexArray, size_t offset) const;
+
+    void setPbrFrameUniforms(const PbrShader& shader, const FramePacket& packet) const;
+
+    // bind the block of the material table holding the material and the material textures
+    void bindPbrMaterial(const PbrMaterial& material, uint32_t& boundMaterialBlock) const;
 
     void setupUniformBufferObjects();
 
@@ -10,6 +10,11 @@ struct Primitive {
 
     uint32_t firstIndex;
     uint32_t indexCount;
+    GLenum indexType;
+
+    // the meshlets of the indexed primitives in the meshlet list of the model
+    uint32_t firstMeshlet;
+    uint32_t meshletCount;
 
     PbrMaterial* material;
 };
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <cstring>
+
+#include "render_object.h"
+
+namespace {
+constexpr int passBits = 2;
+constexpr int shaderVariantBits = 6;
+constexpr int materialBits = 16;
+constexpr int vertexArrayBits = 16;
+constexpr int depthBits = 24;
+
+uint64_t mask(uint32_t value, int bits) {
+    return static_cast<uint64_t>(value) & ((uint64_t(1) << bits) - 1);
+}
+
+// the bits of a non negative float order like the float itself, the sign bit is
+// dropped and the low mantissa bits do not fit
+uint32_t quantizeDepth(float depth) {
+    depth = std::max(depth, 0.0f);
+    uint32_t bits;
+    std::memcpy(&bits, &depth, sizeof(bits));
+    return bits >> (31 - depthBits);
+}
+}  // namespace
+
+uint64_t makeSortKey(
+    RenderPass pass, uint32_t shaderVariant, uint32_t material, uint32_t vertexArray,
+    float depth) {
+    const uint64_t state =
+        (mask(shaderVariant, shaderVariantBits) << (materialBits + vertexArrayBits))
+        | (mask(material, materialBits) << vertexArrayBits) | mask(vertexArray, vertexArrayBits);
+    uint64_t key = mask(static_cast<uint32_t>(pass), passBits) << (64 - passBits);
+    if (pass == RenderPass::Transparent) {
+        const uint32_t farToNear = ((1u << depthBits) - 1) - quantizeDepth(depth);
+        key |= static_cast<uint64_t>(farToNear) << (64 - passBits - depthBits);
+        key |= state;
+    } else {
+        key |= state << depthBits;
+        key |= quantizeDepth(depth);
+    }
+
+    return key;
+}
+
+void sortRenderQueue(std::vector<RenderObject>& queue, std::vector<RenderObject>& scratch) {
+    if (queue.size() < 2) {
+        return;
+    }
+
+    scratch.resize(queue.size());
+
+    uint64_t sharedBits = ~uint64_t(0);
+    for (const auto& object : queue) {
+        sharedBits &= ~(object.sortKey ^ queue[0].sortKey);
+    }
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        if (((sharedBits >> shift) & 0xff) == 0xff) {
+            continue;
+        }
+
+        size_t offsets[256] = {};
+        for (const auto& object : queue) {
+            ++offsets[(object.sortKey >> shift) & 0xff];
+        }
+
+        size_t sum = 0;
+        for (size_t& offset : offsets) {
+            const size_t count = offset;
+            offset = sum;
+            sum += count;
+        }
+
+        for (const auto& object : queue) {
+            scratch[offsets[(object.sortKey >> shift) & 0xff]++] = object;
+        }
+
+        queue.swap(scratch);
+    }
+}
\ No newline at end of file
@@ -1,9 +1,31 @@
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
 #include "primitive.h"
 #include <glm/glm.hpp>
 
 struct RenderObject {
     glm::mat4 globalMatrix;
     const Primitive* primitive;
-};
\ No newline at end of file
+    // submission order within the queue, see makeSortKey
+    uint64_t sortKey;
+};
+
+enum class RenderPass : uint32_t {
+    Opaque = 0,
+    AlphaMask,
+    Transparent
+};
+
+// pack the pass, the shader variant, the material, the vertex array and the view depth into
+// a key ordering the objects of a pass by state changes, the most expensive one first, and
+// front to back for the same state. the transparent objects are ordered back to front
+// first, as the blending needs it, and by state only at the same depth
+uint64_t makeSortKey(
+    RenderPass pass, uint32_t shaderVariant, uint32_t material, uint32_t vertexArray, float depth);
+
+// stable lsd radix sort of the queue by the sort keys, the bytes shared by all the keys are
+// skipped. scratch is resized to the queue and kept between the calls
+void sortRenderQueue(std::vector<RenderObject>& queue, std::vector<RenderObject>& scratch);
\ No newline at end of file
@@ -15,11 +15,28 @@
 #include "skybox.h"
 
 Skybox::Skybox(
-    const std::string& equirectImagePath, const std::string& equirectToCubemapVsFilepath,
+    const EquirectImage& equirectImage, const std::string& equirectToCubemapVsFilepath,
     const std::string& equirectToCubemapFsFilepath, const uint32_t resolution) {
     createVertexResources();
     equirectangulerToCubemap(
-        equirectImagePath, equirectToCubemapVsFilepath, equirectToCubemapFsFilepath, resolution);
+        equirectImage, equirectToCubemapVsFilepath, equirectToCubemapFsFilepath, resolution);
+}
+
+Skybox::EquirectImage Skybox::loadEquirectImage(const std::string& equirectImagePath) {
+    // the flag of the calling thread only, the model images are decoded on the job system
+    stbi_set_flip_vertically_on_load_thread(true);
+    EquirectImage image;
+    image.path = equirectImagePath;
+    image.data.reset(
+        stbi_loadf(equirectImagePath.c_str(), &image.width, &image.height, &image.channels, 0),
+        stbi_image_free);
+    stbi_set_flip_vertically_on_load_thread(false);
+
+    if (image.data == nullptr) {
+        throw std::runtime_error("load " + equirectImagePath + " failure");
+    }
+
+    return image;
 }
 
 Skybox::Skybox(Skybox&& rhs) noexcept
@@ -36,8 +53,8 @@ Skybox::~Skybox() {
 }
 
 void Skybox::bindEnvironmentMap(int slot) const {
-    glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, _texture);
+    GLStateCache::activeTexture(GL_TEXTURE0 + slot);
+    GLStateCache::bindTexture(GL_TEXTURE_CUBE_MAP, _texture);
 }
 
 uint32_t Skybox::getMaxPrefilterMipLevel() const {
@@ -45,9 +62,8 @@ uint32_t Skybox::getMaxPrefilterMipLevel() const {
 }
 
 void Skybox::draw() const {
-    glBindVertexArray(_vao);
+    GLStateCache::bindVertexArray(_vao);
     glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
 }
 
 void Skybox::createVertexResources() {
@@ -97,7 +113,7 @@ void Skybox::createVertexResources() {
     };
 
     glGenVertexArrays(1, &_vao);
-    glBindVertexArray(_vao);
+    GLStateCache::bindVertexArray(_vao);
 
     glGenBuffers(1, &_vbo);
     glBindBuffer(GL_ARRAY_BUFFER, _vbo);
@@ -106,17 +122,17 @@ void Skybox::createVertexResources() {
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
 
-    glBindVertexArray(0);
+    GLStateCache::bindVertexArray(0);
 }
 
 void Skybox::equirectangulerToCubemap(
-    const std::string& equirectImagePath, const std::string& equirectToCubemapVsFilepath,
+    const EquirectImage& equirectImage, const std::string& equirectToCubemapVsFilepath,
     const std::string& equirectToCubemapFsFilepath, uint32_t resolution) {
     resolution = nextPow2(resolution);
 
     // create cubemap texture
     glGenTextures(1, &_texture);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, _texture);
+    GLStateCache::bindTexture(GL_TEXTURE_CUBE_MAP, _texture);
     for (uint32_t i = 0; i < 6; ++i) {
         glTexImage2D(
             GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, resolution, resolution, 0, GL_RGB,
@@ -129,22 +145,12 @@ void Skybox::equirectangulerToCubemap(
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-
-    // load image and create texture
-    stbi_set_flip_vertically_on_load(true);
-    int width, height, channels;
-    std::unique_ptr<float, void (*)(float*)> data(
-        stbi_loadf(equirectImagePath.c_str(), &width, &height, &channels, 0), [](float* data) {
-            stbi_image_free(data);
-        });
-
-    if (data == nullptr) {
-        throw std::runtime_error("load " + equirectImagePath + " failure");
-    }
+    GLStateCache::bindTexture(GL_TEXTURE_CUBE_MAP, 0);
 
+    // create texture
     ImageTexture2D hdrTexture(
-        data.get(), width, height, channels, GL_RGB16F, GL_RGB, GL_FLOAT, equirectImagePath);
+        equirectImage.data.get(), equirectImage.width, equirectImage.height,
+        equirectImage.channels, GL_RGB16F, GL_RGB, GL_FLOAT, equirectImage.path);
 
     // create sampler for equirect texture
     Sampler hdrSampler;
@@ -176,9 +182,9 @@ void Skybox::equirectangulerToCubemap(
     Framebuffer framebuffer;
     framebuffer.bind();
 
-    glViewport(0, 0, resolution, resolution);
+    GLStateCache::viewport(0, 0, resolution, resolution);
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, _texture);
+    GLStateCache::bindTexture(GL_TEXTURE_CUBE_MAP, _texture);
 
     for (uint32_t i = 0; i < 6; ++i) {
         shader.setUniformMat4("view", views[i]);
@@ -196,23 +202,23 @@ void Skybox::equirectangulerToCubemap(
         draw();
     }
 
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    GLStateCache::bindTexture(GL_TEXTURE_CUBE_MAP, 0);
     framebuffer.unbind();
 
     // restore viewport
-    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    GLStateCache::viewport(viewport[0], viewport[1], viewport[2], viewport[3]);
     hdrTexture.unbind();
     hdrSampler.unbind(0);
 
     // generate mipmap
-    glBindTexture(GL_TEXTURE_CUBE_MAP, _texture);
+    GLStateCache::bindTexture(GL_TEXTURE_CUBE_MAP, _texture);
     glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    GLStateCache::bindTexture(GL_TEXTURE_CUBE_MAP, 0);
 }
 
 void Skybox::cleanup() {
     if (_vao != 0) {
-        glDeleteVertexArrays(1, &_vao);
+        GLStateCache::deleteVertexArrays(1, &_vao);
         _vao = 0;
     }
 
@@ -222,7 +228,7 @@ void Skybox::cleanup() {
     }
 
     if (_texture != 0) {
-        glDeleteTextures(1, &_texture);
+        GLStateCache::deleteTextures(1, &_texture);
         _texture = 0;
     }
 }
@@ -259,8 +265,8 @@ void Skybox::generateIrradianceMap(
     shader.setUniformFloat("deltaTheta", deltaTheta);
     shader.setUniformFloat("deltaPhi", deltaPhi);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, _texture);
+    GLStateCache::activeTexture(GL_TEXTURE0);
+    GLStateCache::bindTexture(GL_TEXTURE_CUBE_MAP, _texture);
 
     // remember previous viewport
     glm::ivec4 viewport;
@@ -269,7 +275,7 @@ void Skybox::generateIrradianceMap(
     // use the framebuffer to render to cubemap
     Framebuffer framebuffer;
     framebuffer.bind();
-    glViewport(0, 0, resolution, resolution);
+    GLStateCache::viewport(0, 0, resolution, resolution);
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
     for (uint32_t i = 0; i < 6; ++i) {
@@ -289,8 +295,8 @@ void Skybox::generateIrradianceMap(
     framebuffer.unbind();
 
     // restore OpenGL states
-    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    GLStateCache::viewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    GLStateCache::bindTexture(GL_TEXTURE_CUBE_MAP, 0);
 }
 
 void Skybox::generatePrefilterMap(
@@ -335,8 +341,8 @@ void Skybox::generatePrefilterMap(
     Framebuffer framebuffer;
     framebuffer.bind();
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, _texture);
+    GLStateCache::activeTexture(GL_TEXTURE0);
+    GLStateCache::bindTexture(GL_TEXTURE_CUBE_MAP, _texture);
 
     uint32_t mipResolution = resolution;
     for (uint32_t mipLevel = 0; mipLevel < maxMipLevels; ++mipLevel) {
@@ -345,7 +351,7 @@ void Skybox::generatePrefilterMap(
         shader.setUniformFloat("roughness", roughness);
 
         // fit viewport to mipResolution
-        glViewport(0, 0, mipResolution, mipResolution);
+        GLStateCache::viewport(0, 0, mipResolution, mipResolution);
 
         // render prefilter result to mipmap
         for (uint32_t i = 0; i < 6; ++i) {
@@ -369,8 +375,8 @@ void Skybox::generatePrefilterMap(
     framebuffer.unbind();
 
     // restore OpenGL states
-    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    GLStateCache::viewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    GLStateCache::bindTexture(GL_TEXTURE_CUBE_MAP, 0);
 
     // set prefilteredMipLevels;
     _maxPrefilteredMipLevel = maxMipLevels - 1;
@@ -417,20 +423,20 @@ void Skybox::generateBrdfLutMap(
 
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glViewport(0, 0, resolution, resolution);
+    GLStateCache::viewport(0, 0, resolution, resolution);
 
     shader.use();
     shader.setUniformUint("numSamples", numSamples);
-    glBindVertexArray(emptyVao);
+    GLStateCache::bindVertexArray(emptyVao);
     glDrawArrays(GL_TRIANGLES, 0, 3);
-    glBindVertexArray(0);
+    GLStateCache::bindVertexArray(0);
 
     framebuffer.unbind();
 
-    glDeleteVertexArrays(1, &emptyVao);
+    GLStateCache::deleteVertexArrays(1, &emptyVao);
 
     // restore OpenGL states
-    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    GLStateCache::viewport(viewport[0], viewport[1], viewport[2], viewport[3]);
 }
 
 glm::mat4 Skybox::getProjection() {
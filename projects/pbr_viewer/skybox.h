@@ -20,11 +20,23 @@ public:
     float scaleIBLAmbient = 1.0f;
     float backgroundLod = 0.0f;
 
+    // the decoded equirectangular image
+    struct EquirectImage {
+        std::string path;
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+        std::shared_ptr<float> data;
+    };
+
 public:
     Skybox(
-        const std::string& equirectImagePath, const std::string& equirectToCubemapVsFilepath,
+        const EquirectImage& equirectImage, const std::string& equirectToCubemapVsFilepath,
         const std::string& equirectToCubemapFsFilepath, const uint32_t resolution);
 
+    // read the image of the environment, it does not touch opengl and can run on any thread
+    static EquirectImage loadEquirectImage(const std::string& equirectImagePath);
+
     Skybox(Skybox&& rhs) noexcept;
 
     ~Skybox();
@@ -61,7 +73,7 @@ private:
     void createVertexResources();
 
     void equirectangulerToCubemap(
-        const std::string& equirectImagePath, const std::string& equirectToCubemapVsFilepath,
+        const EquirectImage& equirectImage, const std::string& equirectToCubemapVsFilepath,
         const std::string& equirectToCubemapFsFilepath, uint32_t resolution);
 
     void cleanup();
@@ -2,11 +2,7 @@
 
 layout(location = 0) in vec3 aPosition;
 
-layout(std140) uniform uboCamera {
-    mat4 projection;
-    mat4 view;
-    vec3 viewPosition;
-};
+#include "ubo_camera.glsl"
 
 out vec3 fWorldPos;
 
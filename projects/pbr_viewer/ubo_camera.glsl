@@ -0,0 +1,6 @@
+// camera uniform block shared by the pbr and skybox shaders
+layout(std140) uniform uboCamera {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPosition;
+};
\ No newline at end of file
@@ -14,7 +14,7 @@ Star::Star(const glm::vec2& position, float rotation, float radius, float aspect
     glGenVertexArrays(1, &_vao);
     glGenBuffers(1, &_vbo);
 
-    glBindVertexArray(_vao);
+    GLStateCache::bindVertexArray(_vao);
     glBindBuffer(GL_ARRAY_BUFFER, _vbo);
     glBufferData(
         GL_ARRAY_BUFFER, sizeof(glm::vec2) * _vertices.size(), _vertices.data(), GL_STATIC_DRAW);
@@ -22,7 +22,7 @@ Star::Star(const glm::vec2& position, float rotation, float radius, float aspect
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
     glEnableVertexAttribArray(0);
 
-    glBindVertexArray(0);
+    GLStateCache::bindVertexArray(0);
 }
 
 Star::Star(Star&& rhs) noexcept
@@ -34,17 +34,17 @@ Star::Star(Star&& rhs) noexcept
 
 Star::~Star() {
     if (_vbo) {
-        glDeleteVertexArrays(1, &_vbo);
+        GLStateCache::deleteVertexArrays(1, &_vbo);
         _vbo = 0;
     }
 
     if (_vao) {
-        glDeleteVertexArrays(1, &_vao);
+        GLStateCache::deleteVertexArrays(1, &_vao);
         _vao = 0;
     }
 }
 
 void Star::draw() const {
-    glBindVertexArray(_vao);
+    GLStateCache::bindVertexArray(_vao);
     glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(_vertices.size()));
 }
\ No newline at end of file
@@ -11,7 +11,7 @@ Bunny::Bunny(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& i
     // create a element array buffer
     glGenBuffers(1, &_ebo);
 
-    glBindVertexArray(_vao);
+    GLStateCache::bindVertexArray(_vao);
     glBindBuffer(GL_ARRAY_BUFFER, _vbo);
     glBufferData(
         GL_ARRAY_BUFFER, sizeof(Vertex) * _vertices.size(), _vertices.data(), GL_STATIC_DRAW);
@@ -32,7 +32,7 @@ Bunny::Bunny(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& i
     // glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex,
     // texCoord)); glEnableVertexAttribArray(2);
 
-    glBindVertexArray(0);
+    GLStateCache::bindVertexArray(0);
 }
 
 Bunny::~Bunny() {
@@ -47,7 +47,7 @@ Bunny::~Bunny() {
     }
 
     if (_vao != 0) {
-        glDeleteVertexArrays(1, &_vao);
+        GLStateCache::deleteVertexArrays(1, &_vao);
         _vao = 0;
     }
 }
@@ -66,7 +66,7 @@ Bunny::Bunny(Bunny&& rhs) noexcept {
 }
 
 void Bunny::draw() {
-    glBindVertexArray(_vao);
+    GLStateCache::bindVertexArray(_vao);
     glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(_indices.size()), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    GLStateCache::bindVertexArray(0);
 }
\ No newline at end of file
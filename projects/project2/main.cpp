@@ -2,6 +2,8 @@
 #include <cstdio>
 #include <iostream>
 
+#include "../base/command_line.h"
+
 Options getOptions(int argc, char* argv[]) {
     Options options;
     options.windowTitle = "Transformation";
@@ -14,6 +16,8 @@ Options getOptions(int argc, char* argv[]) {
     options.backgroundColor = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
     options.assetRootDir = "../../media/";
 
+    parseCommonOptions(CommandLine(argc, argv), options);
+
     return options;
 }
 
@@ -116,7 +116,7 @@ void Transformation::renderFrame() {
 
     glClearColor(_clearColor.r, _clearColor.g, _clearColor.b, _clearColor.a);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glEnable(GL_DEPTH_TEST);
+    GLStateCache::enable(GL_DEPTH_TEST);
 
     // projection matrix transform the homogenous coordinates
     // from view space to projection space, depending on following parameters:
@@ -128,7 +128,7 @@ void SceneRoaming::renderFrame() {
 
     glClearColor(_clearColor.r, _clearColor.g, _clearColor.b, _clearColor.a);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glEnable(GL_DEPTH_TEST);
+    GLStateCache::enable(GL_DEPTH_TEST);
 
     glm::mat4 projection = _cameras[activeCameraIndex]->getProjectionMatrix();
     glm::mat4 view = _cameras[activeCameraIndex]->getViewMatrix();
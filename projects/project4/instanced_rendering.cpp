@@ -1,18 +1,25 @@
+#include <cmath>
+
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 
 #include "instanced_rendering.h"
+#include "../base/frame_rate_panel.h"
 
 const std::string planetRelPath = "obj/sphere.obj";
 const std::string asternoidRelPath = "obj/rock.obj";
 
+// relative errors of the asternoid lod chain
+const std::vector<float> lodErrorTargets = {0.01f, 0.03f, 0.08f};
+
 InstancedRendering::InstancedRendering(const Options& options) : Application(options) {
     // import models
     _planet.reset(new Model(getAssetFullPath(planetRelPath)));
     _planet->transform.scale = glm::vec3(10.0f, 10.0f, 10.0f);
 
     _asternoid.reset(new Model(getAssetFullPath(asternoidRelPath)));
+    _asternoid->generateLods(lodErrorTargets);
 
     // init camera
     _camera.reset(new PerspectiveCamera(
@@ -164,7 +171,7 @@ void InstancedRendering::handleInput() {
 void InstancedRendering::renderFrame() {
     glClearColor(_clearColor.r, _clearColor.g, _clearColor.b, _clearColor.a);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glEnable(GL_DEPTH_TEST);
+    GLStateCache::enable(GL_DEPTH_TEST);
 
     if (_wireframe) {
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -185,15 +192,25 @@ void InstancedRendering::renderFrame() {
 
     // draw asternoids
     switch (_renderMode) {
-    case RenderMode::Ordinary:
+    case RenderMode::Ordinary: {
         _asternoidShader->use();
         _asternoidShader->setUniformMat4("view", view);
         _asternoidShader->setUniformMat4("projection", projection);
+
+        // pixels covered by a unit length at unit distance
+        const float projectionScale = 0.5f * _windowHeight / std::tan(0.5f * _camera->fovy);
         for (int i = 0; i < _amount; ++i) {
             _asternoidShader->setUniformMat4("model", _modelMatrices[i]);
-            _asternoid->draw();
+            if (_lodEnabled) {
+                _asternoid->drawLod(_asternoid->selectLod(
+                    _modelMatrices[i], _camera->transform.position, projectionScale,
+                    _lodErrorThreshold));
+            } else {
+                _asternoid->draw();
+            }
         }
         break;
+    }
     case RenderMode::Instanced:
         _asternoidInstancedShader->use();
         _asternoidInstancedShader->setUniformMat4("view", view);
@@ -224,13 +241,11 @@ void InstancedRendering::renderFrame() {
         ImGui::RadioButton("ordinary rendering", (int*)&_renderMode, (int)(RenderMode::Ordinary));
         ImGui::RadioButton("instanced rendering", (int*)&_renderMode, (int)(RenderMode::Instanced));
         ImGui::Checkbox("wireframe", &_wireframe);
+        ImGui::Checkbox("level of detail", &_lodEnabled);
+        ImGui::SliderFloat("lod error (px)", &_lodErrorThreshold, 0.5f, 8.0f);
         ImGui::NewLine();
 
-        std::string fpsInfo = "avg fps: " + std::to_string(_fpsIndicator.getAverageFrameRate());
-        ImGui::Text("%s", fpsInfo.c_str());
-        ImGui::PlotLines(
-            "", _fpsIndicator.getDataPtr(), _fpsIndicator.getSize(), 0, nullptr, 0.0f,
-            std::numeric_limits<float>::max(), ImVec2(240.0f, 50.0f));
+        drawFrameRatePanel(_fpsIndicator);
 
         ImGui::End();
     }
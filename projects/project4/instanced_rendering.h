@@ -40,6 +40,9 @@ private:
 
     bool _wireframe = false;
 
+    bool _lodEnabled = false;
+    float _lodErrorThreshold = 1.0f;
+
     void initShaders();
 
     void handleInput() override;
@@ -17,6 +17,7 @@ TextureMapping::TextureMapping(const Options& options) : Application(options) {
     // init model
     _sphere.reset(new Model(getAssetFullPath(modelRelPath)));
     _sphere->transform.scale = glm::vec3(3.0f, 3.0f, 3.0f);
+    _previousSphereTransform = _sphere->transform;
 
     // init textures
     std::shared_ptr<Texture2D> earthTexture =
@@ -217,9 +218,13 @@ void TextureMapping::handleInput() {
         glfwSetWindowShouldClose(_window, true);
         return;
     }
+}
+
+void TextureMapping::updateSimulation(float dt) {
+    _previousSphereTransform = _sphere->transform;
 
     const float angluarVelocity = 0.1f;
-    const float angle = angluarVelocity * static_cast<float>(_deltaTime);
+    const float angle = angluarVelocity * dt;
     const glm::vec3 axis = glm::vec3(0.0f, 1.0f, 0.0f);
     _sphere->transform.rotation = glm::angleAxis(angle, axis) * _sphere->transform.rotation;
 }
@@ -233,7 +238,7 @@ void TextureMapping::renderFrame() {
 
     glClearColor(_clearColor.r, _clearColor.g, _clearColor.b, _clearColor.a);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glEnable(GL_DEPTH_TEST);
+    GLStateCache::enable(GL_DEPTH_TEST);
 
     if (wireframe) {
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -243,6 +248,9 @@ void TextureMapping::renderFrame() {
 
     const glm::mat4 projection = _camera->getProjectionMatrix();
     const glm::mat4 view = _camera->getViewMatrix();
+    const glm::mat4 model =
+        Transform::interpolate(_previousSphereTransform, _sphere->transform, _interpolationAlpha)
+            .getLocalMatrix();
 
     // draw planet
     switch (_renderMode) {
@@ -252,7 +260,7 @@ void TextureMapping::renderFrame() {
         // 2. transfer mvp matrices to gpu
         _simpleShader->setUniformMat4("projection", projection);
         _simpleShader->setUniformMat4("view", view);
-        _simpleShader->setUniformMat4("model", _sphere->transform.getLocalMatrix());
+        _simpleShader->setUniformMat4("model", model);
         // 3. enable textures and transform textures to gpu
         _simpleMaterial->mapKd->bind();
         break;
@@ -262,7 +270,7 @@ void TextureMapping::renderFrame() {
         // 2. transfer mvp matrices to gpu
         _blendShader->setUniformMat4("projection", projection);
         _blendShader->setUniformMat4("view", view);
-        _blendShader->setUniformMat4("model", _sphere->transform.getLocalMatrix());
+        _blendShader->setUniformMat4("model", model);
         // 3. transfer light attributes to gpu
         _blendShader->setUniformVec3("light.direction", _light->transform.getFront());
         _blendShader->setUniformVec3("light.color", _light->color);
@@ -286,7 +294,7 @@ void TextureMapping::renderFrame() {
         // 2. transfer mvp matrices to gpu
         _checkerShader->setUniformMat4("projection", projection);
         _checkerShader->setUniformMat4("view", view);
-        _checkerShader->setUniformMat4("model", _sphere->transform.getLocalMatrix());
+        _checkerShader->setUniformMat4("model", model);
         // 3. transfer material attributes to gpu
         _checkerShader->setUniformInt("material.repeat", _checkerMaterial->repeat);
         _checkerShader->setUniformVec3("material.colors[0]", _checkerMaterial->colors[0]);
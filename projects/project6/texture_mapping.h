@@ -40,6 +40,8 @@ public:
 
 private:
     std::unique_ptr<Model> _sphere;
+    // the sphere before the last simulation step, for the interpolation
+    Transform _previousSphereTransform;
 
     std::unique_ptr<SimpleMaterial> _simpleMaterial;
     std::unique_ptr<BlendMaterial> _blendMaterial;
@@ -64,5 +66,7 @@ private:
 
     void handleInput() override;
 
+    void updateSimulation(float dt) override;
+
     void renderFrame() override;
 };
\ No newline at end of file